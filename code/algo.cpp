@@ -1,5 +1,6 @@
 #include "algo.h"
 #include "edge.h"
+#include "trace.h"
 
 #include <algorithm>
 #include <cassert>
@@ -14,6 +15,7 @@ namespace
 	std::vector<Coord2D> reconstructPath(std::map<Coord2D, Coord2D> &cameFrom, Coord2D const &end);
 	float distanceBetween(Coord2D const &start, Coord2D const &end);
 	float aStarHeuristicCostEstimate(Coord2D const &start, Coord2D const &end);
+	bool edgeRemoved(std::set<RoadmapEdge> const *removedEdges, Coord2D const &first, Coord2D const &second);
 }
 
 namespace
@@ -53,10 +55,23 @@ float aStarHeuristicCostEstimate(Coord2D const &start, Coord2D const &end)
 	return std::sqrt(xDist * xDist + yDist * yDist);
 }
 
+bool edgeRemoved(std::set<RoadmapEdge> const *removedEdges, Coord2D const &first, Coord2D const &second)
+{
+	if (!removedEdges || removedEdges->empty()) {
+		return false;
+	}
+
+	RoadmapEdge key = first < second ? std::make_pair(first, second) : std::make_pair(second, first);
+
+	return removedEdges->find(key) != removedEdges->end();
+}
+
 }
 
 std::vector< Coord2DTemplate<float> > catmullRom(std::vector<Coord2D> const &waypoints, unsigned int steps)
 {
+	TRACE_SPAN("catmullRom");
+
 	std::vector< Coord2DTemplate<float> > pathPoints;
 
 	// from https://forum.libcinder.org/topic/creating-catmull-rom-spline-from-the-bspline-class
@@ -109,8 +124,12 @@ std::vector< Coord2DTemplate<float> > catmullRom(std::vector<Coord2D> const &way
 }
 
 std::vector<Coord2D> dijkstra(NeighboursMap const &neighbours,
-                              Coord2D const &startpoint, Coord2D const &endpoint)
+                              Coord2D const &startpoint, Coord2D const &endpoint,
+                              uint64_t *expanded,
+                              std::set<RoadmapEdge> const *removedEdges)
 {
+	TRACE_SPAN("dijkstra");
+
 	std::set<Coord2D> closedSet;
 	std::set<Coord2D> openSet;
 	std::map<Coord2D, Coord2D> cameFrom;
@@ -147,6 +166,10 @@ std::vector<Coord2D> dijkstra(NeighboursMap const &neighbours,
 		openSet.erase(current);
 		closedSet.insert(current);
 
+		if (expanded) {
+			(*expanded)++;
+		}
+
 		NeighboursMap::const_iterator neighboursIt = neighbours.find(current);
 
 		assert(neighboursIt != neighbours.end());
@@ -156,7 +179,7 @@ std::vector<Coord2D> dijkstra(NeighboursMap const &neighbours,
 		for (std::set<Coord2D>::const_iterator neighbourIt = currentNeighbours.begin(); neighbourIt != currentNeighbours.end(); neighbourIt++) {
 			Coord2D neighbour = *neighbourIt;
 
-			if (closedSet.find(neighbour) != closedSet.end()) {
+			if (closedSet.find(neighbour) != closedSet.end() || edgeRemoved(removedEdges, current, neighbour)) {
 				continue;
 			}
 
@@ -178,8 +201,12 @@ std::vector<Coord2D> dijkstra(NeighboursMap const &neighbours,
 }
 
 std::vector<Coord2D> astar(NeighboursMap const &neighbours,
-                           Coord2D const &startpoint, Coord2D const &endpoint)
+                           Coord2D const &startpoint, Coord2D const &endpoint,
+                           uint64_t *expanded,
+                           std::set<RoadmapEdge> const *removedEdges)
 {
+	TRACE_SPAN("astar");
+
 	std::set<Coord2D> closedSet;
 	std::set<Coord2D> openSet;
 	std::map<Coord2D, Coord2D> cameFrom;
@@ -218,6 +245,10 @@ std::vector<Coord2D> astar(NeighboursMap const &neighbours,
 		openSet.erase(current);
 		closedSet.insert(current);
 
+		if (expanded) {
+			(*expanded)++;
+		}
+
 		NeighboursMap::const_iterator neighboursIt = neighbours.find(current);
 
 		assert(neighboursIt != neighbours.end());
@@ -227,7 +258,7 @@ std::vector<Coord2D> astar(NeighboursMap const &neighbours,
 		for (std::set<Coord2D>::const_iterator neighbourIt = currentNeighbours.begin(); neighbourIt != currentNeighbours.end(); neighbourIt++) {
 			Coord2D neighbour = *neighbourIt;
 
-			if (closedSet.find(neighbour) != closedSet.end()) {
+			if (closedSet.find(neighbour) != closedSet.end() || edgeRemoved(removedEdges, current, neighbour)) {
 				continue;
 			}
 
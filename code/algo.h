@@ -4,16 +4,25 @@
 #include "coord.h"
 #include "neighbours.h"
 
+#include <set>
 #include <vector>
 
+#include <stdint.h>
+
 class Edge;
 
 std::vector< Coord2DTemplate<float> > catmullRom(std::vector<Coord2D> const &waypoints, unsigned int steps);
 
+// expanded, if given, is increased by the number of nodes taken from the open set,
+// removedEdges, if given, are left out of neighbours
 std::vector<Coord2D> dijkstra(NeighboursMap const &neighbours,
-                              Coord2D const &startpoint, Coord2D const &endpoint);
+                              Coord2D const &startpoint, Coord2D const &endpoint,
+                              uint64_t *expanded = 0,
+                              std::set<RoadmapEdge> const *removedEdges = 0);
 
 std::vector<Coord2D> astar(NeighboursMap const &neighbours,
-                           Coord2D const &startpoint, Coord2D const &endpoint);
+                           Coord2D const &startpoint, Coord2D const &endpoint,
+                           uint64_t *expanded = 0,
+                           std::set<RoadmapEdge> const *removedEdges = 0);
 
 #endif // ROB_ALGO_H_INCLUDED
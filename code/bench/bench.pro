@@ -0,0 +1,16 @@
+# all benchmarks, every one prints one line of JSON per measurement;
+# run.sh builds and runs them with fixed seeds
+TEMPLATE = subdirs
+SUBDIRS += classify \
+           image \
+           planning \
+           render \
+           scenario \
+           wallsegments
+
+classify.file = classify_bench.pro
+image.file = image_bench.pro
+planning.file = planning_bench.pro
+render.file = render_bench.pro
+scenario.file = scenario_bench.pro
+wallsegments.file = wallsegments_bench.pro
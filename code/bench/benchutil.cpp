@@ -0,0 +1,110 @@
+#include "benchutil.h"
+
+#include <QtCore/QElapsedTimer>
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+Measurement::Measurement()
+{
+}
+
+void Measurement::add(qint64 nsecs)
+{
+	samples_.push_back(nsecs);
+}
+
+unsigned int Measurement::runs() const
+{
+	return samples_.size();
+}
+
+qint64 Measurement::min() const
+{
+	return samples_.empty() ? 0 : *std::min_element(samples_.begin(), samples_.end());
+}
+
+qint64 Measurement::avg() const
+{
+	qint64 total = 0;
+
+	for (std::vector<qint64>::const_iterator it = samples_.begin(); it != samples_.end(); ++it) {
+		total += *it;
+	}
+
+	return samples_.empty() ? 0 : total / static_cast<qint64>(samples_.size());
+}
+
+qint64 Measurement::median() const
+{
+	if (samples_.empty()) {
+		return 0;
+	}
+
+	std::vector<qint64> sorted(samples_);
+	std::sort(sorted.begin(), sorted.end());
+
+	return sorted[sorted.size() / 2];
+}
+
+Measurement measure(unsigned int runs, boost::function<void ()> const &work)
+{
+	Measurement measurement;
+
+	work();
+
+	for (unsigned int i = 0; i < runs; i++) {
+		QElapsedTimer timer;
+
+		timer.start();
+		work();
+		measurement.add(timer.nsecsElapsed());
+	}
+
+	return measurement;
+}
+
+BenchResult::BenchResult(std::string const &benchmark)
+{
+	field("benchmark", benchmark);
+}
+
+BenchResult &BenchResult::field(std::string const &name, long long value)
+{
+	std::ostringstream stream;
+
+	stream << value;
+	fields_ += (fields_.empty() ? "\"" : ",\"") + name + "\":" + stream.str();
+
+	return *this;
+}
+
+BenchResult &BenchResult::field(std::string const &name, double value, int precision)
+{
+	std::ostringstream stream;
+
+	stream << std::fixed << std::setprecision(precision) << value;
+	fields_ += (fields_.empty() ? "\"" : ",\"") + name + "\":" + stream.str();
+
+	return *this;
+}
+
+// the values are file and benchmark names, which need no escaping
+BenchResult &BenchResult::field(std::string const &name, std::string const &value)
+{
+	fields_ += (fields_.empty() ? "\"" : ",\"") + name + "\":\"" + value + "\"";
+
+	return *this;
+}
+
+void BenchResult::print(Measurement const &measurement) const
+{
+	std::printf("{%s,\"runs\":%u,\"min_ns\":%lld,\"median_ns\":%lld,\"avg_ns\":%lld}\n",
+	            fields_.c_str(), measurement.runs(),
+	            static_cast<long long>(measurement.min()),
+	            static_cast<long long>(measurement.median()),
+	            static_cast<long long>(measurement.avg()));
+	std::fflush(stdout);
+}
@@ -0,0 +1,48 @@
+#ifndef ROB_BENCHUTIL_H_INCLUDED
+#define ROB_BENCHUTIL_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+#include <boost/function.hpp>
+
+#include <QtCore/QtGlobal>
+
+// all runs of one benchmark in nanoseconds
+class Measurement
+{
+public:
+	Measurement();
+
+	void add(qint64 nsecs);
+
+	unsigned int runs() const;
+	qint64 min() const;
+	qint64 avg() const;
+	qint64 median() const;
+
+private:
+	std::vector<qint64> samples_;
+};
+
+// one warm-up run, which isn't counted, then runs measured ones
+Measurement measure(unsigned int runs, boost::function<void ()> const &work);
+
+// one line of JSON per benchmark, so the output of two versions can be diffed line by line;
+// the fields are printed in the order they were added
+class BenchResult
+{
+public:
+	BenchResult(std::string const &benchmark);
+
+	BenchResult &field(std::string const &name, long long value);
+	BenchResult &field(std::string const &name, std::string const &value);
+	// with precision digits after the point
+	BenchResult &field(std::string const &name, double value, int precision);
+	void print(Measurement const &measurement) const;
+
+private:
+	std::string fields_;
+};
+
+#endif // ROB_BENCHUTIL_H_INCLUDED
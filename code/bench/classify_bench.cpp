@@ -0,0 +1,91 @@
+#include "classify.h"
+
+#include <QtCore/QElapsedTimer>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	unsigned char randomChannel();
+
+	// mostly the exact class colours, plus values one off them to catch partial matches
+	unsigned char randomChannel()
+	{
+		static unsigned char const channels[] = { 0, 1, 199, 200, 201, 254, 255, 0, 200, 255 };
+
+		if (std::rand() % 8 == 0) {
+			return static_cast<unsigned char>(std::rand() % 256);
+		}
+
+		return channels[std::rand() % (sizeof channels / sizeof *channels)];
+	}
+
+	std::vector<unsigned char> createPixels(std::size_t count, std::size_t stride);
+
+	std::vector<unsigned char> createPixels(std::size_t count, std::size_t stride)
+	{
+		std::vector<unsigned char> bytes(count * stride);
+
+		for (std::size_t i = 0; i < count; i++) {
+			// whole pixels of one colour, so the three channel compares matter
+			unsigned char value = randomChannel();
+
+			for (std::size_t j = 0; j < stride; j++) {
+				bytes[i * stride + j] = std::rand() % 4 == 0 ? randomChannel() : value;
+			}
+		}
+
+		return bytes;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int const seed = argc > 1 ? std::atoi(argv[1]) : 1;
+	// odd, so the scalar tail after the vector loop is used too
+	std::size_t const pixels = 4096 * 4096 + 13;
+	int result = 0;
+
+	std::srand(seed);
+
+	for (std::size_t stride = 3; stride <= 4; stride++) {
+		std::vector<unsigned char> bytes = createPixels(pixels, stride);
+		std::vector<unsigned char> scalarClasses(pixels);
+		std::vector<unsigned char> vectorClasses(pixels);
+		QElapsedTimer timer;
+
+		timer.start();
+
+		classifyPixelsScalar(&bytes[0], stride, pixels, &scalarClasses[0]);
+
+		qint64 scalarTime = timer.nsecsElapsed();
+
+		timer.restart();
+
+		classifyPixels(&bytes[0], stride, pixels, &vectorClasses[0]);
+
+		qint64 vectorTime = timer.nsecsElapsed();
+
+		std::size_t mismatches = 0;
+
+		for (std::size_t i = 0; i < pixels; i++) {
+			if (scalarClasses[i] != vectorClasses[i]) {
+				mismatches++;
+			}
+		}
+
+		std::printf("{\"benchmark\":\"classify\",\"seed\":%u,\"stride\":%lu,\"pixels\":%lu,"
+		            "\"scalar_ns\":%lld,\"dispatched_ns\":%lld,\"mismatches\":%lu}\n",
+		            seed, static_cast<unsigned long>(stride), static_cast<unsigned long>(pixels),
+		            static_cast<long long>(scalarTime), static_cast<long long>(vectorTime),
+		            static_cast<unsigned long>(mismatches));
+
+		if (mismatches != 0) {
+			result = 1;
+		}
+	}
+
+	return result;
+}
@@ -0,0 +1,14 @@
+TEMPLATE = app
+TARGET = classify_bench
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+
+# Input
+HEADERS += classify.h \
+           cpu.h
+SOURCES += classify.cpp \
+           classify_bench.cpp \
+           cpu.cpp
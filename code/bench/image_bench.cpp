@@ -0,0 +1,53 @@
+#include "image.h"
+
+#include <QtCore/QElapsedTimer>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+// decodes the given plan a few times, pass a large generated plan (e.g. 16384x16384)
+// to measure the startup cost of big rooms
+int main(int argc, char **argv)
+{
+	std::string const filename = argc > 1 ? argv[1] : "../Room.png";
+	unsigned int const runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+	qint64 minTime = 0;
+	qint64 totalTime = 0;
+	unsigned long bytes = 0;
+	unsigned int width = 0;
+	unsigned int height = 0;
+
+	for (unsigned int i = 0; i < runs; i++) {
+		QElapsedTimer timer;
+
+		timer.start();
+
+		Image image(filename);
+
+		qint64 time = timer.nsecsElapsed();
+
+		if (i == 0 || time < minTime) {
+			minTime = time;
+		}
+
+		totalTime += time;
+		bytes = image.data().size();
+		width = image.width();
+		height = image.height();
+	}
+
+#ifdef ROB_USE_LIBPNG
+	char const *decoder = "libpng";
+#else
+	char const *decoder = "devil";
+#endif
+
+	std::printf("{\"benchmark\":\"image\",\"decoder\":\"%s\",\"file\":\"%s\",\"width\":%u,\"height\":%u,"
+	            "\"bytes\":%lu,\"runs\":%u,\"min_ns\":%lld,\"avg_ns\":%lld}\n",
+	            decoder, filename.c_str(), width, height, bytes, runs,
+	            static_cast<long long>(minTime), static_cast<long long>(runs ? totalTime / runs : 0));
+
+	return 0;
+}
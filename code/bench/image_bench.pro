@@ -0,0 +1,21 @@
+TEMPLATE = app
+TARGET = image_bench
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+
+libpng {
+	DEFINES += ROB_USE_LIBPNG
+	LIBS += -lpng
+} else {
+	LIBS += -lIL -lILU
+	HEADERS += il.h
+	SOURCES += il.cpp
+}
+
+# Input
+HEADERS += image.h
+SOURCES += image.cpp \
+           image_bench.cpp
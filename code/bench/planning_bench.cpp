@@ -0,0 +1,396 @@
+#include "algo.h"
+#include "benchutil.h"
+#include "contraction.h"
+#include "regiongraph.h"
+#include "regionmap.h"
+#include "roadmap.h"
+#include "roomimage.h"
+#include "triangulation.h"
+#include "wallsegments.h"
+
+#include <boost/bind/bind.hpp>
+#include <boost/ref.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// microbenchmarks of the single steps of the planning pipeline, the results of every step
+// are printed next to the times, so a changed time can be told apart from a changed result
+namespace
+{
+	unsigned char const distance = 5;
+	unsigned int const nodeCounts[] = { 100, 1000, 5000 };
+	unsigned int const clusterSize = 256;
+
+	void classify(RoomImage *image);
+	void borderPolygons(RoomImage const *image, std::vector<Polygon2D> *borders, std::vector<Polygon2D> *doors);
+	std::vector< std::vector<Coord2D> > closedPolygons(std::vector<Polygon2D> const &polygons);
+	void buildTriangulation(std::vector< std::vector<Coord2D> > const &constraints, std::size_t *faces);
+	void intersectsEdges(ConstrainedDelaunayTriangulation const *triangulation, std::vector<Edge> const *edges,
+	                     std::size_t *intersecting);
+	void prefilteredIntersectsEdges(WallSegments const *walls, ConstrainedDelaunayTriangulation const *triangulation,
+	                                std::vector<Edge> const *edges, std::size_t *intersecting);
+	void neighbours(DelaunayTriangulation const *triangulation, NeighboursMap *result);
+	void search(bool useAStar, NeighboursMap const *neighbours, Coord2D start, Coord2D end,
+	            std::vector<Coord2D> *path, uint64_t *expanded);
+	void buildRegionGraph(NeighboursMap const *neighbours, RegionMap const *regions, std::size_t *boundaryNodes);
+	void regionSearch(RegionGraph const *graph, Coord2D start, Coord2D end,
+	                  std::vector<Coord2D> *path, uint64_t *expanded);
+	void coldClusterSearch(NeighboursMap const *neighbours, Coord2D start, Coord2D end,
+	                       std::vector<Coord2D> *path, std::size_t *computedRegions);
+	void buildContraction(CompactRoadmap const *roadmap, std::size_t *shortcuts, std::size_t *bytes);
+	void contractionSearch(ContractionHierarchy const *hierarchy, Coord2D start, Coord2D end,
+	                       std::vector<Coord2D> *path, uint64_t *expanded);
+	void spline(std::vector<Coord2D> const *waypoints, std::size_t *points);
+	double pathLength(std::vector<Coord2D> const &path);
+	std::vector<int> nodeRegions(CompactRoadmap const &roadmap, RegionMap const &regions);
+
+	void classify(RoomImage *image)
+	{
+		image->classify();
+	}
+
+	void borderPolygons(RoomImage const *image, std::vector<Polygon2D> *borders, std::vector<Polygon2D> *doors)
+	{
+		image->getBorderPolygons(distance, *borders, *doors);
+	}
+
+	// like Room::triangulate(), every polygon closed by its first point
+	std::vector< std::vector<Coord2D> > closedPolygons(std::vector<Polygon2D> const &polygons)
+	{
+		std::vector< std::vector<Coord2D> > constraints;
+
+		for (std::vector<Polygon2D>::const_iterator it = polygons.begin(); it != polygons.end(); ++it) {
+			std::vector<Coord2D> points(it->begin(), it->end());
+
+			points.push_back((*it)[0]);
+			constraints.push_back(points);
+		}
+
+		return constraints;
+	}
+
+	void buildTriangulation(std::vector< std::vector<Coord2D> > const &constraints, std::size_t *faces)
+	{
+		ConstrainedDelaunayTriangulation triangulation;
+
+		triangulation.insertConstraints(constraints);
+		*faces = triangulation.numberOfFaces();
+	}
+
+	// the same test as Room::intersectsEdges()
+	void intersectsEdges(ConstrainedDelaunayTriangulation const *triangulation, std::vector<Edge> const *edges,
+	                     std::size_t *intersecting)
+	{
+		*intersecting = 0;
+
+		for (std::vector<Edge>::const_iterator it = edges->begin(); it != edges->end(); ++it) {
+			if (!triangulation->segmentInDomain(it->start, it->end)) {
+				(*intersecting)++;
+			}
+		}
+	}
+
+	// the alternative with the full scan of all walls in front of the walk, its cost
+	// grows with the walls of the room instead of the faces along the edge
+	void prefilteredIntersectsEdges(WallSegments const *walls, ConstrainedDelaunayTriangulation const *triangulation,
+	                                std::vector<Edge> const *edges, std::size_t *intersecting)
+	{
+		*intersecting = 0;
+
+		for (std::vector<Edge>::const_iterator it = edges->begin(); it != edges->end(); ++it) {
+			if (walls->intersects(*it) && !triangulation->segmentInDomain(it->start, it->end)) {
+				(*intersecting)++;
+			}
+		}
+	}
+
+	void neighbours(DelaunayTriangulation const *triangulation, NeighboursMap *result)
+	{
+		*result = triangulation->getNeighbours();
+	}
+
+	void search(bool useAStar, NeighboursMap const *neighbours, Coord2D start, Coord2D end,
+	            std::vector<Coord2D> *path, uint64_t *expanded)
+	{
+		*expanded = 0;
+		*path = useAStar ? astar(*neighbours, start, end, expanded) : dijkstra(*neighbours, start, end, expanded);
+	}
+
+	void buildRegionGraph(NeighboursMap const *neighbours, RegionMap const *regions, std::size_t *boundaryNodes)
+	{
+		CompactRoadmap roadmap;
+
+		compactRoadmap(*neighbours, roadmap);
+		*boundaryNodes = RegionGraph(roadmap, nodeRegions(roadmap, *regions)).boundaryNodes();
+	}
+
+	void regionSearch(RegionGraph const *graph, Coord2D start, Coord2D end,
+	                  std::vector<Coord2D> *path, uint64_t *expanded)
+	{
+		*expanded = 0;
+		*path = graph->findPath(start, end, expanded);
+	}
+
+	// a lazy graph only computes the clusters the query reaches
+	void coldClusterSearch(NeighboursMap const *neighbours, Coord2D start, Coord2D end,
+	                       std::vector<Coord2D> *path, std::size_t *computedRegions)
+	{
+		CompactRoadmap roadmap;
+
+		compactRoadmap(*neighbours, roadmap);
+
+		RegionGraph graph(roadmap, clusterRegions(roadmap, clusterSize), true);
+
+		*path = graph.findPath(start, end);
+		*computedRegions = graph.computedRegions();
+	}
+
+	void buildContraction(CompactRoadmap const *roadmap, std::size_t *shortcuts, std::size_t *bytes)
+	{
+		ContractionHierarchy hierarchy(*roadmap);
+
+		*shortcuts = hierarchy.shortcuts();
+		*bytes = hierarchy.memoryUsage();
+	}
+
+	void contractionSearch(ContractionHierarchy const *hierarchy, Coord2D start, Coord2D end,
+	                       std::vector<Coord2D> *path, uint64_t *expanded)
+	{
+		*expanded = 0;
+		*path = hierarchy->findPath(start, end, expanded);
+	}
+
+	void spline(std::vector<Coord2D> const *waypoints, std::size_t *points)
+	{
+		*points = catmullRom(*waypoints, 150).size();
+	}
+
+	// equal lengths tell that two searches found equally short paths, even if not the same one
+	double pathLength(std::vector<Coord2D> const &path)
+	{
+		double length = 0;
+
+		for (std::size_t i = 0; i + 1 < path.size(); i++) {
+			double dx = static_cast<double>(path[i + 1].x) - path[i].x;
+			double dy = static_cast<double>(path[i + 1].y) - path[i].y;
+
+			length += std::sqrt(dx * dx + dy * dy);
+		}
+
+		return length;
+	}
+
+	// like Room::runPlanningJob()
+	std::vector<int> nodeRegions(CompactRoadmap const &roadmap, RegionMap const &regions)
+	{
+		std::vector<int> result(roadmap.nodes.size());
+
+		for (std::size_t i = 0; i < roadmap.nodes.size(); i++) {
+			result[i] = regions.region(roadmap.nodes[i]);
+		}
+
+		return result;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int const seed = argc > 1 ? std::atoi(argv[1]) : 1;
+	unsigned int const runs = argc > 2 ? std::atoi(argv[2]) : 5;
+	std::string const filename = argc > 3 ? argv[3] : "../Room.png";
+
+	RoomImage image(filename);
+	Measurement measurement = measure(runs, boost::bind(classify, &image));
+
+	BenchResult("classify").field("file", filename).field("width", image.width())
+		.field("height", image.height()).print(measurement);
+
+	std::vector<Polygon2D> borders;
+	std::vector<Polygon2D> doors;
+
+	measurement = measure(runs, boost::bind(borderPolygons, &image, &borders, &doors));
+
+	BenchResult("getBorderPolygons").field("file", filename).field("distance", distance)
+		.field("polygons", borders.size()).field("doors", doors.size()).print(measurement);
+
+	RegionMap regions;
+
+	measurement = measure(runs, boost::bind(&RegionMap::build, &regions, boost::cref(image)));
+
+	BenchResult("RegionMap::build").field("file", filename).field("regions", regions.regions()).print(measurement);
+
+	std::vector< std::vector<Coord2D> > constraints = closedPolygons(borders);
+	std::size_t faces = 0;
+
+	measurement = measure(runs, boost::bind(buildTriangulation, boost::cref(constraints), &faces));
+
+	BenchResult("cdt_build").field("file", filename).field("faces", faces).print(measurement);
+
+	ConstrainedDelaunayTriangulation roomTriangulation;
+	WallSegments walls;
+
+	roomTriangulation.insertConstraints(constraints);
+
+	for (std::vector< std::vector<Coord2D> >::const_iterator it = constraints.begin(); it != constraints.end(); ++it) {
+		std::vector<Edge> polygonEdges;
+
+		for (std::size_t i = 0; i + 1 < it->size(); i++) {
+			polygonEdges.push_back(Edge((*it)[i], (*it)[i + 1]));
+		}
+
+		walls.addPolygon(polygonEdges);
+	}
+
+	// short edges between points inside the room, as between neighbouring waypoints
+	std::srand(seed);
+
+	std::vector<Edge> edges;
+
+	while (edges.size() < 20000) {
+		Coord2D start(std::rand() % image.width(), std::rand() % image.height());
+		Coord2D end(std::min(image.width() - 1, start.x + std::rand() % 64),
+		            std::min(image.height() - 1, start.y + std::rand() % 64));
+
+		if (roomTriangulation.inDomain(start.x, start.y) && roomTriangulation.inDomain(end.x, end.y)) {
+			edges.push_back(Edge(start, end));
+		}
+	}
+
+	std::size_t intersecting = 0;
+
+	measurement = measure(runs, boost::bind(intersectsEdges, &roomTriangulation, &edges, &intersecting));
+
+	BenchResult("intersectsEdges").field("seed", seed).field("edges", edges.size())
+		.field("intersecting", intersecting).print(measurement);
+
+	measurement = measure(runs, boost::bind(prefilteredIntersectsEdges, &walls, &roomTriangulation, &edges,
+	                                        &intersecting));
+
+	BenchResult("intersectsEdges_prefiltered").field("seed", seed).field("edges", edges.size())
+		.field("walls", walls.size()).field("intersecting", intersecting).print(measurement);
+
+	for (std::size_t i = 0; i < sizeof nodeCounts / sizeof *nodeCounts; i++) {
+		unsigned int const nodes = nodeCounts[i];
+		std::vector<Coord2D> coords;
+
+		std::srand(seed);
+
+		for (unsigned int j = 0; j < nodes; j++) {
+			coords.push_back(Coord2D(std::rand() % image.width(), std::rand() % image.height()));
+		}
+
+		DelaunayTriangulation triangulation;
+		triangulation.insert(coords);
+
+		NeighboursMap roadmap;
+
+		measurement = measure(runs, boost::bind(neighbours, &triangulation, &roadmap));
+
+		std::size_t roadmapEdges = 0;
+
+		for (NeighboursMap::const_iterator it = roadmap.begin(); it != roadmap.end(); ++it) {
+			roadmapEdges += it->second.size();
+		}
+
+		BenchResult("getNeighbours").field("seed", seed).field("nodes", roadmap.size())
+			.field("edges", roadmapEdges / 2).print(measurement);
+
+		// from corner to corner, so the search has to cross the whole roadmap
+		Coord2D start = roadmap.begin()->first;
+		Coord2D end = roadmap.rbegin()->first;
+
+		qint64 dijkstraTime = 0;
+
+		for (int useAStar = 0; useAStar < 2; useAStar++) {
+			std::vector<Coord2D> path;
+			uint64_t expanded = 0;
+
+			measurement = measure(runs, boost::bind(search, useAStar != 0, &roadmap, start, end, &path, &expanded));
+
+			if (!useAStar) {
+				dijkstraTime = measurement.median();
+			}
+
+			BenchResult(useAStar ? "astar" : "dijkstra").field("seed", seed).field("nodes", roadmap.size())
+				.field("path", path.size()).field("length", pathLength(path), 2)
+				.field("expanded", expanded).print(measurement);
+		}
+
+		std::size_t boundaryNodes = 0;
+
+		measurement = measure(runs, boost::bind(buildRegionGraph, &roadmap, &regions, &boundaryNodes));
+
+		BenchResult("door_graph_build").field("seed", seed).field("nodes", roadmap.size())
+			.field("portals", boundaryNodes).print(measurement);
+
+		CompactRoadmap compact;
+		compactRoadmap(roadmap, compact);
+
+		RegionGraph graph(compact, nodeRegions(compact, regions));
+		std::vector<Coord2D> path;
+		uint64_t expanded = 0;
+
+		measurement = measure(runs, boost::bind(regionSearch, &graph, start, end, &path, &expanded));
+
+		BenchResult("door_graph").field("seed", seed).field("nodes", roadmap.size())
+			.field("path", path.size()).field("length", pathLength(path), 2)
+			.field("expanded", expanded).print(measurement);
+
+		std::size_t computedRegions = 0;
+
+		measurement = measure(runs, boost::bind(coldClusterSearch, &roadmap, start, end, &path, &computedRegions));
+
+		BenchResult("cluster_graph_cold").field("seed", seed).field("nodes", roadmap.size())
+			.field("cluster", clusterSize).field("path", path.size()).field("length", pathLength(path), 2)
+			.field("computed", computedRegions)
+			.print(measurement);
+
+		RegionGraph clusterGraph(compact, clusterRegions(compact, clusterSize), true);
+
+		measurement = measure(runs, boost::bind(regionSearch, &clusterGraph, start, end, &path, &expanded));
+
+		BenchResult("cluster_graph").field("seed", seed).field("nodes", roadmap.size())
+			.field("cluster", clusterSize).field("regions", clusterGraph.regions())
+			.field("path", path.size()).field("length", pathLength(path), 2)
+			.field("expanded", expanded).print(measurement);
+
+		std::size_t shortcuts = 0;
+		std::size_t bytes = 0;
+
+		measurement = measure(runs, boost::bind(buildContraction, &compact, &shortcuts, &bytes));
+
+		BenchResult("contraction_build").field("seed", seed).field("nodes", roadmap.size())
+			.field("shortcuts", shortcuts).field("bytes", bytes).print(measurement);
+
+		ContractionHierarchy hierarchy(compact);
+
+		measurement = measure(runs, boost::bind(contractionSearch, &hierarchy, start, end, &path, &expanded));
+
+		// the speedup is dijkstra_median_ns over median_ns, both for the same query
+		BenchResult("contraction").field("seed", seed).field("nodes", roadmap.size())
+			.field("path", path.size()).field("length", pathLength(path), 2)
+			.field("expanded", expanded)
+			.field("dijkstra_median_ns", dijkstraTime).print(measurement);
+	}
+
+	std::vector<Coord2D> waypoints;
+
+	std::srand(seed);
+
+	for (unsigned int i = 0; i < 200; i++) {
+		waypoints.push_back(Coord2D(std::rand() % image.width(), std::rand() % image.height()));
+	}
+
+	std::size_t points = 0;
+
+	measurement = measure(runs, boost::bind(spline, &waypoints, &points));
+
+	BenchResult("catmullRom").field("seed", seed).field("waypoints", waypoints.size())
+		.field("points", points).print(measurement);
+
+	return 0;
+}
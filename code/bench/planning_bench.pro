@@ -0,0 +1,60 @@
+TEMPLATE = app
+TARGET = planning_bench
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+LIBS += -lCGAL -lgmp -lboost_thread
+QMAKE_CXXFLAGS += -frounding-math
+
+libpng {
+	DEFINES += ROB_USE_LIBPNG
+	LIBS += -lpng
+} else {
+	LIBS += -lIL -lILU
+	HEADERS += il.h
+	SOURCES += il.cpp
+}
+
+# Input
+HEADERS += algo.h \
+           benchutil.h \
+           binarystream.h \
+           classify.h \
+           contraction.h \
+           coord.h \
+           cpu.h \
+           edge.h \
+           image.h \
+           neighbours.h \
+           parallel.h \
+           polygon.h \
+           regiongraph.h \
+           regionmap.h \
+           roadmap.h \
+           roomimage.h \
+           trace.h \
+           triangle.h \
+           triangulation.h \
+           wallsegments.h
+SOURCES += algo.cpp \
+           benchutil.cpp \
+           binarystream.cpp \
+           classify.cpp \
+           contraction.cpp \
+           coord.cpp \
+           cpu.cpp \
+           edge.cpp \
+           image.cpp \
+           parallel.cpp \
+           planning_bench.cpp \
+           polygon.cpp \
+           regiongraph.cpp \
+           regionmap.cpp \
+           roadmap.cpp \
+           roomimage.cpp \
+           trace.cpp \
+           triangle.cpp \
+           triangulation.cpp \
+           wallsegments.cpp
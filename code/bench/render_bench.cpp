@@ -0,0 +1,210 @@
+#define GL_GLEXT_PROTOTYPES
+
+#include "benchutil.h"
+#include "linebuffer.h"
+#include "triangle.h"
+#include "viewtransform.h"
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GL/gl.h>
+
+#include <boost/bind/bind.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// frame times of the triangulation layers, drawn offscreen without a display, e.g. with
+// Mesa's llvmpipe (LIBGL_ALWAYS_SOFTWARE=1); the room and the window have the size of Room.png
+namespace
+{
+	unsigned int const roomSize = 1024;
+	int const viewportWidth = 1024;
+	int const viewportHeight = 768;
+	unsigned int const triangleCounts[] = { 1000, 10000, 100000 };
+
+	bool makeContext();
+	std::vector<Triangle> createTriangles(unsigned int count);
+	void setTriangles(LineBuffer *lines, std::vector<Triangle> const *triangles);
+	void drawFrame(ViewTransform const *view, LineBuffer const *triangulation, LineBuffer const *roomTriangulation);
+
+	// a pbuffer of the surfaceless platform, the context stays current until the end
+	bool makeContext()
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+
+		if (!getPlatformDisplay) {
+			return false;
+		}
+
+		EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+		EGLint major;
+		EGLint minor;
+
+		if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+			return false;
+		}
+
+		EGLint const configAttributes[] = {
+			EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+			EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+			EGL_RED_SIZE, 8,
+			EGL_GREEN_SIZE, 8,
+			EGL_BLUE_SIZE, 8,
+			EGL_DEPTH_SIZE, 24,
+			EGL_NONE
+		};
+		EGLConfig config;
+		EGLint configs = 0;
+
+		if (!eglChooseConfig(display, configAttributes, &config, 1, &configs) || configs == 0 || !eglBindAPI(EGL_OPENGL_API)) {
+			return false;
+		}
+
+		EGLint const surfaceAttributes[] = { EGL_WIDTH, viewportWidth, EGL_HEIGHT, viewportHeight, EGL_NONE };
+		EGLSurface surface = eglCreatePbufferSurface(display, config, surfaceAttributes);
+		EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, 0);
+
+		return surface != EGL_NO_SURFACE && context != EGL_NO_CONTEXT && eglMakeCurrent(display, surface, surface, context);
+	}
+
+	// two triangles per cell of a grid over the room, the inner corners moved a little
+	// like the nodes of a roadmap
+	std::vector<Triangle> createTriangles(unsigned int count)
+	{
+		unsigned int cells = 1;
+
+		while (2 * (cells + 1) * (cells + 1) <= count) {
+			cells++;
+		}
+
+		std::vector<Coord2D> corners;
+
+		for (unsigned int y = 0; y <= cells; y++) {
+			for (unsigned int x = 0; x <= cells; x++) {
+				bool inner = x > 0 && x < cells && y > 0 && y < cells;
+				unsigned int jitter = inner ? std::rand() % 2 : 0;
+
+				corners.push_back(Coord2D(x * (roomSize - 2) / cells + jitter, y * (roomSize - 2) / cells + jitter));
+			}
+		}
+
+		std::vector<Triangle> triangles;
+
+		for (unsigned int y = 0; y < cells; y++) {
+			for (unsigned int x = 0; x < cells; x++) {
+				Triangle first;
+				Triangle second;
+
+				first[0] = corners[y * (cells + 1) + x];
+				first[1] = corners[y * (cells + 1) + x + 1];
+				first[2] = corners[(y + 1) * (cells + 1) + x];
+				second[0] = first[1];
+				second[1] = corners[(y + 1) * (cells + 1) + x + 1];
+				second[2] = first[2];
+
+				triangles.push_back(first);
+				triangles.push_back(second);
+			}
+		}
+
+		return triangles;
+	}
+
+	void setTriangles(LineBuffer *lines, std::vector<Triangle> const *triangles)
+	{
+		lines->setTriangles(*triangles, roomSize);
+	}
+
+	// like Drawing::paint() with both triangulations shown, glFinish() waits for the rasterizer
+	void drawFrame(ViewTransform const *view, LineBuffer const *triangulation, LineBuffer const *roomTriangulation)
+	{
+		glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
+
+		view->apply();
+
+		if (triangulation) {
+			glTranslatef(0.0f, 0.0f, 0.2f);
+			glColor3f(0.5f, 0.8f, 1.0f);
+			glLineWidth(2.0f);
+			triangulation->draw();
+		}
+
+		if (roomTriangulation) {
+			glTranslatef(0.0f, 0.0f, 0.2f);
+			glColor3f(0.6f, 0.9f, 1.0f);
+			glLineWidth(2.0f);
+			roomTriangulation->draw();
+		}
+
+		glFinish();
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int const seed = argc > 1 ? std::atoi(argv[1]) : 1;
+	unsigned int const runs = argc > 2 ? std::atoi(argv[2]) : 5;
+
+	if (!makeContext()) {
+		std::fprintf(stderr, "no offscreen OpenGL context\n");
+		return EXIT_FAILURE;
+	}
+
+	std::string const renderer = reinterpret_cast<char const *>(glGetString(GL_RENDERER));
+
+	glViewport(0, 0, viewportWidth, viewportHeight);
+	glEnable(GL_DEPTH_TEST);
+
+	ViewTransform view;
+	view.setViewport(viewportWidth, viewportHeight);
+	view.setRoomSize(roomSize, roomSize);
+
+	std::srand(seed);
+
+	Measurement measurement = measure(runs, boost::bind(drawFrame, &view, static_cast<LineBuffer const *>(0),
+	                                                    static_cast<LineBuffer const *>(0)));
+
+	BenchResult("frame_empty").field("renderer", renderer).print(measurement);
+
+	for (std::size_t i = 0; i < sizeof triangleCounts / sizeof *triangleCounts; i++) {
+		std::vector<Triangle> triangles = createTriangles(triangleCounts[i]);
+		LineBuffer triangulation;
+		LineBuffer roomTriangulation;
+
+		// done on the GUI thread whenever the waypoints changed
+		measurement = measure(runs, boost::bind(setTriangles, &triangulation, &triangles));
+
+		BenchResult("line_buffer_set_triangles").field("seed", seed).field("triangles", triangles.size())
+			.print(measurement);
+
+		roomTriangulation.setTriangles(triangles, roomSize);
+
+		// the warm-up run uploads the buffers
+		measurement = measure(runs, boost::bind(drawFrame, &view, &triangulation, static_cast<LineBuffer const *>(0)));
+
+		BenchResult("frame_triangulation").field("seed", seed).field("triangles", triangles.size())
+			.field("renderer", renderer).print(measurement);
+
+		measurement = measure(runs, boost::bind(drawFrame, &view, &triangulation, &roomTriangulation));
+
+		BenchResult("frame_both_triangulations").field("seed", seed).field("triangles", triangles.size())
+			.field("renderer", renderer).print(measurement);
+
+		// the same vertices with only one pixel rasterized, the rest of the frame time is the rasterizer
+		glEnable(GL_SCISSOR_TEST);
+		glScissor(0, 0, 1, 1);
+
+		measurement = measure(runs, boost::bind(drawFrame, &view, &triangulation, static_cast<LineBuffer const *>(0)));
+
+		glDisable(GL_SCISSOR_TEST);
+
+		BenchResult("frame_triangulation_scissored").field("seed", seed).field("triangles", triangles.size())
+			.field("renderer", renderer).print(measurement);
+	}
+
+	return EXIT_SUCCESS;
+}
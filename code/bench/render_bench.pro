@@ -0,0 +1,24 @@
+TEMPLATE = app
+TARGET = render_bench
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+# an offscreen context of the surfaceless platform, there is no window
+LIBS += -lEGL -lGL -lGLU
+
+# Input
+HEADERS += benchutil.h \
+           coord.h \
+           gl.h \
+           linebuffer.h \
+           triangle.h \
+           viewtransform.h
+SOURCES += benchutil.cpp \
+           coord.cpp \
+           gl.cpp \
+           linebuffer.cpp \
+           render_bench.cpp \
+           triangle.cpp \
+           viewtransform.cpp
@@ -0,0 +1,25 @@
+#!/bin/sh
+# builds and runs all benchmarks with fixed seeds, the results go to stdout as JSON lines,
+# e.g. ./run.sh CONFIG+=libpng > before.json; the arguments are passed to qmake
+set -e
+
+cd "$(dirname "$0")"
+
+SEED=${SEED:-1}
+RUNS=${RUNS:-5}
+
+qmake "$@" bench.pro >&2
+make >&2
+(cd ../tools && qmake floorplan.pro && make) >&2
+
+# a generated plan far larger than Room.png, for the scaling of the preprocessing
+../tools/floorplan --size=4096 --rooms=200 --obstacles=400 --seed="$SEED" floorplan.png >&2
+
+./classify_bench "$SEED"
+./image_bench ../Room.png "$RUNS"
+./wallsegments_bench "$SEED"
+./planning_bench "$SEED" "$RUNS" ../Room.png
+./planning_bench "$SEED" "$RUNS" floorplan.png
+./scenario_bench "$SEED" "$RUNS" ..
+# software rendering, so the frame times don't depend on the graphics card
+LIBGL_ALWAYS_SOFTWARE=1 ./render_bench "$SEED" "$RUNS"
@@ -0,0 +1,229 @@
+#include "algo.h"
+#include "benchutil.h"
+#include "room.h"
+#include "stats.h"
+
+#include <boost/bind/bind.hpp>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QXmlStreamReader>
+#include <QtWidgets/QApplication>
+#include <QtWidgets/QTextEdit>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// end to end benchmarks of what the GUI does with a room: preprocessing with and without
+// the room cache, path planning with a fresh and a validated roadmap and opening projects
+namespace
+{
+	// the robot diameter of the drawing
+	unsigned char const distance = 5;
+	int const nodeCounts[] = { 100, 1000, 3000 };
+	// in the order of Room::Algorithm
+	char const *const algorithmNames[] = { "dijkstra", "astar", "door_graph", "cluster_graph", "contraction" };
+	char const *const projects[] = { "animation.xml", "pathCollision.xml", "neighbourCollision.xml", "moep.xml" };
+
+	// everything a room needs from the GUI
+	struct Scenario
+	{
+		Stats stats;
+		QTextEdit statusText;
+		QTextEdit helpText;
+		QString cacheDirectory;
+	};
+
+	void preprocess(Scenario *scenario, std::string const &filename, bool cold);
+	void generatePath(Room const *room, std::size_t *pathSize);
+	void smoothPath(Room const *room, std::vector<Coord2D> const *path, std::size_t *collisions);
+	bool findRoom(QXmlStreamReader &reader, QString &image);
+
+	void preprocess(Scenario *scenario, std::string const &filename, bool cold)
+	{
+		if (cold) {
+			QDir(scenario->cacheDirectory).removeRecursively();
+			QDir().mkpath(scenario->cacheDirectory);
+		}
+
+		Room room(filename, distance, &scenario->stats, &scenario->statusText, &scenario->helpText);
+
+		room.preprocess();
+	}
+
+	void generatePath(Room const *room, std::size_t *pathSize)
+	{
+		*pathSize = room->generatePath().size();
+	}
+
+	// what the planner does with a found path
+	void smoothPath(Room const *room, std::vector<Coord2D> const *path, std::size_t *collisions)
+	{
+		std::vector< Coord2DTemplate<float> > points = catmullRom(*path, 150);
+
+		*collisions = 0;
+
+		for (std::vector< Coord2DTemplate<float> >::const_iterator it = points.begin(); it != points.end(); ++it) {
+			if (!room->pointInside(it->x, it->y)) {
+				(*collisions)++;
+			}
+		}
+	}
+
+	// reads up to the room element of a project, image is the room image of the drawing
+	bool findRoom(QXmlStreamReader &reader, QString &image)
+	{
+		while (!reader.atEnd()) {
+			reader.readNext();
+
+			if (!reader.isStartElement()) {
+				continue;
+			}
+
+			if (reader.name().toString() == "image") {
+				image = reader.readElementText();
+			} else if (reader.name().toString() == "room") {
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	// no window is ever shown, the text edits only collect the status messages
+	qputenv("QT_QPA_PLATFORM", "offscreen");
+
+	// the room cache goes to a directory of its own, so cold runs really are cold
+	QTemporaryDir cacheHome;
+	qputenv("XDG_CACHE_HOME", QFile::encodeName(cacheHome.path()));
+
+	QApplication application(argc, argv);
+	QCoreApplication::setApplicationName("scenario_bench");
+
+	unsigned int const seed = argc > 1 ? std::atoi(argv[1]) : 1;
+	unsigned int const runs = argc > 2 ? std::atoi(argv[2]) : 5;
+	QDir const directory(argc > 3 ? argv[3] : "..");
+	std::string const filename = QFile::encodeName(directory.filePath("Room.png")).constData();
+
+	Scenario scenario;
+	scenario.cacheDirectory = cacheHome.path();
+
+	Measurement measurement = measure(runs, boost::bind(preprocess, &scenario, filename, true));
+
+	BenchResult("preprocess_cold").field("file", filename).print(measurement);
+
+	measurement = measure(runs, boost::bind(preprocess, &scenario, filename, false));
+
+	BenchResult("preprocess_warm").field("file", filename).print(measurement);
+
+	Room room(filename, distance, &scenario.stats, &scenario.statusText, &scenario.helpText);
+
+	room.preprocess();
+
+	for (std::size_t i = 0; i < sizeof nodeCounts / sizeof *nodeCounts; i++) {
+		for (int algorithm = Room::Dijkstra; algorithm <= Room::Contraction; algorithm++) {
+			char const *algorithmName = algorithmNames[algorithm];
+			std::size_t pathSize = 0;
+
+			room.setAlgorithm(static_cast<Room::Algorithm>(algorithm));
+
+			// every run gets the same waypoints again, which invalidates the validated roadmap
+			measurement = Measurement();
+
+			for (unsigned int run = 0; run <= runs; run++) {
+				room.clearWaypoints();
+				std::srand(seed);
+				room.setNodes(nodeCounts[i]);
+
+				QElapsedTimer timer;
+
+				timer.start();
+				generatePath(&room, &pathSize);
+
+				// the first run warms up
+				if (run != 0) {
+					measurement.add(timer.nsecsElapsed());
+				}
+			}
+
+			BenchResult("path_uncached").field("algorithm", algorithmName).field("seed", seed)
+				.field("nodes", nodeCounts[i]).field("path", pathSize).print(measurement);
+
+			measurement = measure(runs, boost::bind(generatePath, &room, &pathSize));
+
+			BenchResult("path_cached").field("algorithm", algorithmName).field("seed", seed)
+				.field("nodes", nodeCounts[i]).field("path", pathSize).print(measurement);
+
+			std::vector<Coord2D> path = room.generatePath();
+			std::size_t collisions = 0;
+
+			measurement = measure(runs, boost::bind(smoothPath, &room, &path, &collisions));
+
+			BenchResult("path_smoothing").field("algorithm", algorithmName).field("seed", seed)
+				.field("nodes", nodeCounts[i]).field("collisions", collisions).print(measurement);
+		}
+	}
+
+	for (std::size_t i = 0; i < sizeof projects / sizeof *projects; i++) {
+		QString const projectFilename = directory.filePath(projects[i]);
+		Measurement loadMeasurement;
+		Measurement pathMeasurement;
+		std::size_t waypoints = 0;
+		std::size_t pathSize = 0;
+		bool loaded = true;
+
+		for (unsigned int run = 0; run <= runs && loaded; run++) {
+			QFile file(projectFilename);
+			QXmlStreamReader reader(&file);
+			QString image;
+
+			if (!file.open(QIODevice::ReadOnly) || !findRoom(reader, image)) {
+				loaded = false;
+				break;
+			}
+
+			// images are relative to the project, like in the GUI started next to it
+			std::string const imageFilename =
+				QFile::encodeName(QFileInfo(projectFilename).dir().filePath(image)).constData();
+			Room projectRoom(imageFilename, distance, &scenario.stats, &scenario.statusText, &scenario.helpText);
+
+			projectRoom.preprocess();
+
+			QElapsedTimer timer;
+
+			timer.start();
+			loaded = projectRoom.loadProject(&reader);
+
+			qint64 loadTime = timer.nsecsElapsed();
+
+			timer.restart();
+			generatePath(&projectRoom, &pathSize);
+
+			if (run != 0) {
+				loadMeasurement.add(loadTime);
+				pathMeasurement.add(timer.nsecsElapsed());
+			}
+
+			waypoints = projectRoom.getWaypoints().size();
+		}
+
+		if (!loaded) {
+			std::fprintf(stderr, "Cannot load the project %s.\n", QFile::encodeName(projectFilename).constData());
+			continue;
+		}
+
+		BenchResult("project_load").field("file", projects[i]).field("waypoints", waypoints).print(loadMeasurement);
+		BenchResult("project_path").field("file", projects[i]).field("path", pathSize).print(pathMeasurement);
+	}
+
+	return 0;
+}
@@ -0,0 +1,68 @@
+TEMPLATE = app
+TARGET = scenario_bench
+QT += widgets
+CONFIG += console
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+LIBS += -lCGAL -lgmp -lboost_thread
+QMAKE_CXXFLAGS += -frounding-math
+
+libpng {
+	DEFINES += ROB_USE_LIBPNG
+	LIBS += -lpng
+} else {
+	LIBS += -lIL -lILU
+	HEADERS += il.h
+	SOURCES += il.cpp
+}
+
+# Input
+HEADERS += algo.h \
+           benchutil.h \
+           binarystream.h \
+           classify.h \
+           contraction.h \
+           coord.h \
+           cpu.h \
+           edge.h \
+           image.h \
+           neighbours.h \
+           parallel.h \
+           planningjob.h \
+           polygon.h \
+           regiongraph.h \
+           regionmap.h \
+           roadmap.h \
+           room.h \
+           roomcache.h \
+           roomimage.h \
+           stats.h \
+           trace.h \
+           triangle.h \
+           triangulation.h \
+           wallsegments.h
+SOURCES += algo.cpp \
+           benchutil.cpp \
+           binarystream.cpp \
+           classify.cpp \
+           contraction.cpp \
+           coord.cpp \
+           cpu.cpp \
+           edge.cpp \
+           image.cpp \
+           parallel.cpp \
+           planningjob.cpp \
+           polygon.cpp \
+           regiongraph.cpp \
+           regionmap.cpp \
+           roadmap.cpp \
+           room.cpp \
+           roomcache.cpp \
+           roomimage.cpp \
+           scenario_bench.cpp \
+           stats.cpp \
+           trace.cpp \
+           triangle.cpp \
+           triangulation.cpp \
+           wallsegments.cpp
@@ -0,0 +1,99 @@
+#include "wallsegments.h"
+
+#include <QtCore/QElapsedTimer>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	WallSegments createWalls(unsigned int polygons, unsigned int edgesPerPolygon, unsigned int size);
+
+	WallSegments createWalls(unsigned int polygons, unsigned int edgesPerPolygon, unsigned int size)
+	{
+		WallSegments walls;
+
+		for (unsigned int i = 0; i < polygons; i++) {
+			std::vector<Edge> polygon;
+			Coord2D first(std::rand() % size, std::rand() % size);
+			Coord2D last = first;
+
+			for (unsigned int j = 1; j < edgesPerPolygon; j++) {
+				Coord2D next(std::min(size - 1, last.x + std::rand() % 16),
+				             std::min(size - 1, last.y + std::rand() % 16));
+
+				// walls of the room maps are mostly axis aligned
+				if (j % 2 == 0) {
+					next.y = last.y;
+				} else {
+					next.x = last.x;
+				}
+
+				polygon.push_back(Edge(last, next));
+				last = next;
+			}
+
+			polygon.push_back(Edge(last, first));
+			walls.addPolygon(polygon);
+		}
+
+		return walls;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int const seed = argc > 1 ? std::atoi(argv[1]) : 1;
+	unsigned int const size = 4096;
+	unsigned int const queries = 20000;
+
+	std::srand(seed);
+
+	WallSegments walls = createWalls(500, 64, size);
+	std::vector<Edge> edges;
+
+	for (unsigned int i = 0; i < queries; i++) {
+		Coord2D start(std::rand() % size, std::rand() % size);
+		Coord2D end(std::min(size - 1, start.x + std::rand() % 64),
+		            std::min(size - 1, start.y + std::rand() % 64));
+
+		edges.push_back(Edge(start, end));
+	}
+
+	std::vector<bool> scalarResults;
+	std::vector<bool> vectorResults;
+	QElapsedTimer timer;
+
+	timer.start();
+
+	for (std::vector<Edge>::const_iterator it = edges.begin(); it != edges.end(); ++it) {
+		scalarResults.push_back(walls.intersectsScalar(*it));
+	}
+
+	qint64 scalarTime = timer.nsecsElapsed();
+
+	timer.restart();
+
+	for (std::vector<Edge>::const_iterator it = edges.begin(); it != edges.end(); ++it) {
+		vectorResults.push_back(walls.intersects(*it));
+	}
+
+	qint64 vectorTime = timer.nsecsElapsed();
+
+	std::size_t mismatches = 0;
+
+	for (std::size_t i = 0; i < edges.size(); i++) {
+		if (scalarResults[i] != vectorResults[i]) {
+			mismatches++;
+		}
+	}
+
+	std::printf("{\"benchmark\":\"wallsegments\",\"seed\":%u,\"walls\":%lu,\"queries\":%u,"
+	            "\"scalar_ns\":%lld,\"dispatched_ns\":%lld,\"mismatches\":%lu}\n",
+	            seed, static_cast<unsigned long>(walls.size()), queries,
+	            static_cast<long long>(scalarTime), static_cast<long long>(vectorTime),
+	            static_cast<unsigned long>(mismatches));
+
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,17 @@
+TEMPLATE = app
+TARGET = wallsegments_bench
+QT -= gui
+CONFIG += console
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+QMAKE_CXXFLAGS += -frounding-math
+
+# Input
+HEADERS += cpu.h \
+           edge.h \
+           wallsegments.h
+SOURCES += cpu.cpp \
+           edge.cpp \
+           wallsegments.cpp \
+           wallsegments_bench.cpp
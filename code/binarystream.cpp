@@ -0,0 +1,139 @@
+#include "binarystream.h"
+
+#include <cstring>
+
+BinaryWriter::BinaryWriter(std::vector<char> &buffer)
+	: buffer_(buffer)
+{
+}
+
+void BinaryWriter::writeBytes(void const *data, std::size_t size)
+{
+	char const *bytes = static_cast<char const *>(data);
+
+	buffer_.insert(buffer_.end(), bytes, bytes + size);
+}
+
+void BinaryWriter::writeU32(uint32_t value)
+{
+	for (int i = 0; i < 4; i++) {
+		buffer_.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+	}
+}
+
+void BinaryWriter::writeVarint(uint64_t value)
+{
+	while (value >= 0x80) {
+		buffer_.push_back(static_cast<char>((value & 0x7f) | 0x80));
+		value >>= 7;
+	}
+
+	buffer_.push_back(static_cast<char>(value));
+}
+
+void BinaryWriter::writeSignedVarint(int64_t value)
+{
+	uint64_t zigzag = (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+
+	writeVarint(zigzag);
+}
+
+void BinaryWriter::writeString(std::string const &value)
+{
+	writeVarint(value.size());
+	writeBytes(value.data(), value.size());
+}
+
+BinaryReader::BinaryReader(char const *data, std::size_t size)
+	: data_(data),
+	  size_(size),
+	  position_(0)
+{
+}
+
+bool BinaryReader::readBytes(void *data, std::size_t size)
+{
+	if (remaining() < size) {
+		return false;
+	}
+
+	std::memcpy(data, data_ + position_, size);
+	position_ += size;
+
+	return true;
+}
+
+bool BinaryReader::readU32(uint32_t &value)
+{
+	if (remaining() < 4) {
+		return false;
+	}
+
+	value = 0;
+
+	for (int i = 0; i < 4; i++) {
+		value |= static_cast<uint32_t>(static_cast<unsigned char>(data_[position_ + i])) << (8 * i);
+	}
+
+	position_ += 4;
+
+	return true;
+}
+
+bool BinaryReader::readVarint(uint64_t &value)
+{
+	value = 0;
+
+	// at most ten bytes for 64 bits
+	for (int shift = 0; shift < 64; shift += 7) {
+		if (position_ >= size_) {
+			return false;
+		}
+
+		unsigned char byte = static_cast<unsigned char>(data_[position_++]);
+		value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+
+		if (!(byte & 0x80)) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool BinaryReader::readSignedVarint(int64_t &value)
+{
+	uint64_t zigzag;
+
+	if (!readVarint(zigzag)) {
+		return false;
+	}
+
+	value = static_cast<int64_t>(zigzag >> 1) ^ -static_cast<int64_t>(zigzag & 1);
+
+	return true;
+}
+
+bool BinaryReader::readString(std::string &value)
+{
+	uint64_t size;
+
+	if (!readVarint(size) || size > remaining()) {
+		return false;
+	}
+
+	value.assign(data_ + position_, size);
+	position_ += size;
+
+	return true;
+}
+
+bool BinaryReader::atEnd() const
+{
+	return position_ == size_;
+}
+
+std::size_t BinaryReader::remaining() const
+{
+	return size_ - position_;
+}
@@ -0,0 +1,49 @@
+#ifndef ROB_BINARYSTREAM_H_INCLUDED
+#define ROB_BINARYSTREAM_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+// little endian fixed size integers and LEB128 varints, appended to a buffer
+class BinaryWriter
+{
+public:
+	BinaryWriter(std::vector<char> &buffer);
+
+	void writeBytes(void const *data, std::size_t size);
+	void writeU32(uint32_t value);
+	void writeVarint(uint64_t value);
+	// zigzag encoded, so small negative values stay short
+	void writeSignedVarint(int64_t value);
+	// length as varint, then the bytes
+	void writeString(std::string const &value);
+
+private:
+	std::vector<char> &buffer_;
+};
+
+// counterpart of BinaryWriter, every read fails once the data is exhausted or malformed
+class BinaryReader
+{
+public:
+	BinaryReader(char const *data, std::size_t size);
+
+	bool readBytes(void *data, std::size_t size);
+	bool readU32(uint32_t &value);
+	bool readVarint(uint64_t &value);
+	bool readSignedVarint(int64_t &value);
+	bool readString(std::string &value);
+
+	bool atEnd() const;
+	std::size_t remaining() const;
+
+private:
+	char const *data_;
+	std::size_t size_;
+	std::size_t position_;
+};
+
+#endif // ROB_BINARYSTREAM_H_INCLUDED
@@ -0,0 +1,149 @@
+#include "classify.h"
+#include "cpu.h"
+#include "roomimage.h"
+
+#include <cassert>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ROB_CLASSIFY_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+#if ROB_CLASSIFY_AVX2
+	std::size_t classifyRGBAVX2(unsigned char const *bytes, std::size_t count, unsigned char *classes);
+	std::size_t classifyRGBAAVX2(unsigned char const *bytes, std::size_t count, unsigned char *classes);
+
+	// 16 pixels per iteration, the three channels are gathered into one register each
+	__attribute__((target("avx2")))
+	std::size_t classifyRGBAVX2(unsigned char const *bytes, std::size_t count, unsigned char *classes)
+	{
+		// byte i of a channel comes from pixel i, -1 (0x80) clears the byte
+		__m128i const red0 = _mm_setr_epi8(0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		__m128i const red1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14, -1, -1, -1, -1, -1);
+		__m128i const red2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 1, 4, 7, 10, 13);
+		__m128i const green0 = _mm_setr_epi8(1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		__m128i const green1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15, -1, -1, -1, -1, -1);
+		__m128i const green2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 2, 5, 8, 11, 14);
+		__m128i const blue0 = _mm_setr_epi8(2, 5, 8, 11, 14, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+		__m128i const blue1 = _mm_setr_epi8(-1, -1, -1, -1, -1, 1, 4, 7, 10, 13, -1, -1, -1, -1, -1, -1);
+		__m128i const blue2 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 3, 6, 9, 12, 15);
+
+		__m128i const white = _mm_set1_epi8(static_cast<char>(255));
+		__m128i const black = _mm_setzero_si128();
+		__m128i const gray = _mm_set1_epi8(static_cast<char>(200));
+		__m128i const inside = _mm_set1_epi8(RoomImage::PixelInside);
+		__m128i const doorDiff = _mm_set1_epi8(RoomImage::PixelInside - RoomImage::PixelDoor);
+		__m128i const wallDiff = _mm_set1_epi8(RoomImage::PixelInside - RoomImage::PixelWall);
+		__m128i const outsideDiff = _mm_set1_epi8(RoomImage::PixelInside - RoomImage::PixelOutside);
+
+		std::size_t i = 0;
+
+		for (; i + 16 <= count; i += 16) {
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(bytes + i * 3));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(bytes + i * 3 + 16));
+			__m128i a2 = _mm_loadu_si128(reinterpret_cast<__m128i const *>(bytes + i * 3 + 32));
+
+			__m128i red = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, red0), _mm_shuffle_epi8(a1, red1)),
+			                           _mm_shuffle_epi8(a2, red2));
+			__m128i green = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, green0), _mm_shuffle_epi8(a1, green1)),
+			                             _mm_shuffle_epi8(a2, green2));
+			__m128i blue = _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a0, blue0), _mm_shuffle_epi8(a1, blue1)),
+			                            _mm_shuffle_epi8(a2, blue2));
+
+			__m128i isWhite = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(red, white), _mm_cmpeq_epi8(green, white)),
+			                                _mm_cmpeq_epi8(blue, white));
+			__m128i isBlack = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(red, black), _mm_cmpeq_epi8(green, black)),
+			                                _mm_cmpeq_epi8(blue, black));
+			__m128i isGray = _mm_and_si128(_mm_and_si128(_mm_cmpeq_epi8(red, gray), _mm_cmpeq_epi8(green, gray)),
+			                               _mm_cmpeq_epi8(blue, gray));
+
+			// the three masks exclude each other, everything else stays inside
+			__m128i result = _mm_sub_epi8(inside, _mm_and_si128(isWhite, outsideDiff));
+			result = _mm_sub_epi8(result, _mm_and_si128(isBlack, wallDiff));
+			result = _mm_sub_epi8(result, _mm_and_si128(isGray, doorDiff));
+
+			_mm_storeu_si128(reinterpret_cast<__m128i *>(classes + i), result);
+		}
+
+		return i;
+	}
+
+	// 32 pixels per iteration, one pixel per 32 bit lane
+	__attribute__((target("avx2")))
+	std::size_t classifyRGBAAVX2(unsigned char const *bytes, std::size_t count, unsigned char *classes)
+	{
+		__m256i const rgb = _mm256_set1_epi32(0x00ffffff);
+		__m256i const white = _mm256_set1_epi8(static_cast<char>(255));
+		__m256i const black = _mm256_setzero_si256();
+		__m256i const gray = _mm256_set1_epi8(static_cast<char>(200));
+		__m256i const inside = _mm256_set1_epi32(RoomImage::PixelInside);
+		__m256i const doorDiff = _mm256_set1_epi32(RoomImage::PixelInside - RoomImage::PixelDoor);
+		__m256i const wallDiff = _mm256_set1_epi32(RoomImage::PixelInside - RoomImage::PixelWall);
+		__m256i const outsideDiff = _mm256_set1_epi32(RoomImage::PixelInside - RoomImage::PixelOutside);
+		// packus works per 128 bit half, this restores the pixel order
+		__m256i const order = _mm256_setr_epi32(0, 4, 1, 5, 2, 6, 3, 7);
+
+		std::size_t i = 0;
+
+		for (; i + 32 <= count; i += 32) {
+			__m256i lanes[4];
+
+			for (int j = 0; j < 4; j++) {
+				__m256i pixels = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(bytes + (i + j * 8) * 4));
+
+				// a colour matches if its three bytes (but not alpha) do
+				__m256i isWhite = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_cmpeq_epi8(pixels, white), rgb), rgb);
+				__m256i isBlack = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_cmpeq_epi8(pixels, black), rgb), rgb);
+				__m256i isGray = _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_cmpeq_epi8(pixels, gray), rgb), rgb);
+
+				__m256i result = _mm256_sub_epi32(inside, _mm256_and_si256(isWhite, outsideDiff));
+				result = _mm256_sub_epi32(result, _mm256_and_si256(isBlack, wallDiff));
+				lanes[j] = _mm256_sub_epi32(result, _mm256_and_si256(isGray, doorDiff));
+			}
+
+			__m256i words = _mm256_packus_epi16(_mm256_packus_epi32(lanes[0], lanes[1]),
+			                                    _mm256_packus_epi32(lanes[2], lanes[3]));
+
+			_mm256_storeu_si256(reinterpret_cast<__m256i *>(classes + i), _mm256_permutevar8x32_epi32(words, order));
+		}
+
+		return i;
+	}
+#endif
+}
+
+void classifyPixels(unsigned char const *bytes, std::size_t stride, std::size_t count, unsigned char *classes)
+{
+	assert(stride == 3 || stride == 4);
+
+	std::size_t done = 0;
+
+#if ROB_CLASSIFY_AVX2
+	if (cpuHasAVX2()) {
+		if (stride == 3) {
+			done = classifyRGBAVX2(bytes, count, classes);
+		} else {
+			done = classifyRGBAAVX2(bytes, count, classes);
+		}
+	}
+#endif
+
+	classifyPixelsScalar(bytes + done * stride, stride, count - done, classes + done);
+}
+
+void classifyPixelsScalar(unsigned char const *bytes, std::size_t stride, std::size_t count, unsigned char *classes)
+{
+	for (std::size_t i = 0; i < count; i++, bytes += stride) {
+		if (bytes[0] == 255 && bytes[1] == 255 && bytes[2] == 255) {
+			classes[i] = RoomImage::PixelOutside;
+		} else if (bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0) {
+			classes[i] = RoomImage::PixelWall;
+		} else if (bytes[0] == 200 && bytes[1] == 200 && bytes[2] == 200) {
+			classes[i] = RoomImage::PixelDoor;
+		} else {
+			classes[i] = RoomImage::PixelInside;
+		}
+	}
+}
@@ -0,0 +1,12 @@
+#ifndef ROB_CLASSIFY_H_INCLUDED
+#define ROB_CLASSIFY_H_INCLUDED
+
+#include <cstddef>
+
+// writes one RoomImage::PixelClass per pixel of tightly packed RGB (stride 3)
+// or RGBA (stride 4) pixels, the alpha channel is ignored
+void classifyPixels(unsigned char const *bytes, std::size_t stride, std::size_t count, unsigned char *classes);
+// reference implementation, used as fallback
+void classifyPixelsScalar(unsigned char const *bytes, std::size_t stride, std::size_t count, unsigned char *classes);
+
+#endif // ROB_CLASSIFY_H_INCLUDED
@@ -0,0 +1,455 @@
+#include "contraction.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+#include <utility>
+
+namespace
+{
+	uint32_t const noMiddle = 0xffffffff;
+	// settled nodes per witness search, a shortcut is added when it gives up earlier
+	std::size_t const witnessLimit = 100;
+	// for the priorities, which only need an estimate of the shortcuts
+	std::size_t const simulationLimit = 10;
+
+	struct Link
+	{
+		uint32_t target;
+		float weight;
+		uint32_t middle;
+	};
+
+	// the remaining graph while contracting, a few links per node, so a vector beats a map
+	typedef std::vector<Link> Links;
+	typedef std::priority_queue< std::pair<float, uint32_t>, std::vector< std::pair<float, uint32_t> >,
+	                             std::greater< std::pair<float, uint32_t> > > Queue;
+
+	// distances of one witness search, kept for all of them so they only have to be reset
+	struct WitnessSearch
+	{
+		explicit WitnessSearch(std::size_t nodes);
+
+		void reset();
+
+		std::vector<float> distances;
+		std::vector<uint32_t> touched;
+		// the neighbours of the contracted node not settled yet, the search ends with the last one
+		std::vector<bool> targets;
+		std::size_t remainingTargets;
+	};
+
+	void setLink(Links &links, Link const &link);
+	void removeLink(Links &links, uint32_t target);
+
+	void witnessSearch(std::vector<Links> const &graph, uint32_t source, uint32_t skipped, float limit,
+	                   std::size_t settledLimit, WitnessSearch &search);
+	std::size_t contract(std::vector<Links> &graph, uint32_t node, bool simulate, WitnessSearch &search);
+	int priority(std::vector<Links> &graph, std::vector<unsigned int> const &contractedNeighbours, uint32_t node,
+	             WitnessSearch &search);
+
+	WitnessSearch::WitnessSearch(std::size_t nodes)
+		: distances(nodes, std::numeric_limits<float>::infinity()),
+		  targets(nodes, false),
+		  remainingTargets(0)
+	{
+	}
+
+	void WitnessSearch::reset()
+	{
+		for (std::vector<uint32_t>::const_iterator it = touched.begin(); it != touched.end(); ++it) {
+			distances[*it] = std::numeric_limits<float>::infinity();
+		}
+
+		touched.clear();
+	}
+
+	// replaces an existing link to the same target
+	void setLink(Links &links, Link const &link)
+	{
+		for (Links::iterator it = links.begin(); it != links.end(); ++it) {
+			if (it->target == link.target) {
+				*it = link;
+				return;
+			}
+		}
+
+		links.push_back(link);
+	}
+
+	void removeLink(Links &links, uint32_t target)
+	{
+		for (Links::iterator it = links.begin(); it != links.end(); ++it) {
+			if (it->target == target) {
+				*it = links.back();
+				links.pop_back();
+				return;
+			}
+		}
+	}
+
+	// Dijkstra without the node being contracted, up to limit
+	void witnessSearch(std::vector<Links> const &graph, uint32_t source, uint32_t skipped, float limit,
+	                   std::size_t settledLimit, WitnessSearch &search)
+	{
+		std::vector<float> &distances = search.distances;
+		Queue queue;
+		std::size_t settled = 0;
+
+		search.reset();
+		distances[source] = 0;
+		search.touched.push_back(source);
+		queue.push(std::make_pair(0.0f, source));
+
+		while (!queue.empty() && settled < settledLimit) {
+			std::pair<float, uint32_t> entry = queue.top();
+			queue.pop();
+
+			if (entry.first > distances[entry.second]) {
+				continue;
+			}
+
+			if (entry.first > limit) {
+				return;
+			}
+
+			settled++;
+
+			if (search.targets[entry.second] && --search.remainingTargets == 0) {
+				return;
+			}
+
+			for (Links::const_iterator it = graph[entry.second].begin(); it != graph[entry.second].end(); ++it) {
+				if (it->target == skipped) {
+					continue;
+				}
+
+				float distance = entry.first + it->weight;
+
+				if (distance < distances[it->target]) {
+					if (distances[it->target] == std::numeric_limits<float>::infinity()) {
+						search.touched.push_back(it->target);
+					}
+
+					distances[it->target] = distance;
+					queue.push(std::make_pair(distance, it->target));
+				}
+			}
+		}
+	}
+
+	// the shortcuts between the neighbours of node which have no witness, added unless simulated
+	std::size_t contract(std::vector<Links> &graph, uint32_t node, bool simulate, WitnessSearch &search)
+	{
+		Links const links = graph[node];
+		std::size_t shortcuts = 0;
+
+		for (Links::const_iterator first = links.begin(); first != links.end(); ++first) {
+			Links::const_iterator second = first;
+			float limit = 0;
+
+			search.remainingTargets = 0;
+
+			for (++second; second != links.end(); ++second) {
+				limit = std::max(limit, first->weight + second->weight);
+				search.targets[second->target] = true;
+				search.remainingTargets++;
+			}
+
+			if (search.remainingTargets != 0) {
+				witnessSearch(graph, first->target, node, limit, simulate ? simulationLimit : witnessLimit, search);
+			}
+
+			for (second = first, ++second; second != links.end(); ++second) {
+				float const weight = first->weight + second->weight;
+
+				search.targets[second->target] = false;
+
+				if (search.distances[second->target] <= weight) {
+					continue;
+				}
+
+				shortcuts++;
+
+				if (simulate) {
+					continue;
+				}
+
+				Link shortcut;
+				shortcut.target = second->target;
+				shortcut.weight = weight;
+				shortcut.middle = node;
+
+				setLink(graph[first->target], shortcut);
+				shortcut.target = first->target;
+				setLink(graph[second->target], shortcut);
+			}
+		}
+
+		return shortcuts;
+	}
+
+	// edge difference plus the contracted neighbours, which spreads the contraction over the roadmap
+	int priority(std::vector<Links> &graph, std::vector<unsigned int> const &contractedNeighbours, uint32_t node,
+	             WitnessSearch &search)
+	{
+		int shortcuts = contract(graph, node, true, search);
+
+		return shortcuts - static_cast<int>(graph[node].size()) + static_cast<int>(contractedNeighbours[node]);
+	}
+}
+
+ContractionHierarchy::ContractionHierarchy(CompactRoadmap const &roadmap)
+	: nodes_(roadmap.nodes),
+	  ranks_(roadmap.nodes.size()),
+	  shortcuts_(0)
+{
+	TRACE_SPAN("ContractionHierarchy::ContractionHierarchy");
+
+	std::size_t const nodeCount = nodes_.size();
+	std::vector<Links> graph(nodeCount);
+
+	// both directions, a roadmap edge may be missing on one side
+	for (uint32_t node = 0; node < nodeCount; node++) {
+		for (uint32_t edge = roadmap.offsets[node]; edge < roadmap.offsets[node + 1]; edge++) {
+			uint32_t target = roadmap.targets[edge];
+
+			if (target == node) {
+				continue;
+			}
+
+			Link link;
+			link.target = target;
+			link.weight = roadmap.weights[edge];
+			link.middle = noMiddle;
+
+			setLink(graph[node], link);
+			link.target = node;
+			setLink(graph[target], link);
+		}
+	}
+
+	std::vector<unsigned int> contractedNeighbours(nodeCount, 0);
+	WitnessSearch search(nodeCount);
+	std::vector< std::vector<Arc> > upArcs(nodeCount);
+	std::priority_queue< std::pair<int, uint32_t>, std::vector< std::pair<int, uint32_t> >,
+	                     std::greater< std::pair<int, uint32_t> > > order;
+
+	for (uint32_t node = 0; node < nodeCount; node++) {
+		order.push(std::make_pair(priority(graph, contractedNeighbours, node, search), node));
+	}
+
+	uint32_t rank = 0;
+
+	while (!order.empty()) {
+		uint32_t const node = order.top().second;
+		order.pop();
+
+		// the priorities of the queue are outdated, the node waits if it got worse than the next one
+		int const current = priority(graph, contractedNeighbours, node, search);
+
+		if (!order.empty() && current > order.top().first) {
+			order.push(std::make_pair(current, node));
+			continue;
+		}
+
+		// all remaining neighbours are contracted later, so these are the arcs upwards
+		for (Links::const_iterator it = graph[node].begin(); it != graph[node].end(); ++it) {
+			Arc arc;
+			arc.target = it->target;
+			arc.weight = it->weight;
+			arc.middle = it->middle;
+
+			upArcs[node].push_back(arc);
+		}
+
+		contract(graph, node, false, search);
+
+		for (Links::const_iterator it = graph[node].begin(); it != graph[node].end(); ++it) {
+			removeLink(graph[it->target], node);
+			contractedNeighbours[it->target]++;
+		}
+
+		Links().swap(graph[node]);
+		ranks_[node] = rank++;
+	}
+
+	upOffsets_.reserve(nodeCount + 1);
+	upOffsets_.push_back(0);
+
+	for (uint32_t node = 0; node < nodeCount; node++) {
+		for (std::vector<Arc>::const_iterator it = upArcs[node].begin(); it != upArcs[node].end(); ++it) {
+			upArcs_.push_back(*it);
+
+			if (it->middle != noMiddle) {
+				shortcuts_++;
+			}
+		}
+
+		upOffsets_.push_back(upArcs_.size());
+	}
+}
+
+std::vector<Coord2D> ContractionHierarchy::findPath(Coord2D const &startpoint, Coord2D const &endpoint,
+                                                    uint64_t *expanded) const
+{
+	TRACE_SPAN("ContractionHierarchy::findPath");
+
+	std::vector<Coord2D> const noPath(1, endpoint);
+	int const start = nodeIndex(startpoint);
+	int const end = nodeIndex(endpoint);
+
+	if (start < 0 || end < 0 || start == end) {
+		return noPath;
+	}
+
+	// forward from the startpoint and backward from the endpoint, both only upwards
+	std::map<uint32_t, float> distances[2];
+	std::map<uint32_t, uint32_t> previous[2];
+	Queue queues[2];
+	float best = std::numeric_limits<float>::infinity();
+	int meeting = -1;
+
+	distances[0][start] = 0;
+	distances[1][end] = 0;
+	queues[0].push(std::make_pair(0.0f, static_cast<uint32_t>(start)));
+	queues[1].push(std::make_pair(0.0f, static_cast<uint32_t>(end)));
+
+	while (!queues[0].empty() || !queues[1].empty()) {
+		int side = 0;
+
+		if (queues[0].empty() || (!queues[1].empty() && queues[1].top().first < queues[0].top().first)) {
+			side = 1;
+		}
+
+		std::pair<float, uint32_t> entry = queues[side].top();
+
+		// the smaller of both minimums, neither side can improve the path any more
+		if (entry.first >= best) {
+			break;
+		}
+
+		queues[side].pop();
+
+		if (entry.first > distances[side][entry.second]) {
+			continue;
+		}
+
+		if (expanded) {
+			(*expanded)++;
+		}
+
+		std::map<uint32_t, float>::const_iterator other = distances[1 - side].find(entry.second);
+
+		if (other != distances[1 - side].end() && entry.first + other->second < best) {
+			best = entry.first + other->second;
+			meeting = entry.second;
+		}
+
+		for (uint32_t arc = upOffsets_[entry.second]; arc < upOffsets_[entry.second + 1]; arc++) {
+			uint32_t const target = upArcs_[arc].target;
+			float distance = entry.first + upArcs_[arc].weight;
+			std::map<uint32_t, float>::iterator known = distances[side].find(target);
+
+			if (known == distances[side].end() || distance < known->second) {
+				distances[side][target] = distance;
+				previous[side][target] = entry.second;
+				queues[side].push(std::make_pair(distance, target));
+			}
+		}
+	}
+
+	if (meeting < 0) {
+		return noPath;
+	}
+
+	// the nodes of the hierarchy from the startpoint over the meeting node to the endpoint
+	std::vector<uint32_t> route;
+
+	for (uint32_t node = meeting; node != static_cast<uint32_t>(start); node = previous[0][node]) {
+		route.push_back(node);
+	}
+
+	route.push_back(start);
+	std::reverse(route.begin(), route.end());
+
+	for (uint32_t node = meeting; node != static_cast<uint32_t>(end);) {
+		node = previous[1][node];
+		route.push_back(node);
+	}
+
+	std::vector<uint32_t> nodes(1, start);
+
+	for (std::size_t i = 0; i + 1 < route.size(); i++) {
+		unpack(route[i], route[i + 1], nodes);
+	}
+
+	std::vector<Coord2D> path;
+	path.reserve(nodes.size());
+
+	for (std::vector<uint32_t>::const_reverse_iterator it = nodes.rbegin(); it != nodes.rend(); ++it) {
+		path.push_back(nodes_[*it]);
+	}
+
+	return path;
+}
+
+std::size_t ContractionHierarchy::nodes() const
+{
+	return nodes_.size();
+}
+
+std::size_t ContractionHierarchy::shortcuts() const
+{
+	return shortcuts_;
+}
+
+std::size_t ContractionHierarchy::memoryUsage() const
+{
+	return nodes_.capacity() * sizeof(Coord2D) + ranks_.capacity() * sizeof(uint32_t) +
+	       upOffsets_.capacity() * sizeof(uint32_t) + upArcs_.capacity() * sizeof(Arc);
+}
+
+// stored with the lower ranked node
+ContractionHierarchy::Arc const *ContractionHierarchy::findArc(uint32_t first, uint32_t second) const
+{
+	if (ranks_[first] > ranks_[second]) {
+		std::swap(first, second);
+	}
+
+	for (uint32_t arc = upOffsets_[first]; arc < upOffsets_[first + 1]; arc++) {
+		if (upArcs_[arc].target == second) {
+			return &upArcs_[arc];
+		}
+	}
+
+	return 0;
+}
+
+// appends the roadmap nodes after from up to to
+void ContractionHierarchy::unpack(uint32_t from, uint32_t to, std::vector<uint32_t> &path) const
+{
+	Arc const *arc = findArc(from, to);
+
+	if (arc->middle == noMiddle) {
+		path.push_back(to);
+		return;
+	}
+
+	unpack(from, arc->middle, path);
+	unpack(arc->middle, to, path);
+}
+
+int ContractionHierarchy::nodeIndex(Coord2D const &coord) const
+{
+	std::vector<Coord2D>::const_iterator it = std::lower_bound(nodes_.begin(), nodes_.end(), coord);
+
+	if (it == nodes_.end() || *it != coord) {
+		return -1;
+	}
+
+	return it - nodes_.begin();
+}
@@ -0,0 +1,56 @@
+#ifndef ROB_CONTRACTION_H_INCLUDED
+#define ROB_CONTRACTION_H_INCLUDED
+
+#include "coord.h"
+#include "roadmap.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <stdint.h>
+
+// contraction hierarchy of a static roadmap. The nodes are contracted one by one, the one
+// adding the fewest shortcuts first; a shortcut replaces two edges over a contracted node
+// unless a witness path is as short. A query searches upwards in the order from both ends
+// and unpacks the shortcuts of the meeting path into roadmap edges again
+class ContractionHierarchy
+{
+public:
+	explicit ContractionHierarchy(CompactRoadmap const &roadmap);
+
+	// like dijkstra(), from the endpoint back to the startpoint and only the endpoint if
+	// there is no path; may run on several threads at once
+	std::vector<Coord2D> findPath(Coord2D const &startpoint, Coord2D const &endpoint,
+	                              uint64_t *expanded = 0) const;
+
+	std::size_t nodes() const;
+	std::size_t shortcuts() const;
+	// bytes of the upward graph and the order
+	std::size_t memoryUsage() const;
+
+private:
+	ContractionHierarchy(ContractionHierarchy const &);
+	ContractionHierarchy &operator=(ContractionHierarchy const &);
+
+	struct Arc
+	{
+		uint32_t target;
+		float weight;
+		// the contracted node a shortcut goes over, 0xffffffff for roadmap edges
+		uint32_t middle;
+	};
+
+	Arc const *findArc(uint32_t first, uint32_t second) const;
+	void unpack(uint32_t from, uint32_t to, std::vector<uint32_t> &path) const;
+	int nodeIndex(Coord2D const &coord) const;
+
+	std::vector<Coord2D> nodes_;
+	// position of every node in the contraction order
+	std::vector<uint32_t> ranks_;
+	// arcs to higher ranked nodes of nodes_[i] are upArcs_[upOffsets_[i]] up to upArcs_[upOffsets_[i + 1]]
+	std::vector<uint32_t> upOffsets_;
+	std::vector<Arc> upArcs_;
+	std::size_t shortcuts_;
+};
+
+#endif // ROB_CONTRACTION_H_INCLUDED
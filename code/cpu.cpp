@@ -0,0 +1,11 @@
+#include "cpu.h"
+
+bool cpuHasAVX2()
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+	static bool const hasAVX2 = __builtin_cpu_supports("avx2");
+	return hasAVX2;
+#else
+	return false;
+#endif
+}
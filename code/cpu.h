@@ -0,0 +1,7 @@
+#ifndef ROB_CPU_H_INCLUDED
+#define ROB_CPU_H_INCLUDED
+
+// runtime detection of instruction set extensions used by vectorised kernels
+bool cpuHasAVX2();
+
+#endif // ROB_CPU_H_INCLUDED
@@ -1,12 +1,19 @@
 #define GL_GLEXT_PROTOTYPES
 
 #include "algo.h"
+#include "binarystream.h"
 #include "coord.h"
 #include "drawing.h"
+#include "linebuffer.h"
+#include "planner.h"
+#include "planningjob.h"
+#include "roomloader.h"
 #include "room.h"
 #include "roomimage.h"
 #include "stats.h"
 #include "texture.h"
+#include "trace.h"
+#include "viewtransform.h"
 
 #include <QtCore/QElapsedTimer>
 #include <QtCore/QTimer>
@@ -16,11 +23,11 @@
 #endif
 #include <GL/gl.h>
 #include <GL/glu.h>
-#include <IL/il.h>
-#include <IL/ilu.h>
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstddef>
 #include <ctime>
 #include <limits>
 #include <set>
@@ -31,11 +38,8 @@
 #include <QtCore/QXmlStreamWriter>
 #include <QtWidgets/QTextEdit>
 
-#if MEASURE
-#include <sys/time.h>
-#endif
-
 #define ROBOT_DIAMETER 5
+#define TEXTURE_TILES_PER_FRAME 2
 
 // private namespace
 namespace
@@ -53,6 +57,30 @@ void throwErrorFromGLError()
 	}
 }
 
+// waypoints and start/end markers share one buffer and are drawn as points
+struct Marker
+{
+	GLfloat x;
+	GLfloat y;
+	GLubyte color[4];
+};
+
+Marker createMarker(float x, float y, unsigned int height, GLubyte red, GLubyte green, GLubyte blue);
+
+Marker createMarker(float x, float y, unsigned int height, GLubyte red, GLubyte green, GLubyte blue)
+{
+	Marker marker;
+
+	marker.x = x;
+	marker.y = height - 1.0f - y;
+	marker.color[0] = red;
+	marker.color[1] = green;
+	marker.color[2] = blue;
+	marker.color[3] = 255;
+
+	return marker;
+}
+
 } // end of private namespace
 
 class Drawing::DrawingImpl
@@ -61,9 +89,14 @@ public:
 	DrawingImpl(Drawing *parent, Stats *stats, QTextEdit *statusText, QTextEdit *helpText);
 	~DrawingImpl();
 
-	void fromImage(const char *name);
+	// preprocesses the room on a RoomLoader thread if background is set
+	void fromImage(const char *name, bool background);
+	void roomStageFinished(int stage);
+	void roomReady();
+	void releaseImageData();
 
 	void updateRoom();
+	void planned(PlanningJob *job);
 
 	void setNodes(int amount);
 	void setWaypointModification(Drawing::WaypointModification modification);
@@ -71,6 +104,8 @@ public:
 	bool getOption(Drawing::Option option) const;
 	void setAlgorithm(Room::Algorithm algorithm);
 	Room::Algorithm getAlgorithm() const;
+	void setLazyValidation(bool enabled);
+	bool getLazyValidation() const;
 	void mouseClick(int x, int y);
 
 	std::size_t countWaypoints() const;
@@ -83,26 +118,50 @@ public:
 	void freeTexture();
 	bool checkNode(int x, int y);
 	bool delNode(int x, int y);
-	void drawPoint(int x, int y);
-	void drawCross(int x, int y);
+	void updateMarkers();
+	// count markers of markerVBO starting at first, after updateMarkers() in the same frame
+	void drawMarkers(GLint first, GLsizei count);
+	// for points larger than the driver supports, from the copy of the markers
+	void drawMarkerQuads(GLint first, GLsizei count);
 	bool getCoordFromMouseClick(int x, int y, Coord2D &coord);
 	void showNeighbours(Coord2D const &coord);
 
 	bool loadRoom(const char *name);
 	bool loadProject(QXmlStreamReader *reader);
 	bool saveProject(QXmlStreamWriter *writer) const;
+	bool loadBinaryProject(BinaryReader &reader);
+	bool saveBinaryProject(BinaryWriter &writer) const;
 
 	void animationForward();
 
+	Drawing *parent;
 	Drawing::WaypointModification waypointModification;
-	GLint viewport[4];
-	GLuint circleVBO;
-	GLuint crossVBO;
+	ViewTransform view;
+	GLuint markerVBO;
+	// what markerVBO holds, for the quads drawn instead of too large points
+	std::vector<Marker> markers;
+	// room version and amount of the waypoints currently in markerVBO
+	unsigned long markerVersion;
+	std::size_t markerWaypoints;
+	// smallest and largest point size of the driver, queried by initialize()
+	GLfloat pointSizeRange[2];
 	Room *room;
+	// preprocesses room after it was decoded, until it's ready
+	RoomLoader *loader;
+	// computes the path of room away from the GUI thread
+	Planner *planner;
+	// started when the room is loaded, for the time to first pixel and time to interactive
+	QElapsedTimer loadTimer;
+	bool firstPixel;
 	Texture *texture;
 	bool show_[5];
-	std::vector<Triangle> triangulation;
-	std::vector<Triangle> roomTriangulation;
+	// uploaded to vertex buffers whenever updateRoom() or fromImage() changed them
+	LineBuffer triangulationLines;
+	LineBuffer roomTriangulationLines;
+	LineBuffer pathLines;
+	LineBuffer collisionLines;
+	// room version of triangulationLines, only waypoint changes alter the triangulation
+	unsigned long triangulationVersion;
 	std::vector<Coord2D> path;
 	std::vector< Coord2DTemplate<float> > pathPoints;
 	std::set< Coord2DTemplate<float> > pathCollisions;
@@ -119,9 +178,17 @@ public:
 };
 
 Drawing::DrawingImpl::DrawingImpl(Drawing *parent, Stats *stats, QTextEdit *statusText, QTextEdit *helpText)
-	: waypointModification(Drawing::WaypointNoMod),
+	: parent(parent),
+	  waypointModification(Drawing::WaypointNoMod),
+	  markerVBO(0),
+	  markerVersion(0),
+	  markerWaypoints(0),
 	  room(0),
+	  loader(0),
+	  planner(0),
+	  firstPixel(false),
 	  texture(0),
+	  triangulationVersion(0),
 	  statusText_(statusText),
 	  helpText_(helpText),
 	  animationTimer(new QTimer(parent)),
@@ -130,6 +197,9 @@ Drawing::DrawingImpl::DrawingImpl(Drawing *parent, Stats *stats, QTextEdit *stat
 {
 	std::srand(std::time(0));
 
+	pointSizeRange[0] = 1.0f;
+	pointSizeRange[1] = 1.0f;
+
 	for (size_t i = 0; i < sizeof show_ / sizeof *show_; i++) {
 		show_[i] = false;
 	}
@@ -140,12 +210,18 @@ Drawing::DrawingImpl::DrawingImpl(Drawing *parent, Stats *stats, QTextEdit *stat
 Drawing::DrawingImpl::~DrawingImpl()
 {
 	freeTexture();
-	glDeleteBuffers(1, &circleVBO);
+	glDeleteBuffers(1, &markerVBO);
 }
 
-void Drawing::DrawingImpl::fromImage(const char *name)
+void Drawing::DrawingImpl::fromImage(const char *name, bool background)
 {
+	loadTimer.start();
+	firstPixel = false;
+
 	room = new Room(name, ROBOT_DIAMETER, stats, statusText_, helpText_);
+	// the versions of the new room start again
+	markerVersion = 0;
+	triangulationVersion = 0;
 
 	if (room->image().width() > static_cast<unsigned int>(std::numeric_limits<int>::max()) ||
 	    room->image().height() > static_cast<unsigned int>(std::numeric_limits<int>::min())) {
@@ -154,50 +230,128 @@ void Drawing::DrawingImpl::fromImage(const char *name)
 		throw std::runtime_error("OpenGL cannot draw this texture.");
 	}
 
-	roomTriangulation = room->getRoomTriangulation();
+	view.setRoomSize(room->image().width(), room->image().height());
+
+	if (!background) {
+		room->preprocess();
+		roomReady();
+		return;
+	}
+
+	// the texture can be shown already, the controls follow with the stages
+	loader = new RoomLoader(room);
+	connect(loader, SIGNAL(stageFinished(int)), parent, SLOT(roomStageFinished(int)));
+	loader->start();
+
+	statusText_->setText(statusText_->tr("Extracting the room contours..."));
 }
 
-void Drawing::DrawingImpl::updateRoom()
+void Drawing::DrawingImpl::roomStageFinished(int stage)
 {
-	QElapsedTimer timer;
+	if (loader == 0) {
+		return;
+	}
 
-	triangulation = room->getTriangulation();
+	if (stage == Room::StageContours) {
+		statusText_->setText(statusText_->tr("Triangulating the room..."));
+		emit parent->stageReached(stage);
+		return;
+	}
+
+	assert(stage == Room::StageTriangulated);
 
-	path = room->generatePath();
+	loader->wait();
+	delete loader;
+	loader = 0;
 
-	if (path.begin()->x > path.rbegin()->x) {
-		std::reverse(path.begin(), path.end());
+	emit parent->stageReached(stage);
+
+	room->placeEndpoints();
+	roomReady();
+
+	statusText_->setText(statusText_->tr("Room loaded."));
+}
+
+void Drawing::DrawingImpl::releaseImageData()
+{
+	// the texture keeps its own copy and the classification is done; the loader thread
+	// still reads the image while it triangulates and saves the room cache
+	if (texture != 0 && loader == 0 && room->stage() >= Room::StageContours) {
+		room->releaseImageData();
 	}
+}
 
-	timer.start();
+void Drawing::DrawingImpl::roomReady()
+{
+	releaseImageData();
 
-	pathPoints = catmullRom(path, 150);
+	roomTriangulationLines.setTriangles(room->getRoomTriangulation(), room->image().height());
 
-	stats->lastCatmullRomCalculation = timer.elapsed();
+	planner = new Planner(room);
+	connect(planner, SIGNAL(planned(PlanningJob *)), parent, SLOT(planned(PlanningJob *)));
 
-	pathCollisions.clear();
+	stats->record("time to interactive", loadTimer.nsecsElapsed());
 
-	timer.start();
+	updateRoom();
 
-	for (std::vector< Coord2DTemplate<float> >::const_iterator it = pathPoints.begin(); it != pathPoints.end(); ++it) {
-		if (!room->pointInside(it->x, it->y)) {
-			pathCollisions.insert(*it);
-		}
+	emit parent->stageReached(Room::StageReady);
+}
+
+void Drawing::DrawingImpl::updateRoom()
+{
+	// also called by initialize(), which may be earlier
+	if (room->stage() != Room::StageReady) {
+		return;
+	}
+
+	// algorithm and validation changes keep the waypoints, the lines stay as they are
+	if (triangulationVersion != room->version()) {
+		triangulationLines.setTriangles(room->getTriangulation(), room->image().height());
+		triangulationVersion = room->version();
 	}
 
-	stats->lastPathCollisionCalculation = timer.elapsed();
+	// the previous path stays visible until the new one arrives in planned()
+	planner->plan();
 }
 
-void Drawing::DrawingImpl::setNodes(int amount)
+void Drawing::DrawingImpl::planned(PlanningJob *job)
 {
-	room->clearWaypoints();
+	path = job->path;
+	pathPoints = job->pathPoints;
+	pathCollisions = job->pathCollisions;
+
+	stats->record("Catmull-Rom", job->catmullRomTime);
+	stats->record("path collision", job->collisionTime);
+	stats->record("planning job", job->requestTimer.nsecsElapsed());
+
+	delete job;
 
-	QElapsedTimer timer;
-	timer.start();
+	pathLines.setLineStrip(pathPoints, room->image().height());
+
+	std::vector< Coord2DTemplate<float> > crosses;
+
+	for (std::set< Coord2DTemplate<float> >::const_iterator it = pathCollisions.begin(); it != pathCollisions.end(); ++it) {
+		crosses.push_back(Coord2DTemplate<float>(it->x - 3, it->y - 3));
+		crosses.push_back(Coord2DTemplate<float>(it->x + 3, it->y + 3));
+		crosses.push_back(Coord2DTemplate<float>(it->x - 3, it->y + 3));
+		crosses.push_back(Coord2DTemplate<float>(it->x + 3, it->y - 3));
+	}
+
+	collisionLines.setSegments(crosses, room->image().height());
+}
+
+void Drawing::DrawingImpl::setNodes(int amount)
+{
+	if (room->stage() != Room::StageReady) {
+		return;
+	}
 
-	room->setNodes(amount);
+	room->clearWaypoints();
 
-	stats->lastSetNodes = timer.elapsed();
+	{
+		ScopedTimer timer(stats, "set nodes");
+		room->setNodes(amount);
+	}
 
 	updateRoom();
 }
@@ -237,32 +391,33 @@ Room::Algorithm Drawing::DrawingImpl::getAlgorithm() const
 	return room->getAlgorithm();
 }
 
-void Drawing::DrawingImpl::mouseClick(int x, int y)
+void Drawing::DrawingImpl::setLazyValidation(bool enabled)
 {
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0, texture->width(), 0, texture->height(), -1.0f, 4.0f);
-	throwErrorFromGLError();
+	room->setLazyValidation(enabled);
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
+	updateRoom();
+}
 
-	// Texture
-	glTranslatef(0.0f, 0.0f, -3.5f);
+bool Drawing::DrawingImpl::getLazyValidation() const
+{
+	return room->getLazyValidation();
+}
 
-	GLdouble modelview[16], projection[16];
-	glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
-	glGetDoublev(GL_PROJECTION_MATRIX, projection);
+void Drawing::DrawingImpl::mouseClick(int x, int y)
+{
+	if (room->stage() != Room::StageReady) {
+		return;
+	}
 
-	GLfloat z;
-	glReadPixels(x, viewport[3] - y, 1, 1, GL_DEPTH_COMPONENT, GL_FLOAT, &z);
+	Coord2D clicked;
 
-	GLdouble posX, posY, posZ;
-	gluUnProject(x, y, z, modelview, projection, viewport, &posX, &posY, &posZ);
-	throwErrorFromGLError();
+	// computed on the CPU, no need to read back from the GL pipeline
+	if (!view.toRoom(x, y, clicked)) {
+		return;
+	}
 
-	x = posX;
-	y = posY;
+	x = clicked.x;
+	y = clicked.y;
 
 	bool changed = false;
 
@@ -335,57 +490,20 @@ void Drawing::DrawingImpl::initialize()
 
 	glEnable(GL_DEPTH_TEST);
 
-	GLdouble vertices[(300 + 1) * 2];
-
-	vertices[0] = 0; vertices[1] = 0;
-
-	for (int i = 0; i < 300; i++) {
-		double angle = 2.0 * M_PI * (1.0 * i) / 300;
-		double drawX = (ROBOT_DIAMETER / 2.5) * std::cos(angle);
-		double drawY = (ROBOT_DIAMETER / 2.5) * std::sin(angle);
-
-		vertices[(i + 1) * 2] = drawX;
-		vertices[(i + 1) * 2 + 1] = drawY;
-	}
-
-	glGenBuffersARB(1, &circleVBO);
+	glGenBuffers(1, &markerVBO);
 	throwErrorFromGLError();
 
-	try {
-		glBindBufferARB(GL_ARRAY_BUFFER_ARB, circleVBO);
-		throwErrorFromGLError();
-		glBufferDataARB(GL_ARRAY_BUFFER_ARB, sizeof vertices, vertices, GL_STATIC_DRAW);
-		throwErrorFromGLError();
-		glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
-		throwErrorFromGLError();
-	} catch (...) {
-		glDeleteBuffers(1, &circleVBO);
-		throw;
-	}
-
-	{
-		vertices[0] = -3; vertices[1] = -3;
-		vertices[2] = 3; vertices[3] = 3;
-		vertices[4] = -3; vertices[5] = 3;
-		vertices[6] = 3; vertices[7] = -3;
-	}
-
-	glGenBuffersARB(1, &crossVBO);
+	// the markers are smoothed, which may have a smaller limit than aliased points
+	GLfloat smoothPointSizeRange[2];
+	glGetFloatv(GL_ALIASED_POINT_SIZE_RANGE, pointSizeRange);
+	glGetFloatv(GL_POINT_SIZE_RANGE, smoothPointSizeRange);
 	throwErrorFromGLError();
 
-	try {
-		glBindBufferARB(GL_ARRAY_BUFFER_ARB, crossVBO);
-		throwErrorFromGLError();
-		glBufferDataARB(GL_ARRAY_BUFFER_ARB, sizeof *vertices * 8, vertices, GL_STATIC_DRAW);
-		throwErrorFromGLError();
-		glBindBufferARB(GL_ARRAY_BUFFER_ARB, 0);
-		throwErrorFromGLError();
-	} catch (...) {
-		glDeleteBuffers(2, &crossVBO);
-		throw;
-	}
+	pointSizeRange[0] = std::max(pointSizeRange[0], smoothPointSizeRange[0]);
+	pointSizeRange[1] = std::min(pointSizeRange[1], smoothPointSizeRange[1]);
 
 	texture = new Texture(room->image());
+	releaseImageData();
 
 	updateRoom();
 }
@@ -396,59 +514,31 @@ void Drawing::DrawingImpl::paint()
 		return;
 	}
 
-#if MEASURE
-	struct timeval fir; gettimeofday(&fir, NULL);
-#endif
+	ScopedTimer timer(stats, "paint");
+	TRACE_SPAN("paint");
 
 	glClear(GL_DEPTH_BUFFER_BIT | GL_COLOR_BUFFER_BIT);
 
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	// default projection: glOrtho(l=-1,r=1,b=-1,t=1,n=1,f=-1)
-	glOrtho(0, texture->width(), 0, texture->height(), -1.0f, 4.0f);
-	throwErrorFromGLError();
+	view.apply();
 
-	glMatrixMode(GL_MODELVIEW);
-	glLoadIdentity();
-	glTranslatef(0.0f, 0.0f, -3.5f);
-
-	// OpenGL origin = bottom-left
-	// DevIL origin = top-left
-	// => swap y coordinates in glTexCoord2f
-
-	// Texture
-	glEnable(GL_TEXTURE_2D);
-	texture->bind();
-	glBegin(GL_POLYGON);
-	glTexCoord2i(0, 1);
-	glVertex2i(0, 0);
-	glTexCoord2i(0, 0);
-	glVertex2i(0, texture->height());
-	glTexCoord2i(1, 0);
-	glVertex2i(texture->width(), texture->height());
-	glTexCoord2i(1, 1);
-	glVertex2i(texture->width(), 0);
-	glEnd();
-	glDisable(GL_TEXTURE_2D);
+	// Texture, the tiles which are still missing are uploaded over the next frames
+	if (texture->uploadTiles(TEXTURE_TILES_PER_FRAME)) {
+		emit parent->repaintNeeded();
+	}
+
+	texture->draw();
+
+	if (!firstPixel) {
+		firstPixel = true;
+		stats->record("time to first pixel", loadTimer.nsecsElapsed());
+	}
 
 	if (show_[ShowTriangulation]) {
 		glTranslatef(0.0f, 0.0f, 0.2f);
 		// light blue
 		glColor3f(0.5f, 0.8f, 1.0f);
 		glLineWidth(2.0f);
-		for (std::vector<Triangle>::const_iterator it = triangulation.begin();
-		     it != triangulation.end();
-		     it++) {
-			glBegin(GL_LINE_LOOP);
-
-			for (int i = 0; i < 3; i++) {
-				unsigned int x = (*it)[i].x;
-				unsigned int y = texture->height() - 1 - (*it)[i].y;
-				glVertex2i(x, y);
-			}
-
-			glEnd();
-		}
+		triangulationLines.draw();
 	}
 
 	if (show_[ShowRoomTriangulation]) {
@@ -456,35 +546,19 @@ void Drawing::DrawingImpl::paint()
 		// lighter blue
 		glColor3f(0.6f, 0.9f, 1.0f);
 		glLineWidth(2.0f);
-		for (std::vector<Triangle>::const_iterator it = roomTriangulation.begin();
-		     it != roomTriangulation.end();
-		     it++) {
-			glBegin(GL_LINE_LOOP);
-
-			for (int i = 0; i < 3; i++) {
-				unsigned int x = (*it)[i].x;
-				unsigned int y = texture->height() - 1 - (*it)[i].y;
-				glVertex2i(x, y);
-			}
-
-			glEnd();
-		}
+		roomTriangulationLines.draw();
 	}
 
-	// Waypoints
-	glBindBuffer(GL_ARRAY_BUFFER, circleVBO);
-	glEnableClientState(GL_VERTEX_ARRAY);
-	glVertexPointer(2, GL_DOUBLE, 0, 0);
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	bool const showMarkers = room->stage() == Room::StageReady;
+
+	if (showMarkers) {
+		updateMarkers();
+	}
 
-	if (show_[ShowWaypoints]) {
+	// Waypoints, under the path
+	if (showMarkers && show_[ShowWaypoints]) {
 		glTranslatef(0.0f, 0.0f, 0.2f);
-		// yellow
-		glColor3f(1.0f, 1.0f, 0.0f);
-		std::set<Coord2D> const &waypoints = room->getWaypoints();
-		for (std::set<Coord2D>::const_iterator it = waypoints.begin(); it != waypoints.end(); it++) {
-			drawPoint(it->x, it->y);
-		}
+		drawMarkers(0, markerWaypoints);
 	}
 
 #if 0
@@ -528,55 +602,30 @@ void Drawing::DrawingImpl::paint()
 		//glColor3f(0.7f, 0.7f, 0.0f);
 		glColor3f(0.2f, 0.2f, 0.2f);
 		glLineWidth(2.0f);
-		glBegin(GL_LINE_STRIP);
-		for (std::vector< Coord2DTemplate<float> >::const_iterator it = pathPoints.begin();
-		     it != pathPoints.end();
-		     ++it) {
-			glVertex2f(it->x, texture->height() - 1 - it->y);
-		}
-		glEnd();
+		pathLines.draw();
 	}
 
 	glTranslatef(0.0f, 0.0f, 0.2f);
-	glColor3f(1.0f, 0.0f, 0.0f);
-	drawPoint(room->getEndpoint().x, room->getEndpoint().y);
 
-	glColor3f(0.0f, 1.0f, 0.0f);
-	drawPoint(room->getStartpoint().x, room->getStartpoint().y);
+	// Endpoint and startpoint above the path, the collisions and the animated position on their level
+	if (showMarkers) {
+		drawMarkers(markerWaypoints, 2);
+	}
 
 	// Collisions
 	if (show_[ShowPath] && !pathCollisions.empty()) {
-		glBindBuffer(GL_ARRAY_BUFFER, crossVBO);
-		glEnableClientState(GL_VERTEX_ARRAY);
-		glVertexPointer(2, GL_DOUBLE, 0, 0);
-		glBindBuffer(GL_ARRAY_BUFFER, 0);
 		glColor3f(1.0f, 0.0f, 0.0f);
-
-		for (std::set< Coord2DTemplate<float> >::const_iterator it = pathCollisions.begin(); it != pathCollisions.end(); ++it) {
-			drawCross(it->x, it->y);
-		}
+		collisionLines.draw();
 	}
 
-	if (animated) {
-		glColor3f(0.63f, 0.13f, 0.94f);
-		drawPoint(animationPosition->x, animationPosition->y);
+	if (showMarkers && animated && animationPosition != animationPoints.end()) {
+		drawMarkers(markerWaypoints + 2, 1);
 	}
-
-	glDisableClientState(GL_VERTEX_ARRAY);
-
-#if MEASURE
-	struct timeval sec; gettimeofday(&sec, NULL);
-	struct timeval res; timersub(&sec, &fir, &res);
-	statusText_->setText(statusText_->tr("rendering: %1 sec %2 usec\n").arg(res.tv_sec).arg(res.tv_usec));
-#endif
 }
 
 void Drawing::DrawingImpl::resize(int width, int height)
 {
-	viewport[0] = 0;
-	viewport[1] = 0;
-	viewport[2] = width;
-	viewport[3] = height;
+	view.setViewport(width, height);
 }
 
 void Drawing::DrawingImpl::animate()
@@ -608,9 +657,19 @@ void Drawing::DrawingImpl::animate()
 
 void Drawing::DrawingImpl::freeTexture()
 {
+	// the stages can't be interrupted, wait for the running one
+	if (loader) {
+		loader->wait();
+		delete loader;
+		loader = 0;
+	}
+
+	// waits for a running job, which still uses the room
+	delete planner;
 	delete texture;
 	delete room;
 
+	planner = 0;
 	room = 0;
 	texture = 0;
 }
@@ -626,52 +685,117 @@ bool Drawing::DrawingImpl::delNode(int x, int y)
 	return false;
 }
 
-void Drawing::DrawingImpl::drawPoint(int x, int y)
+void Drawing::DrawingImpl::updateMarkers()
 {
-#if COLLISION_DETECTION
-		int left = std::max(0, x - ROBOT_DIAMETER / 2);
-		int right = std::min(static_cast<int>(texture->width()) - 1, x + ROBOT_DIAMETER / 2);
-		int bottom = std::max(0, y - ROBOT_DIAMETER / 2);
-		int top = std::min(static_cast<int>(texture->height()) - 1, y + ROBOT_DIAMETER / 2);
+	unsigned int height = texture->height();
 
-		glRecti(left, bottom, right, top);
-#else
-		int offsetX = x;
-		int offsetY = texture->height() - 1 - y;
-		glTranslatef(offsetX, offsetY, 0.0f);
-		glDrawArrays(GL_TRIANGLE_FAN, 0, 301);
-		glTranslatef(-offsetX, -offsetY, 0.0f);
-#endif
+	glBindBuffer(GL_ARRAY_BUFFER, markerVBO);
+
+	// the waypoints are only uploaded again after they changed
+	if (markerVersion != room->version()) {
+		std::set<Coord2D> const &waypoints = room->getWaypoints();
+
+		markers.clear();
+		markers.reserve(waypoints.size() + 3);
+
+		for (std::set<Coord2D>::const_iterator it = waypoints.begin(); it != waypoints.end(); it++) {
+			// yellow
+			markers.push_back(createMarker(it->x, it->y, height, 255, 255, 0));
+		}
+
+		// space for the endpoint, startpoint and animated position
+		markers.resize(waypoints.size() + 3);
+
+		glBufferData(GL_ARRAY_BUFFER, markers.size() * sizeof(Marker), &markers[0], GL_DYNAMIC_DRAW);
+
+		markerVersion = room->version();
+		markerWaypoints = waypoints.size();
+	}
+
+	Marker tail[3];
+
+	tail[0] = createMarker(room->getEndpoint().x, room->getEndpoint().y, height, 255, 0, 0);
+	tail[1] = createMarker(room->getStartpoint().x, room->getStartpoint().y, height, 0, 255, 0);
+
+	if (animated && animationPosition != animationPoints.end()) {
+		// purple
+		tail[2] = createMarker(animationPosition->x, animationPosition->y, height, 161, 33, 240);
+	} else {
+		tail[2] = tail[1];
+	}
+
+	std::copy(tail, tail + 3, markers.begin() + markerWaypoints);
+
+	glBufferSubData(GL_ARRAY_BUFFER, markerWaypoints * sizeof(Marker), sizeof tail, tail);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	throwErrorFromGLError();
 }
 
-void Drawing::DrawingImpl::drawCross(int x, int y)
+void Drawing::DrawingImpl::drawMarkers(GLint first, GLsizei count)
 {
-	int offsetX = x;
-	int offsetY = texture->height() - 1 - y;
-	glTranslatef(offsetX, offsetY, 0.0f);
-	glDrawArrays(GL_LINES, 0, 8);
-	glTranslatef(-offsetX, -offsetY, 0.0f);
+	if (count == 0) {
+		return;
+	}
+
+	// round point sprites with the diameter of the former circles
+	GLfloat pointSize = 2.0f * (ROBOT_DIAMETER / 2.5f) * view.pixelsPerUnit();
+
+	// the driver clamps larger points, the markers have to keep their size in the room
+	if (pointSize > pointSizeRange[1]) {
+		drawMarkerQuads(first, count);
+		return;
+	}
+
+	glPointSize(std::max(pointSizeRange[0], pointSize));
+	glEnable(GL_POINT_SMOOTH);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+	glBindBuffer(GL_ARRAY_BUFFER, markerVBO);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Marker), reinterpret_cast<GLvoid const *>(offsetof(Marker, x)));
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Marker), reinterpret_cast<GLvoid const *>(offsetof(Marker, color)));
+	glDrawArrays(GL_POINTS, first, count);
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDisable(GL_BLEND);
+	glDisable(GL_POINT_SMOOTH);
 }
 
-bool Drawing::DrawingImpl::getCoordFromMouseClick(int x, int y, Coord2D &coord)
+void Drawing::DrawingImpl::drawMarkerQuads(GLint first, GLsizei count)
 {
-	// the user clicked near or directly into the waypoint
-	int left = std::max(0, x - ROBOT_DIAMETER / 2);
-	int right = std::min(static_cast<int>(texture->width()) - 1, x + ROBOT_DIAMETER / 2);
-	int bottom = std::max(0, y - ROBOT_DIAMETER / 2);
-	int top = std::min(static_cast<int>(texture->height()) - 1, y + ROBOT_DIAMETER / 2);
+	GLfloat const radius = ROBOT_DIAMETER / 2.5f;
+	GLfloat const corners[4][2] = {{-1.0f, -1.0f}, {1.0f, -1.0f}, {1.0f, 1.0f}, {-1.0f, 1.0f}};
+	std::vector<Marker> quads;
 
-	for (int i = bottom; i <= top; i++) {
-		for (int j = left; j <= right; j++) {
-			coord = Coord2D(j, i);
+	quads.reserve(4 * count);
 
-			if (room->hasWaypoint(coord)) {
-				return true;
-			}
+	for (GLint i = first; i < first + count; i++) {
+		for (int j = 0; j < 4; j++) {
+			Marker corner = markers[i];
+
+			corner.x += corners[j][0] * radius;
+			corner.y += corners[j][1] * radius;
+			quads.push_back(corner);
 		}
 	}
 
-	return false;
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Marker), &quads[0].x);
+	glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Marker), quads[0].color);
+	glDrawArrays(GL_QUADS, 0, static_cast<GLsizei>(quads.size()));
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+bool Drawing::DrawingImpl::getCoordFromMouseClick(int x, int y, Coord2D &coord)
+{
+	// the user clicked near or directly into the waypoint
+	return room->nearestWaypoint(Coord2D(x, y), ROBOT_DIAMETER / 2, coord);
 }
 
 void Drawing::DrawingImpl::showNeighbours(Coord2D const &coord)
@@ -698,7 +822,7 @@ void Drawing::DrawingImpl::showNeighbours(Coord2D const &coord)
 
 bool Drawing::DrawingImpl::loadRoom(const char *name)
 {
-	fromImage(name);
+	fromImage(name, true);
 	return true;
 }
 
@@ -719,7 +843,8 @@ bool Drawing::DrawingImpl::loadProject(QXmlStreamReader *reader)
 	}
 
 	reader->readNext();
-	fromImage(reader->text().toString().toStdString().c_str());
+	// the waypoints below need the triangulation right away
+	fromImage(reader->text().toString().toStdString().c_str(), false);
 	reader->readNext();
 
 	if (!reader->isEndElement() || reader->name().toString() != "image") {
@@ -745,6 +870,12 @@ bool Drawing::DrawingImpl::loadProject(QXmlStreamReader *reader)
 					room->setAlgorithm(Room::Dijkstra);
 				} else if (reader->text().toString() == "A*") {
 					room->setAlgorithm(Room::AStar);
+				} else if (reader->text().toString() == "Door graph") {
+					room->setAlgorithm(Room::DoorGraph);
+				} else if (reader->text().toString() == "Cluster graph") {
+					room->setAlgorithm(Room::ClusterGraph);
+				} else if (reader->text().toString() == "Contraction hierarchy") {
+					room->setAlgorithm(Room::Contraction);
 				}
 
 				reader->readNext();
@@ -800,6 +931,11 @@ bool Drawing::DrawingImpl::loadProject(QXmlStreamReader *reader)
 
 bool Drawing::DrawingImpl::saveProject(QXmlStreamWriter *writer) const
 {
+	if (room->stage() != Room::StageReady) {
+		statusText_->setText(statusText_->tr("The room is still being loaded, can't save."));
+		return false;
+	}
+
 	writer->writeStartElement("", "drawing");
 
 	writer->writeTextElement("", "image", QString::fromStdString(room->image().filename()));
@@ -826,6 +962,63 @@ bool Drawing::DrawingImpl::saveProject(QXmlStreamWriter *writer) const
 	return !writer->hasError();
 }
 
+// image filename, the show options as bit mask, algorithm and lazy validation, then the room
+bool Drawing::DrawingImpl::loadBinaryProject(BinaryReader &reader)
+{
+	std::string imageName;
+	uint64_t showMask, algorithm, lazy;
+
+	if (!reader.readString(imageName) || !reader.readVarint(showMask) ||
+	    !reader.readVarint(algorithm) || !reader.readVarint(lazy)) {
+		return false;
+	}
+
+	if (algorithm > Room::Contraction) {
+		return false;
+	}
+
+	// the waypoints below need the triangulation right away
+	fromImage(imageName.c_str(), false);
+
+	room->setAlgorithm(static_cast<Room::Algorithm>(algorithm));
+	room->setLazyValidation(lazy != 0);
+
+	if (!room->loadBinaryProject(reader)) {
+		return false;
+	}
+
+	for (size_t i = 0; i < sizeof show_ / sizeof *show_; i++) {
+		show_[i] = showMask & (1u << i);
+	}
+
+	return true;
+}
+
+bool Drawing::DrawingImpl::saveBinaryProject(BinaryWriter &writer) const
+{
+	if (room->stage() != Room::StageReady) {
+		statusText_->setText(statusText_->tr("The room is still being loaded, can't save."));
+		return false;
+	}
+
+	uint64_t showMask = 0;
+
+	for (size_t i = 0; i < sizeof show_ / sizeof *show_; i++) {
+		if (show_[i]) {
+			showMask |= 1u << i;
+		}
+	}
+
+	writer.writeString(room->image().filename());
+	writer.writeVarint(showMask);
+	writer.writeVarint(room->getAlgorithm());
+	writer.writeVarint(room->getLazyValidation());
+
+	room->saveBinaryProject(writer);
+
+	return true;
+}
+
 void Drawing::DrawingImpl::animationForward()
 {
 	if (animationPosition == animationPoints.end()) {
@@ -877,6 +1070,16 @@ Room::Algorithm Drawing::getAlgorithm() const
 	return p->getAlgorithm();
 }
 
+void Drawing::setLazyValidation(bool enabled)
+{
+	p->setLazyValidation(enabled);
+}
+
+bool Drawing::getLazyValidation() const
+{
+	return p->getLazyValidation();
+}
+
 void Drawing::mouseClick(int x, int y)
 {
 	p->mouseClick(x, y);
@@ -922,7 +1125,32 @@ bool Drawing::saveProject(QXmlStreamWriter *writer) const
 	return p->saveProject(writer);
 }
 
+bool Drawing::loadBinaryProject(BinaryReader &reader)
+{
+	return p->loadBinaryProject(reader);
+}
+
+bool Drawing::saveBinaryProject(BinaryWriter &writer) const
+{
+	return p->saveBinaryProject(writer);
+}
+
 void Drawing::animationForward()
 {
 	p->animationForward();
 }
+
+void Drawing::planned(PlanningJob *job)
+{
+	p->planned(job);
+}
+
+void Drawing::roomStageFinished(int stage)
+{
+	p->roomStageFinished(stage);
+}
+
+Room::Stage Drawing::stage() const
+{
+	return p->room->stage();
+}
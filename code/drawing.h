@@ -7,6 +7,9 @@
 
 #include <cstddef>
 
+class BinaryReader;
+class BinaryWriter;
+struct PlanningJob;
 class QTextEdit;
 class QXmlStreamReader;
 class QXmlStreamWriter;
@@ -46,6 +49,8 @@ public:
 	bool getOption(Option option) const;
 	void setAlgorithm(Room::Algorithm algorithm);
 	Room::Algorithm getAlgorithm() const;
+	void setLazyValidation(bool enabled);
+	bool getLazyValidation() const;
 	void mouseClick(int x, int y);
 
 	std::size_t countWaypoints() const;
@@ -54,13 +59,24 @@ public:
 	void paint();
 	void resize(int width, int height);
 	void animate();
+	Room::Stage stage() const;
 
 	bool loadRoom(const char *name);
 	bool loadProject(QXmlStreamReader *reader);
 	bool saveProject(QXmlStreamWriter *writer) const;
+	bool loadBinaryProject(BinaryReader &reader);
+	bool saveBinaryProject(BinaryWriter &writer) const;
+
+Q_SIGNALS:
+	// the room finished one of its preprocessing stages
+	void stageReached(int stage);
+	// another frame is needed even without input, e.g. texture tiles are still pending
+	void repaintNeeded();
 
 private Q_SLOTS:
 	void animationForward();
+	void planned(PlanningJob *job);
+	void roomStageFinished(int stage);
 
 private:
 	class DrawingImpl;
@@ -0,0 +1,569 @@
+#include "floorplan.h"
+#include "pngwriter.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace
+{
+	unsigned char const white[3] = { 255, 255, 255 };
+	unsigned char const black[3] = { 0, 0, 0 };
+	unsigned char const gray[3] = { 200, 200, 200 };
+	unsigned char const doorFloor[3] = { 180, 135, 95 };
+	// random split positions tried before a room is left as it is
+	unsigned int const splitAttempts = 16;
+
+	// half open, [x0, x1) x [y0, y1)
+	struct Rect
+	{
+		Rect(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1);
+
+		unsigned int width() const;
+		unsigned int height() const;
+		uint64_t area() const;
+		Rect grown(unsigned int amount) const;
+		bool intersects(Rect const &other) const;
+
+		unsigned int x0;
+		unsigned int y0;
+		unsigned int x1;
+		unsigned int y1;
+	};
+
+	struct Shape
+	{
+		Shape(Rect const &rect, unsigned char const *colour);
+
+		Rect rect;
+		unsigned char colour[3];
+	};
+
+	// interval [begin, end) along one side of a room
+	struct Door
+	{
+		Door(unsigned int begin, unsigned int end);
+
+		unsigned int begin;
+		unsigned int end;
+	};
+
+	enum Side
+	{
+		SideLeft,
+		SideRight,
+		SideTop,
+		SideBottom
+	};
+
+	// a room that may still be split, with the doors already placed on its walls
+	struct Node
+	{
+		Node(Rect const &rect);
+
+		Rect rect;
+		std::vector<Door> doors[4];
+	};
+
+	// splitmix64, the same plan for the same seed on every platform
+	class Random
+	{
+	public:
+		Random(uint64_t seed);
+
+		uint64_t next();
+		// in [low, high]
+		unsigned int between(unsigned int low, unsigned int high);
+
+	private:
+		uint64_t state_;
+	};
+
+	// orders shapes by their first row
+	struct ShapeTopLess
+	{
+		ShapeTopLess(std::vector<Shape> const &shapes);
+
+		bool operator()(std::size_t a, std::size_t b) const;
+
+		std::vector<Shape> const &shapes;
+	};
+
+	// shapes that ended above the row
+	struct ShapeEnded
+	{
+		ShapeEnded(std::vector<Shape> const &shapes, unsigned int y);
+
+		bool operator()(std::size_t index) const;
+
+		std::vector<Shape> const &shapes;
+		unsigned int y;
+	};
+
+	Rect::Rect(unsigned int x0, unsigned int y0, unsigned int x1, unsigned int y1)
+		: x0(x0),
+		  y0(y0),
+		  x1(x1),
+		  y1(y1)
+	{
+	}
+
+	unsigned int Rect::width() const
+	{
+		return x1 - x0;
+	}
+
+	unsigned int Rect::height() const
+	{
+		return y1 - y0;
+	}
+
+	uint64_t Rect::area() const
+	{
+		return static_cast<uint64_t>(width()) * height();
+	}
+
+	Rect Rect::grown(unsigned int amount) const
+	{
+		return Rect(x0 > amount ? x0 - amount : 0, y0 > amount ? y0 - amount : 0, x1 + amount, y1 + amount);
+	}
+
+	bool Rect::intersects(Rect const &other) const
+	{
+		return x0 < other.x1 && other.x0 < x1 && y0 < other.y1 && other.y0 < y1;
+	}
+
+	Shape::Shape(Rect const &rect, unsigned char const *colour)
+		: rect(rect)
+	{
+		std::memcpy(this->colour, colour, 3);
+	}
+
+	Door::Door(unsigned int begin, unsigned int end)
+		: begin(begin),
+		  end(end)
+	{
+	}
+
+	Node::Node(Rect const &rect)
+		: rect(rect)
+	{
+	}
+
+	Random::Random(uint64_t seed)
+		: state_(seed)
+	{
+	}
+
+	uint64_t Random::next()
+	{
+		state_ += 0x9e3779b97f4a7c15ull;
+
+		uint64_t z = state_;
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+
+		return z ^ (z >> 31);
+	}
+
+	unsigned int Random::between(unsigned int low, unsigned int high)
+	{
+		return low + next() % (static_cast<uint64_t>(high) - low + 1);
+	}
+
+	ShapeTopLess::ShapeTopLess(std::vector<Shape> const &shapes)
+		: shapes(shapes)
+	{
+	}
+
+	bool ShapeTopLess::operator()(std::size_t a, std::size_t b) const
+	{
+		return shapes[a].rect.y0 < shapes[b].rect.y0;
+	}
+
+	ShapeEnded::ShapeEnded(std::vector<Shape> const &shapes, unsigned int y)
+		: shapes(shapes),
+		  y(y)
+	{
+	}
+
+	bool ShapeEnded::operator()(std::size_t index) const
+	{
+		return shapes[index].rect.y1 <= y;
+	}
+}
+
+FloorPlanOptions::FloorPlanOptions()
+	: width(2048),
+	  height(2048),
+	  rooms(32),
+	  obstacles(16),
+	  doorsPerWall(1),
+	  wallThickness(3),
+	  doorWidth(24),
+	  seed(1)
+{
+}
+
+class FloorPlan::FloorPlanImpl
+{
+public:
+	FloorPlanImpl(FloorPlanOptions const &options)
+		: options(options),
+		  random(options.seed),
+		  // rooms and doors keep this distance from walls, doors and obstacles
+		  clearance(options.doorWidth),
+		  minRoomSize(options.doorWidth + 2 * clearance),
+		  // the walls around the building, with a white border outside of them
+		  building(options.wallThickness, options.wallThickness,
+		           options.width - options.wallThickness, options.height - options.wallThickness),
+		  doorCount(0)
+	{
+		if (options.width > maxFloorPlanSize || options.height > maxFloorPlanSize) {
+			throw std::invalid_argument("Floor plans can't be larger than 32768 pixels in either direction.");
+		}
+
+		if (options.rooms == 0 || options.doorsPerWall == 0 || options.wallThickness == 0 || options.doorWidth < 2) {
+			throw std::invalid_argument("A floor plan needs rooms, doors, walls and doors at least 2 pixels wide.");
+		}
+
+		if (options.width < 4 * options.wallThickness + minRoomSize ||
+		    options.height < 4 * options.wallThickness + minRoomSize) {
+			throw std::invalid_argument("The floor plan is too small for a single room.");
+		}
+
+		split();
+		placeObstacles();
+	}
+
+	// repeatedly splits the largest room by a wall with doors, until there are enough rooms
+	void split()
+	{
+		unsigned int const wall = options.wallThickness;
+		std::vector<Node> nodes;
+		std::priority_queue< std::pair<uint64_t, std::size_t> > queue;
+
+		nodes.push_back(Node(Rect(building.x0 + wall, building.y0 + wall, building.x1 - wall, building.y1 - wall)));
+		queue.push(std::make_pair(nodes[0].rect.area(), 0));
+
+		std::size_t roomCount = 1;
+
+		while (!queue.empty()) {
+			std::size_t index = queue.top().second;
+			queue.pop();
+
+			if (roomCount < options.rooms && splitNode(nodes, index)) {
+				roomCount++;
+				queue.push(std::make_pair(nodes[nodes.size() - 2].rect.area(), nodes.size() - 2));
+				queue.push(std::make_pair(nodes[nodes.size() - 1].rect.area(), nodes.size() - 1));
+			} else {
+				leaves.push_back(nodes[index].rect);
+			}
+		}
+	}
+
+	// appends both halves to nodes, false if the room can't be split
+	bool splitNode(std::vector<Node> &nodes, std::size_t index)
+	{
+		Rect const rect = nodes[index].rect;
+		// split across the longer side first, so the rooms stay roughly square
+		bool vertical = rect.width() > rect.height() || (rect.width() == rect.height() && random.next() % 2);
+
+		for (int orientation = 0; orientation < 2; orientation++, vertical = !vertical) {
+			unsigned int position;
+
+			if (!splitPosition(nodes[index], vertical, position)) {
+				continue;
+			}
+
+			unsigned int const wall = options.wallThickness;
+			Node const &node = nodes[index];
+			Node first(vertical ? Rect(rect.x0, rect.y0, position, rect.y1) : Rect(rect.x0, rect.y0, rect.x1, position));
+			Node second(vertical ? Rect(position + wall, rect.y0, rect.x1, rect.y1)
+			                     : Rect(rect.x0, position + wall, rect.x1, rect.y1));
+
+			// the doors on the walls parallel to the new one stay on their side,
+			// the ones on the crossed walls go to the half they're in
+			Side const keptFirst = vertical ? SideLeft : SideTop;
+			Side const keptSecond = vertical ? SideRight : SideBottom;
+			Side const crossed[2] = { vertical ? SideTop : SideLeft, vertical ? SideBottom : SideRight };
+
+			first.doors[keptFirst] = node.doors[keptFirst];
+			second.doors[keptSecond] = node.doors[keptSecond];
+
+			for (int i = 0; i < 2; i++) {
+				std::vector<Door> const &doors = node.doors[crossed[i]];
+
+				for (std::vector<Door>::const_iterator it = doors.begin(); it != doors.end(); ++it) {
+					(it->end <= position ? first : second).doors[crossed[i]].push_back(*it);
+				}
+			}
+
+			std::vector<Door> newDoors = placeDoors(vertical ? rect.y0 : rect.x0, vertical ? rect.y1 : rect.x1);
+
+			for (std::vector<Door>::const_iterator it = newDoors.begin(); it != newDoors.end(); ++it) {
+				first.doors[keptSecond].push_back(*it);
+				second.doors[keptFirst].push_back(*it);
+
+				// the opening in the wall and a line across it in the middle
+				doorShapes.push_back(Shape(vertical ? Rect(position, it->begin, position + wall, it->end)
+				                                    : Rect(it->begin, position, it->end, position + wall), doorFloor));
+				doorLines.push_back(Shape(vertical ? Rect(position + wall / 2, it->begin, position + wall / 2 + 1, it->end)
+				                                   : Rect(it->begin, position + wall / 2, it->end, position + wall / 2 + 1), gray));
+			}
+
+			doorCount += newDoors.size();
+
+			nodes.push_back(first);
+			nodes.push_back(second);
+
+			return true;
+		}
+
+		return false;
+	}
+
+	// a wall position leaving both halves large enough and not crossing any door
+	bool splitPosition(Node const &node, bool vertical, unsigned int &position)
+	{
+		unsigned int const wall = options.wallThickness;
+		unsigned int const begin = vertical ? node.rect.x0 : node.rect.y0;
+		unsigned int const end = vertical ? node.rect.x1 : node.rect.y1;
+
+		if (end - begin < 2 * minRoomSize + wall) {
+			return false;
+		}
+
+		std::vector<Door> const &first = node.doors[vertical ? SideTop : SideLeft];
+		std::vector<Door> const &second = node.doors[vertical ? SideBottom : SideRight];
+
+		for (unsigned int attempt = 0; attempt < splitAttempts; attempt++) {
+			position = random.between(begin + minRoomSize, end - minRoomSize - wall);
+
+			if (!crossesDoor(first, position) && !crossesDoor(second, position)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool crossesDoor(std::vector<Door> const &doors, unsigned int position) const
+	{
+		for (std::vector<Door>::const_iterator it = doors.begin(); it != doors.end(); ++it) {
+			if (position < it->end + clearance && it->begin < position + options.wallThickness + clearance) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// up to doorsPerWall doors along a new wall between begin and end, the first always fits
+	std::vector<Door> placeDoors(unsigned int begin, unsigned int end)
+	{
+		std::vector<Door> doors;
+
+		for (unsigned int attempt = 0; attempt < 4 * options.doorsPerWall && doors.size() < options.doorsPerWall; attempt++) {
+			unsigned int doorBegin = random.between(begin + clearance, end - clearance - options.doorWidth);
+			Door door(doorBegin, doorBegin + options.doorWidth);
+
+			if (!crossesDoor(doors, door)) {
+				doors.push_back(door);
+			}
+		}
+
+		return doors;
+	}
+
+	bool crossesDoor(std::vector<Door> const &doors, Door const &door) const
+	{
+		for (std::vector<Door>::const_iterator it = doors.begin(); it != doors.end(); ++it) {
+			if (door.begin < it->end + clearance && it->begin < door.end + clearance) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// obstacles keep the clearance to the walls and to each other, so no room is cut in two
+	void placeObstacles()
+	{
+		std::vector< std::vector<Rect> > roomObstacles(leaves.size());
+		unsigned int placed = 0;
+
+		for (unsigned int attempt = 0; attempt < 8 * options.obstacles && placed < options.obstacles; attempt++) {
+			std::size_t room = random.next() % leaves.size();
+			Rect const &leaf = leaves[room];
+
+			if (leaf.width() < 2 * clearance + 2 || leaf.height() < 2 * clearance + 2) {
+				continue;
+			}
+
+			Rect const free(leaf.x0 + clearance, leaf.y0 + clearance, leaf.x1 - clearance, leaf.y1 - clearance);
+			unsigned int width = random.between(std::max(2u, free.width() / 8), std::max(2u, free.width() / 3));
+			unsigned int height = random.between(std::max(2u, free.height() / 8), std::max(2u, free.height() / 3));
+			unsigned int x = random.between(free.x0, free.x1 - width);
+			unsigned int y = random.between(free.y0, free.y1 - height);
+			Rect obstacle(x, y, x + width, y + height);
+			bool blocked = false;
+
+			for (std::vector<Rect>::const_iterator it = roomObstacles[room].begin(); it != roomObstacles[room].end(); ++it) {
+				if (it->grown(clearance).intersects(obstacle)) {
+					blocked = true;
+					break;
+				}
+			}
+
+			if (blocked) {
+				continue;
+			}
+
+			roomObstacles[room].push_back(obstacle);
+			obstacleShapes.push_back(Shape(obstacle, black));
+			placed++;
+		}
+	}
+
+	// later shapes are painted over earlier ones
+	std::vector<Shape> shapes()
+	{
+		std::vector<Shape> result;
+
+		for (std::vector<Rect>::const_iterator it = leaves.begin(); it != leaves.end(); ++it) {
+			unsigned char colour[3];
+
+			// anything but white, black and the door gray is inside
+			for (int i = 0; i < 3; i++) {
+				colour[i] = random.between(96, 239);
+			}
+
+			if (colour[0] == 200 && colour[1] == 200 && colour[2] == 200) {
+				colour[0]++;
+			}
+
+			result.push_back(Shape(*it, colour));
+		}
+
+		result.insert(result.end(), doorShapes.begin(), doorShapes.end());
+		result.insert(result.end(), doorLines.begin(), doorLines.end());
+		result.insert(result.end(), obstacleShapes.begin(), obstacleShapes.end());
+
+		return result;
+	}
+
+	// only the shapes crossing the current row are looked at
+	void writePNG(std::string const &filename)
+	{
+		// the room colours depend on the seed only, not on earlier calls
+		random = Random(options.seed ^ 0x5bd1e995u);
+
+		std::vector<Shape> const allShapes = shapes();
+		std::vector<std::size_t> byTop(allShapes.size());
+		std::vector<std::size_t> active;
+		std::size_t nextShape = 0;
+
+		for (std::size_t i = 0; i < byTop.size(); i++) {
+			byTop[i] = i;
+		}
+
+		std::stable_sort(byTop.begin(), byTop.end(), ShapeTopLess(allShapes));
+
+		PNGWriter writer(filename, options.width, options.height);
+		std::vector<unsigned char> row(static_cast<std::size_t>(options.width) * 3);
+
+		for (unsigned int y = 0; y < options.height; y++) {
+			bool added = false;
+
+			while (nextShape < byTop.size() && allShapes[byTop[nextShape]].rect.y0 <= y) {
+				active.push_back(byTop[nextShape++]);
+				added = true;
+			}
+
+			// the shape index is the painting order
+			if (added) {
+				std::sort(active.begin(), active.end());
+			}
+
+			active.erase(std::remove_if(active.begin(), active.end(), ShapeEnded(allShapes, y)), active.end());
+
+			fill(row, 0, options.width, white);
+
+			if (y >= building.y0 && y < building.y1) {
+				fill(row, building.x0, building.x1, black);
+			}
+
+			for (std::vector<std::size_t>::const_iterator it = active.begin(); it != active.end(); ++it) {
+				Shape const &shape = allShapes[*it];
+
+				fill(row, shape.rect.x0, shape.rect.x1, shape.colour);
+			}
+
+			writer.writeRow(&row[0]);
+		}
+
+		writer.finish();
+	}
+
+	void fill(std::vector<unsigned char> &row, unsigned int begin, unsigned int end, unsigned char const *colour) const
+	{
+		for (unsigned int x = begin; x < end; x++) {
+			std::memcpy(&row[static_cast<std::size_t>(x) * 3], colour, 3);
+		}
+	}
+
+	FloorPlanOptions const options;
+	Random random;
+	unsigned int const clearance;
+	unsigned int const minRoomSize;
+	Rect const building;
+	std::vector<Rect> leaves;
+	std::vector<Shape> doorShapes;
+	std::vector<Shape> doorLines;
+	std::vector<Shape> obstacleShapes;
+	std::size_t doorCount;
+};
+
+FloorPlan::FloorPlan(FloorPlanOptions const &options)
+	: p(new FloorPlanImpl(options))
+{
+}
+
+FloorPlan::~FloorPlan()
+{
+	delete p;
+}
+
+unsigned int FloorPlan::width() const
+{
+	return p->options.width;
+}
+
+unsigned int FloorPlan::height() const
+{
+	return p->options.height;
+}
+
+std::size_t FloorPlan::rooms() const
+{
+	return p->leaves.size();
+}
+
+std::size_t FloorPlan::doors() const
+{
+	return p->doorCount;
+}
+
+std::size_t FloorPlan::obstacles() const
+{
+	return p->obstacleShapes.size();
+}
+
+void FloorPlan::writePNG(std::string const &filename) const
+{
+	p->writePNG(filename);
+}
@@ -0,0 +1,56 @@
+#ifndef ROB_FLOORPLAN_H_INCLUDED
+#define ROB_FLOORPLAN_H_INCLUDED
+
+#include <cstddef>
+#include <string>
+
+#include <stdint.h>
+
+// room coordinates have to fit into 15 bits
+unsigned int const maxFloorPlanSize = 1 << 15;
+
+struct FloorPlanOptions
+{
+	FloorPlanOptions();
+
+	unsigned int width;
+	unsigned int height;
+	// fewer rooms are generated if the plan is too small for them
+	unsigned int rooms;
+	// spread over the rooms, always leaving a passage around them
+	unsigned int obstacles;
+	// between the two sides of every wall a room was split by, at least one
+	unsigned int doorsPerWall;
+	unsigned int wallThickness;
+	unsigned int doorWidth;
+	uint64_t seed;
+};
+
+// random building of rectangular rooms in the colours RoomImage expects: white outside,
+// black walls and obstacles, a gray (200) line across every door and other colours inside;
+// every room can be reached from every other one through the doors
+class FloorPlan
+{
+public:
+	// throws std::invalid_argument if the options don't describe a possible plan
+	FloorPlan(FloorPlanOptions const &options);
+	~FloorPlan();
+
+	unsigned int width() const;
+	unsigned int height() const;
+	std::size_t rooms() const;
+	std::size_t doors() const;
+	std::size_t obstacles() const;
+
+	// rasterises the plan row by row, so the size is only limited by the disk
+	void writePNG(std::string const &filename) const;
+
+private:
+	FloorPlan(FloorPlan const &other);
+	FloorPlan &operator=(FloorPlan const &other);
+
+	class FloorPlanImpl;
+	FloorPlanImpl *p;
+};
+
+#endif // ROB_FLOORPLAN_H_INCLUDED
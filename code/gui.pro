@@ -1,42 +1,89 @@
 TEMPLATE = app
 TARGET = gui
 QT += opengl widgets
-LIBS += -lIL -lILU -lGLU -lCGAL -lgmp -lboost_thread
+LIBS += -lGLU -lCGAL -lgmp -lboost_thread
 INCLUDEPATH += .
 QMAKE_CXXFLAGS += -frounding-math -g3 -ggdb3
 
+# qmake CONFIG+=libpng decodes the rooms with libpng instead of DevIL
+libpng {
+	DEFINES += ROB_USE_LIBPNG
+	LIBS += -lpng
+	BENCH_ARGS += CONFIG+=libpng
+} else {
+	LIBS += -lIL -lILU
+	HEADERS += il.h
+	SOURCES += il.cpp
+}
+
+# make bench builds and runs the benchmarks in bench/ with the same decoder, see bench/run.sh
+bench.commands = $$PWD/bench/run.sh $$BENCH_ARGS
+QMAKE_EXTRA_TARGETS += bench
+
 # Input
 HEADERS += algo.h \
+           binarystream.h \
+           classify.h \
+           contraction.h \
            coord.h \
+           cpu.h \
            drawing.h \
            drawwidget.h \
            edge.h \
            gl.h \
-           il.h \
            image.h \
+           linebuffer.h \
            neighbours.h \
            opengldrawwidget.h \
+           parallel.h \
+           planner.h \
+           planningjob.h \
            polygon.h \
+           regiongraph.h \
+           regionmap.h \
+           roadmap.h \
            room.h \
+           roomcache.h \
            roomimage.h \
+           roomloader.h \
+           stats.h \
            texture.h \
+           trace.h \
            triangle.h \
            triangulation.h \
+           viewtransform.h \
+           wallsegments.h \
            widgets.h
 SOURCES += algo.cpp \
+           binarystream.cpp \
+           classify.cpp \
+           contraction.cpp \
            coord.cpp \
+           cpu.cpp \
            drawing.cpp \
            drawwidget.cpp \
            edge.cpp \
            gl.cpp \
-           il.cpp \
            image.cpp \
+           linebuffer.cpp \
            main.cpp \
            opengldrawwidget.cpp \
+           parallel.cpp \
+           planner.cpp \
+           planningjob.cpp \
            polygon.cpp \
+           regiongraph.cpp \
+           regionmap.cpp \
+           roadmap.cpp \
            room.cpp \
+           roomcache.cpp \
            roomimage.cpp \
+           roomloader.cpp \
+           stats.cpp \
            texture.cpp \
+           trace.cpp \
            triangle.cpp \
            triangulation.cpp \
+           viewtransform.cpp \
+           wallsegments.cpp \
            widgets.cpp
@@ -1,9 +1,26 @@
+#ifndef ROB_USE_LIBPNG
 #include "il.h"
 
 #include <IL/ilu.h>
 
 #include <stdexcept>
 
+void initIL()
+{
+	// images are only loaded on the GUI thread
+	static bool initialized = false;
+
+	if (initialized) {
+		return;
+	}
+
+	ilInit();
+	iluInit();
+	checkILError();
+
+	initialized = true;
+}
+
 void checkILError()
 {
 	ILenum ilError = ilGetError();
@@ -13,3 +30,4 @@ void checkILError()
 		throw std::runtime_error(cString);
 	}
 }
+#endif
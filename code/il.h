@@ -1,6 +1,10 @@
 #ifndef ROB_IL_H_INCLUDED
 #define ROB_IL_H_INCLUDED
 
+// only part of the DevIL build, CONFIG+=libpng leaves il.cpp out
+
+// initialises DevIL on the first call only
+void initIL();
 void checkILError();
 
 #endif // ROB_IL_H_INCLUDED
@@ -1,17 +1,124 @@
-#include "il.h"
 #include "image.h"
 
+#include <cstddef>
+#include <stdexcept>
+
+#ifdef ROB_USE_LIBPNG
+#include <png.h>
+
+#include <cstdio>
+#else
+#include "il.h"
+
 #include <IL/il.h>
 #include <IL/ilu.h>
+#endif
 
-#include <stdexcept>
+#ifdef ROB_USE_LIBPNG
+namespace
+{
+	struct PNGFile
+	{
+		PNGFile(std::string const &filename)
+			: file(std::fopen(filename.c_str(), "rb")),
+			  png(0),
+			  info(0)
+		{
+		}
+
+		~PNGFile()
+		{
+			if (png) {
+				png_destroy_read_struct(&png, info ? &info : 0, 0);
+			}
+
+			if (file) {
+				std::fclose(file);
+			}
+		}
+
+		std::FILE *file;
+		png_structp png;
+		png_infop info;
+	};
+
+	void decodePNG(std::string const &filename, unsigned int &width, unsigned int &height,
+	               Image::ImageType &type, std::vector<unsigned char> &data);
+
+	// decodes straight into data, every row pointer points into it
+	void decodePNG(std::string const &filename, unsigned int &width, unsigned int &height,
+	               Image::ImageType &type, std::vector<unsigned char> &data)
+	{
+		PNGFile pngFile(filename);
+
+		if (!pngFile.file) {
+			throw std::runtime_error("Cannot open " + filename + ".");
+		}
+
+		pngFile.png = png_create_read_struct(PNG_LIBPNG_VER_STRING, 0, 0, 0);
+
+		if (!pngFile.png) {
+			throw std::runtime_error("Cannot create the PNG reader.");
+		}
+
+		std::vector<png_bytep> rows;
+
+		pngFile.info = png_create_info_struct(pngFile.png);
+
+		if (!pngFile.info) {
+			throw std::runtime_error("Cannot create the PNG reader.");
+		}
+
+		// nothing with a destructor may be created between here and png_read_end()
+		if (setjmp(png_jmpbuf(pngFile.png))) {
+			throw std::runtime_error("Cannot decode " + filename + ".");
+		}
+
+		png_init_io(pngFile.png, pngFile.file);
+		png_read_info(pngFile.png, pngFile.info);
+
+		png_byte colorType = png_get_color_type(pngFile.png, pngFile.info);
+
+		switch (colorType) {
+			case PNG_COLOR_TYPE_RGB:
+				type = Image::IMAGE_TYPE_RGB;
+				break;
+
+			case PNG_COLOR_TYPE_RGB_ALPHA:
+				type = Image::IMAGE_TYPE_RGBA;
+				break;
+
+			default:
+				throw std::runtime_error("Only RGB and RBGA images supported.");
+		}
+
+		png_set_strip_16(pngFile.png);
+		png_read_update_info(pngFile.png, pngFile.info);
+
+		width = png_get_image_width(pngFile.png, pngFile.info);
+		height = png_get_image_height(pngFile.png, pngFile.info);
+
+		std::size_t rowBytes = png_get_rowbytes(pngFile.png, pngFile.info);
+		data.resize(rowBytes * height);
+		rows.resize(height);
+
+		for (unsigned int y = 0; y < height; y++) {
+			rows[y] = &data[y * rowBytes];
+		}
+
+		png_read_image(pngFile.png, &rows[0]);
+		png_read_end(pngFile.png, 0);
+	}
+}
+#endif
 
 Image::Image(std::string const &filename)
 	: filename_(filename)
 {
-	ilInit();
-	iluInit();
-	checkILError();
+#ifdef ROB_USE_LIBPNG
+	decodePNG(filename, width_, height_, type_, data_);
+#else
+	initIL();
 
 	ILuint handle;
 	ilGenImages(1, &handle);
@@ -21,16 +128,16 @@ Image::Image(std::string const &filename)
 		ilLoad(IL_PNG, filename.c_str());
 		checkILError();
 
-		ILenum format;
+		std::size_t bytesPerPixel;
 
 		switch (ilGetInteger(IL_IMAGE_FORMAT)) {
 			case IL_RGB:
-				format = IL_RGB;
+				bytesPerPixel = 3;
 				type_ = IMAGE_TYPE_RGB;
 				break;
 
 			case IL_RGBA:
-				format = IL_RGBA;
+				bytesPerPixel = 4;
 				type_ = IMAGE_TYPE_RGBA;
 				break;
 
@@ -46,37 +153,15 @@ Image::Image(std::string const &filename)
 		width_ = static_cast<unsigned int>(ilGetInteger(IL_IMAGE_WIDTH));
 		height_ = static_cast<unsigned int>(ilGetInteger(IL_IMAGE_HEIGHT));
 
-		if (format == IL_RGB) {
-			data_.reserve(width_ * height_ * 3);
-		} else {
-			data_.reserve(width_ * height_ * 4);
-		}
-
-		for (unsigned int y = 0; y < height_; y++) {
-			for (unsigned int x = 0; x < width_; x++) {
-				unsigned char *dataPointer;
-
-				if (format == IL_RGB) {
-					dataPointer = data + (y * width_ + x) * 3;
-				} else {
-					dataPointer = data + (y * width_ + x) * 4;
-				}
-
-				data_.push_back(dataPointer[0]);
-				data_.push_back(dataPointer[1]);
-				data_.push_back(dataPointer[2]);
-
-				if (format == IL_RGBA) {
-					data_.push_back(dataPointer[3]);
-				}
-			}
-		}
+		// DevIL stores the pixels tightly packed in the same layout, one copy is enough
+		data_.assign(data, data + static_cast<std::size_t>(width_) * height_ * bytesPerPixel);
 
 		ilDeleteImages(1, &handle);
 	} catch (...) {
 		ilDeleteImages(1, &handle);
 		throw;
 	}
+#endif
 }
 
 unsigned int Image::width() const
@@ -103,3 +188,8 @@ std::string const &Image::filename() const
 {
 	return filename_;
 }
+
+void Image::releaseData()
+{
+	std::vector<unsigned char>().swap(data_);
+}
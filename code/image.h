@@ -19,6 +19,8 @@ public:
 	std::vector<unsigned char> const &data() const;
 	ImageType type() const;
 	std::string const &filename() const;
+	// frees the pixels once nothing needs the colours anymore, width() and height() stay
+	void releaseData();
 
 private:
 	unsigned int width_;
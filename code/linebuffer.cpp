@@ -0,0 +1,185 @@
+#define GL_GLEXT_PROTOTYPES
+
+#include "gl.h"
+#include "linebuffer.h"
+
+#ifdef WIN32
+#include <GL/glew.h>
+#endif
+#include <GL/gl.h>
+
+#include <map>
+#include <set>
+#include <utility>
+
+class LineBuffer::LineBufferImpl
+{
+public:
+	LineBufferImpl();
+	~LineBufferImpl();
+
+	void upload();
+	void draw();
+
+	GLuint vertexBuffer;
+	GLuint indexBuffer;
+	GLenum mode;
+	bool indexed;
+	bool dirty;
+	std::vector<GLfloat> vertices;
+	std::vector<GLuint> indices;
+	GLsizei count;
+};
+
+LineBuffer::LineBufferImpl::LineBufferImpl()
+	: vertexBuffer(0),
+	  indexBuffer(0),
+	  mode(GL_LINES),
+	  indexed(false),
+	  dirty(false),
+	  count(0)
+{
+}
+
+LineBuffer::LineBufferImpl::~LineBufferImpl()
+{
+	if (vertexBuffer != 0) {
+		glDeleteBuffers(1, &vertexBuffer);
+		glDeleteBuffers(1, &indexBuffer);
+	}
+}
+
+void LineBuffer::LineBufferImpl::upload()
+{
+	if (vertexBuffer == 0) {
+		glGenBuffers(1, &vertexBuffer);
+		glGenBuffers(1, &indexBuffer);
+		checkGLError();
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat),
+	             vertices.empty() ? 0 : &vertices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(GLuint),
+	             indices.empty() ? 0 : &indices[0], GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	checkGLError();
+
+	indexed = !indices.empty();
+	count = indexed ? indices.size() : vertices.size() / 2;
+
+	// the data lives on the GPU now
+	std::vector<GLfloat>().swap(vertices);
+	std::vector<GLuint>().swap(indices);
+	dirty = false;
+}
+
+void LineBuffer::LineBufferImpl::draw()
+{
+	if (dirty) {
+		upload();
+	}
+
+	if (count == 0) {
+		return;
+	}
+
+	// keep the vertex array state of the caller
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+
+	glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(2, GL_FLOAT, 0, 0);
+
+	if (indexed) {
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+		glDrawElements(mode, count, GL_UNSIGNED_INT, 0);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	} else {
+		glDrawArrays(mode, 0, count);
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glPopClientAttrib();
+}
+
+LineBuffer::LineBuffer()
+	: p(new LineBufferImpl)
+{
+}
+
+LineBuffer::~LineBuffer()
+{
+	delete p;
+}
+
+void LineBuffer::setTriangles(std::vector<Triangle> const &triangles, unsigned int height)
+{
+	std::map<Coord2D, GLuint> vertexIndices;
+	// neighbouring triangles share edges, draw each of them only once
+	std::set< std::pair<GLuint, GLuint> > edges;
+
+	p->vertices.clear();
+	p->indices.clear();
+
+	for (std::vector<Triangle>::const_iterator it = triangles.begin(); it != triangles.end(); ++it) {
+		GLuint corners[3];
+
+		for (int i = 0; i < 3; i++) {
+			Coord2D const &coord = (*it)[i];
+			std::map<Coord2D, GLuint>::const_iterator found = vertexIndices.find(coord);
+
+			if (found == vertexIndices.end()) {
+				corners[i] = p->vertices.size() / 2;
+				vertexIndices[coord] = corners[i];
+				p->vertices.push_back(coord.x);
+				p->vertices.push_back(height - 1.0f - coord.y);
+			} else {
+				corners[i] = found->second;
+			}
+		}
+
+		for (int i = 0; i < 3; i++) {
+			GLuint first = corners[i];
+			GLuint second = corners[(i + 1) % 3];
+			std::pair<GLuint, GLuint> edge = first < second ? std::make_pair(first, second) : std::make_pair(second, first);
+
+			if (edges.insert(edge).second) {
+				p->indices.push_back(edge.first);
+				p->indices.push_back(edge.second);
+			}
+		}
+	}
+
+	p->mode = GL_LINES;
+	p->dirty = true;
+}
+
+void LineBuffer::setLineStrip(std::vector< Coord2DTemplate<float> > const &points, unsigned int height)
+{
+	p->vertices.clear();
+	p->indices.clear();
+
+	for (std::vector< Coord2DTemplate<float> >::const_iterator it = points.begin(); it != points.end(); ++it) {
+		p->vertices.push_back(it->x);
+		p->vertices.push_back(height - 1.0f - it->y);
+	}
+
+	p->mode = GL_LINE_STRIP;
+	p->dirty = true;
+}
+
+void LineBuffer::setSegments(std::vector< Coord2DTemplate<float> > const &points, unsigned int height)
+{
+	setLineStrip(points, height);
+
+	p->mode = GL_LINES;
+}
+
+void LineBuffer::draw() const
+{
+	p->draw();
+}
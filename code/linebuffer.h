@@ -0,0 +1,32 @@
+#ifndef ROB_LINEBUFFER_H_INCLUDED
+#define ROB_LINEBUFFER_H_INCLUDED
+
+#include "coord.h"
+#include "triangle.h"
+
+#include <vector>
+
+// line geometry kept in vertex buffers, uploaded on the next draw() after it changed
+class LineBuffer
+{
+public:
+	LineBuffer();
+	~LineBuffer();
+
+	// the y coordinates are flipped with the given image height
+	void setTriangles(std::vector<Triangle> const &triangles, unsigned int height);
+	void setLineStrip(std::vector< Coord2DTemplate<float> > const &points, unsigned int height);
+	// every two points form one line
+	void setSegments(std::vector< Coord2DTemplate<float> > const &points, unsigned int height);
+
+	void draw() const;
+
+private:
+	LineBuffer(LineBuffer const &other);
+	LineBuffer &operator=(LineBuffer const &other);
+
+	class LineBufferImpl;
+	LineBufferImpl *p;
+};
+
+#endif // ROB_LINEBUFFER_H_INCLUDED
@@ -1,3 +1,4 @@
+#include "trace.h"
 #include "widgets.h"
 
 #include <QtCore/QTimer>
@@ -5,7 +6,9 @@
 
 #include <csignal>
 #include <cstdio>
+#include <cstring>
 #include <stdexcept>
+#include <string>
 
 namespace
 {
@@ -18,6 +21,17 @@ namespace
 int main(int argc, char **argv)
 {
 	QApplication application(argc, argv);
+
+	// --trace=file records spans from the start and writes them on exit
+	std::string traceFilename;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strncmp(argv[i], "--trace=", 8) == 0) {
+			traceFilename = argv[i] + 8;
+			setTracingEnabled(true);
+		}
+	}
+
 	MainWindow mainWindow;
 
 	mainWindow.show();
@@ -34,6 +48,11 @@ int main(int argc, char **argv)
 	timer.start(1000);
 
 	int result = application.exec();
+
+	if (!traceFilename.empty() && !writeTrace(traceFilename)) {
+		std::fprintf(stderr, "Cannot write the trace to %s.\n", traceFilename.c_str());
+	}
+
 	return result;
 }
 
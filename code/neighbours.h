@@ -5,7 +5,10 @@
 
 #include <map>
 #include <set>
+#include <utility>
 
 typedef std::map< Coord2D, std::set<Coord2D> > NeighboursMap;
+// an edge of a NeighboursMap, smaller coordinate first
+typedef std::pair<Coord2D, Coord2D> RoadmapEdge;
 
 #endif // ROB_NEIGHBOURS_H_INCLUDED
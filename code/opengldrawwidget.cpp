@@ -9,6 +9,9 @@ OpenGLDrawWidget::OpenGLDrawWidget(Drawing *drawing, QWidget *parent)
 {
 	setAutoFillBackground(false);
 
+	// the next texture tiles are uploaded in the next frame
+	connect(drawing, SIGNAL(repaintNeeded()), this, SLOT(update()));
+
 	QTimer *timer = new QTimer(this);
 	connect(timer, SIGNAL(timeout()), this, SLOT(update()));
 	timer->start(0);
@@ -0,0 +1,75 @@
+#include "parallel.h"
+
+#include <algorithm>
+
+#include <boost/thread.hpp>
+
+namespace
+{
+	struct BandQueue
+	{
+		BandQueue(unsigned int rows, unsigned int bandRows,
+		          boost::function<void (unsigned int, unsigned int)> const &work)
+			: rows(rows),
+			  bandRows(bandRows),
+			  nextRow(0),
+			  work(work)
+		{
+		}
+
+		// bands are handed out one by one, so fast threads just take more of them
+		bool takeBand(unsigned int &begin, unsigned int &end)
+		{
+			boost::lock_guard<boost::mutex> lock(mutex);
+
+			if (nextRow >= rows) {
+				return false;
+			}
+
+			begin = nextRow;
+			end = std::min(rows, nextRow + bandRows);
+			nextRow = end;
+
+			return true;
+		}
+
+		void operator()()
+		{
+			unsigned int begin;
+			unsigned int end;
+
+			while (takeBand(begin, end)) {
+				work(begin, end);
+			}
+		}
+
+		unsigned int const rows;
+		unsigned int const bandRows;
+		unsigned int nextRow;
+		boost::mutex mutex;
+		boost::function<void (unsigned int, unsigned int)> const &work;
+	};
+}
+
+void forEachBand(unsigned int rows, unsigned int bandRows,
+                 boost::function<void (unsigned int, unsigned int)> const &work)
+{
+	BandQueue queue(rows, std::max(bandRows, 1u), work);
+	unsigned int bands = (rows + queue.bandRows - 1) / queue.bandRows;
+	unsigned int threads = std::min(std::max(boost::thread::hardware_concurrency(), 1u), bands);
+
+	if (threads <= 1) {
+		queue();
+		return;
+	}
+
+	boost::thread_group group;
+
+	// the calling thread works on the bands too
+	for (unsigned int i = 1; i < threads; i++) {
+		group.create_thread(boost::ref(queue));
+	}
+
+	queue();
+	group.join_all();
+}
@@ -0,0 +1,11 @@
+#ifndef ROB_PARALLEL_H_INCLUDED
+#define ROB_PARALLEL_H_INCLUDED
+
+#include <boost/function.hpp>
+
+// calls work(begin, end) for every band of at most bandRows rows out of [0, rows),
+// threads take the next unprocessed band until none is left and all are done on return
+void forEachBand(unsigned int rows, unsigned int bandRows,
+                 boost::function<void (unsigned int, unsigned int)> const &work);
+
+#endif // ROB_PARALLEL_H_INCLUDED
@@ -0,0 +1,123 @@
+#include "algo.h"
+#include "planner.h"
+#include "planningjob.h"
+#include "room.h"
+#include "trace.h"
+
+#include <algorithm>
+
+#include <QtCore/QElapsedTimer>
+
+Planner::Planner(Room *room, QObject *parent)
+	: QObject(parent),
+	  room_(room),
+	  worker_(new PlannerWorker(room)),
+	  generation_(0)
+{
+	qRegisterMetaType<PlanningJob *>();
+
+	worker_->moveToThread(&thread_);
+
+	connect(this, SIGNAL(requested(PlanningJob *)), worker_, SLOT(run(PlanningJob *)), Qt::QueuedConnection);
+	connect(worker_, SIGNAL(finished(PlanningJob *)), this, SLOT(finished(PlanningJob *)), Qt::QueuedConnection);
+
+	thread_.start();
+}
+
+Planner::~Planner()
+{
+	// the running job notices this and stops, queued ones are dropped with the thread
+	generation_.fetchAndAddOrdered(1);
+
+	thread_.quit();
+	thread_.wait();
+
+	delete worker_;
+
+	for (std::set<PlanningJob *>::const_iterator it = jobs_.begin(); it != jobs_.end(); ++it) {
+		delete *it;
+	}
+}
+
+void Planner::plan()
+{
+	PlanningJob *job = room_->createPlanningJob();
+
+	job->generation = generation_.fetchAndAddOrdered(1) + 1;
+	job->currentGeneration = &generation_;
+	job->requestTimer.start();
+
+	jobs_.insert(job);
+
+	emit requested(job);
+}
+
+void Planner::finished(PlanningJob *job)
+{
+	if (jobs_.erase(job) == 0) {
+		return;
+	}
+
+	if (job->cancelled()) {
+		delete job;
+		return;
+	}
+
+	room_->storePlanningJob(*job);
+
+	emit planned(job);
+}
+
+PlannerWorker::PlannerWorker(Room const *room)
+	: room_(room)
+{
+}
+
+void PlannerWorker::run(PlanningJob *job)
+{
+	if (job->cancelled()) {
+		emit finished(job);
+		return;
+	}
+
+	TRACE_SPAN("planning job");
+
+	room_->runPlanningJob(*job);
+
+	if (job->cancelled() || job->path.empty()) {
+		emit finished(job);
+		return;
+	}
+
+	std::vector<Coord2D> &path = job->path;
+
+	if (path.begin()->x > path.rbegin()->x) {
+		std::reverse(path.begin(), path.end());
+	}
+
+	QElapsedTimer timer;
+
+	timer.start();
+
+	job->pathPoints = catmullRom(path, 150);
+
+	job->catmullRomTime = timer.nsecsElapsed();
+
+	TRACE_SPAN("pointInside loop");
+
+	timer.start();
+
+	for (std::vector< Coord2DTemplate<float> >::const_iterator it = job->pathPoints.begin(); it != job->pathPoints.end(); ++it) {
+		if (job->cancelled()) {
+			break;
+		}
+
+		if (!room_->pointInside(it->x, it->y)) {
+			job->pathCollisions.insert(*it);
+		}
+	}
+
+	job->collisionTime = timer.nsecsElapsed();
+
+	emit finished(job);
+}
@@ -0,0 +1,62 @@
+#ifndef ROB_PLANNER_H_INCLUDED
+#define ROB_PLANNER_H_INCLUDED
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QObject>
+#include <QtCore/QThread>
+
+#include <set>
+
+struct PlanningJob;
+class Room;
+
+// lives on the planner thread
+class PlannerWorker
+	: public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit PlannerWorker(Room const *room);
+
+Q_SIGNALS:
+	void finished(PlanningJob *job);
+
+public Q_SLOTS:
+	void run(PlanningJob *job);
+
+private:
+	Room const *room_;
+};
+
+// runs the planning jobs of a room on its own thread, only the newest job is delivered
+class Planner
+	: public QObject
+{
+	Q_OBJECT
+
+public:
+	explicit Planner(Room *room, QObject *parent = 0);
+	~Planner();
+
+	// cancels every older job which isn't finished yet
+	void plan();
+
+Q_SIGNALS:
+	// the receiver owns the job
+	void planned(PlanningJob *job);
+	void requested(PlanningJob *job);
+
+private Q_SLOTS:
+	void finished(PlanningJob *job);
+
+private:
+	Room *room_;
+	QThread thread_;
+	PlannerWorker *worker_;
+	QAtomicInt generation_;
+	// jobs queued or running on the worker thread
+	std::set<PlanningJob *> jobs_;
+};
+
+#endif // ROB_PLANNER_H_INCLUDED
@@ -0,0 +1,24 @@
+#include "planningjob.h"
+
+PlanningJob::PlanningJob()
+	: generation(0),
+	  currentGeneration(0),
+	  version(0),
+	  algorithm(Room::Dijkstra),
+	  lazyValidation(false),
+	  roadmapValidated(false),
+	  roadmapCached(false),
+	  edgeValidations(0),
+	  nodesExpanded(0),
+	  validationTime(0),
+	  hierarchyTime(0),
+	  pathTime(0),
+	  catmullRomTime(0),
+	  collisionTime(0)
+{
+}
+
+bool PlanningJob::cancelled() const
+{
+	return currentGeneration && currentGeneration->load() != generation;
+}
@@ -0,0 +1,75 @@
+#ifndef ROB_PLANNINGJOB_H_INCLUDED
+#define ROB_PLANNINGJOB_H_INCLUDED
+
+#include "coord.h"
+#include "neighbours.h"
+#include "room.h"
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMetaType>
+#include <QtCore/QSharedPointer>
+
+#include <stdint.h>
+
+class ContractionHierarchy;
+class RegionGraph;
+
+// snapshot of everything a path query needs, so it can be answered
+// away from the room while the user keeps editing it
+struct PlanningJob
+{
+	PlanningJob();
+
+	// true if a newer job was requested in the meantime
+	bool cancelled() const;
+
+	int generation;
+	QAtomicInt const *currentGeneration;
+	QElapsedTimer requestTimer;
+
+	unsigned long version;
+	Room::Algorithm algorithm;
+	bool lazyValidation;
+	Coord2D startpoint;
+	Coord2D endpoint;
+	// shared with the room when it's an already validated or a cached lazy roadmap,
+	// lazy jobs never modify it
+	QSharedPointer<NeighboursMap> roadmap;
+	bool roadmapValidated;
+	bool roadmapCached;
+	// lazy mode validation results of earlier jobs, shared with the room
+	QSharedPointer< std::map<RoadmapEdge, bool> const > knownEdges;
+	// lazy mode validation results of this job only, merged into the room's when it's stored
+	std::map<RoadmapEdge, bool> validatedEdges;
+	// edges of roadmap the search has to leave out, found invalid by this job
+	std::set<RoadmapEdge> removedEdges;
+	// door graph of the validated roadmap, shared with the room once built
+	QSharedPointer<RegionGraph> regionGraph;
+	// graph of an older roadmap, regions the edits didn't touch are taken from it
+	QSharedPointer<RegionGraph> previousRegionGraph;
+	// contraction hierarchy of the validated roadmap, shared with the room once built
+	QSharedPointer<ContractionHierarchy> contractionHierarchy;
+
+	std::vector<Coord2D> path;
+	std::vector< Coord2DTemplate<float> > pathPoints;
+	std::set< Coord2DTemplate<float> > pathCollisions;
+	uint64_t edgeValidations;
+	uint64_t nodesExpanded;
+	// all in nanoseconds
+	uint64_t validationTime;
+	// building a region graph or contraction hierarchy
+	uint64_t hierarchyTime;
+	uint64_t pathTime;
+	uint64_t catmullRomTime;
+	uint64_t collisionTime;
+};
+
+Q_DECLARE_METATYPE(PlanningJob *)
+
+#endif // ROB_PLANNINGJOB_H_INCLUDED
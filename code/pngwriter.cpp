@@ -0,0 +1,248 @@
+#include "pngwriter.h"
+
+#include <cstdio>
+#include <stdexcept>
+#include <vector>
+
+#include <zlib.h>
+
+namespace
+{
+	unsigned char const signature[8] = { 137, 'P', 'N', 'G', '\r', '\n', 26, '\n' };
+	// compressed bytes per IDAT chunk
+	std::size_t const chunkSize = 1 << 20;
+
+	void appendU32(std::vector<unsigned char> &buffer, unsigned long value);
+
+	// PNG stores everything big endian
+	void appendU32(std::vector<unsigned char> &buffer, unsigned long value)
+	{
+		buffer.push_back((value >> 24) & 0xff);
+		buffer.push_back((value >> 16) & 0xff);
+		buffer.push_back((value >> 8) & 0xff);
+		buffer.push_back(value & 0xff);
+	}
+}
+
+class PNGWriter::PNGWriterImpl
+{
+public:
+	PNGWriterImpl(std::string const &filename, unsigned int width, unsigned int height)
+		: filename(filename),
+		  file(0),
+		  width(width),
+		  height(height),
+		  rowsWritten(0),
+		  finished(false),
+		  previousRow(static_cast<std::size_t>(width) * 3),
+		  filteredRow(static_cast<std::size_t>(width) * 3 + 1),
+		  compressed(chunkSize)
+	{
+		if (width == 0 || height == 0) {
+			throw std::invalid_argument("A PNG needs at least one pixel.");
+		}
+
+		file = std::fopen(filename.c_str(), "wb");
+
+		if (!file) {
+			throw std::runtime_error("Cannot open " + filename + ".");
+		}
+
+		stream.zalloc = Z_NULL;
+		stream.zfree = Z_NULL;
+		stream.opaque = Z_NULL;
+
+		// the rows are mostly runs of zeros after the up filter, which is all
+		// the run length strategy looks for
+		if (deflateInit2(&stream, Z_BEST_SPEED, Z_DEFLATED, 15, 8, Z_RLE) != Z_OK) {
+			std::fclose(file);
+			throw std::runtime_error("Cannot create the PNG compressor.");
+		}
+
+		stream.next_out = &compressed[0];
+		stream.avail_out = compressed.size();
+
+		std::vector<unsigned char> header;
+
+		appendU32(header, width);
+		appendU32(header, height);
+		// 8 bit RGB, deflate, adaptive filtering, no interlacing
+		header.push_back(8);
+		header.push_back(2);
+		header.push_back(0);
+		header.push_back(0);
+		header.push_back(0);
+
+		// the destructor doesn't run for a throwing constructor
+		try {
+			write(signature, sizeof signature);
+			writeChunk("IHDR", &header[0], header.size());
+		} catch (...) {
+			deflateEnd(&stream);
+			std::fclose(file);
+			throw;
+		}
+	}
+
+	~PNGWriterImpl()
+	{
+		deflateEnd(&stream);
+
+		if (file) {
+			std::fclose(file);
+		}
+	}
+
+	void writeRow(unsigned char const *rgb)
+	{
+		if (finished || rowsWritten == height) {
+			throw std::logic_error("All rows of " + filename + " were already written.");
+		}
+
+		// up filter, every byte minus the one above it
+		filteredRow[0] = 2;
+
+		for (std::size_t i = 0; i < previousRow.size(); i++) {
+			filteredRow[i + 1] = rgb[i] - previousRow[i];
+		}
+
+		previousRow.assign(rgb, rgb + previousRow.size());
+		rowsWritten++;
+
+		compress(&filteredRow[0], filteredRow.size(), Z_NO_FLUSH);
+	}
+
+	void finish()
+	{
+		if (finished) {
+			return;
+		}
+
+		if (rowsWritten != height) {
+			throw std::logic_error("Not all rows of " + filename + " were written.");
+		}
+
+		compress(0, 0, Z_FINISH);
+		flushChunk();
+		writeChunk("IEND", 0, 0);
+
+		finished = true;
+
+		int result = std::fclose(file);
+		file = 0;
+
+		if (result != 0) {
+			throw std::runtime_error("Cannot write " + filename + ".");
+		}
+	}
+
+	void compress(unsigned char const *data, std::size_t size, int flush)
+	{
+		stream.next_in = const_cast<unsigned char *>(data);
+		stream.avail_in = size;
+
+		while (true) {
+			int result = deflate(&stream, flush);
+
+			if (result == Z_STREAM_ERROR) {
+				throw std::runtime_error("Cannot compress " + filename + ".");
+			}
+
+			if (stream.avail_out == 0) {
+				flushChunk();
+				continue;
+			}
+
+			if (flush == Z_FINISH ? result == Z_STREAM_END : stream.avail_in == 0) {
+				return;
+			}
+		}
+	}
+
+	// writes the compressed bytes so far as one IDAT chunk
+	void flushChunk()
+	{
+		std::size_t size = compressed.size() - stream.avail_out;
+
+		if (size != 0) {
+			writeChunk("IDAT", &compressed[0], size);
+		}
+
+		stream.next_out = &compressed[0];
+		stream.avail_out = compressed.size();
+	}
+
+	// length, type, data, then the CRC of type and data
+	void writeChunk(char const *type, unsigned char const *data, std::size_t size)
+	{
+		std::vector<unsigned char> buffer;
+
+		appendU32(buffer, size);
+
+		unsigned char const *typeBytes = reinterpret_cast<unsigned char const *>(type);
+		uLong crc = crc32(0, Z_NULL, 0);
+
+		crc = crc32(crc, typeBytes, 4);
+
+		// a null buffer would reset the CRC
+		if (size != 0) {
+			crc = crc32(crc, data, size);
+		}
+
+		write(&buffer[0], buffer.size());
+		write(typeBytes, 4);
+		write(data, size);
+
+		buffer.clear();
+		appendU32(buffer, crc);
+		write(&buffer[0], buffer.size());
+	}
+
+	void write(unsigned char const *data, std::size_t size)
+	{
+		if (size != 0 && std::fwrite(data, 1, size, file) != size) {
+			throw std::runtime_error("Cannot write " + filename + ".");
+		}
+	}
+
+	std::string const filename;
+	std::FILE *file;
+	unsigned int const width;
+	unsigned int const height;
+	unsigned int rowsWritten;
+	bool finished;
+	z_stream stream;
+	std::vector<unsigned char> previousRow;
+	std::vector<unsigned char> filteredRow;
+	std::vector<unsigned char> compressed;
+};
+
+PNGWriter::PNGWriter(std::string const &filename, unsigned int width, unsigned int height)
+	: p(new PNGWriterImpl(filename, width, height))
+{
+}
+
+PNGWriter::~PNGWriter()
+{
+	delete p;
+}
+
+void PNGWriter::writeRow(unsigned char const *rgb)
+{
+	p->writeRow(rgb);
+}
+
+void PNGWriter::finish()
+{
+	p->finish();
+}
+
+unsigned int PNGWriter::width() const
+{
+	return p->width;
+}
+
+unsigned int PNGWriter::height() const
+{
+	return p->height;
+}
@@ -0,0 +1,30 @@
+#ifndef ROB_PNGWRITER_H_INCLUDED
+#define ROB_PNGWRITER_H_INCLUDED
+
+#include <string>
+
+// writes an 8 bit RGB PNG row by row, only the compressed data is buffered, so
+// images far larger than the memory can be written
+class PNGWriter
+{
+public:
+	PNGWriter(std::string const &filename, unsigned int width, unsigned int height);
+	~PNGWriter();
+
+	// width() * 3 bytes, the rows from top to bottom
+	void writeRow(unsigned char const *rgb);
+	// after the last row, the file is incomplete without it
+	void finish();
+
+	unsigned int width() const;
+	unsigned int height() const;
+
+private:
+	PNGWriter(PNGWriter const &other);
+	PNGWriter &operator=(PNGWriter const &other);
+
+	class PNGWriterImpl;
+	PNGWriterImpl *p;
+};
+
+#endif // ROB_PNGWRITER_H_INCLUDED
@@ -0,0 +1,494 @@
+#include "regiongraph.h"
+#include "trace.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <map>
+#include <queue>
+
+#include <QtCore/QMutexLocker>
+
+namespace
+{
+	struct QueueEntry
+	{
+		QueueEntry(float priority, float distance, uint32_t node);
+
+		bool operator>(QueueEntry const &other) const;
+
+		// distance plus the estimate to the goal
+		float priority;
+		float distance;
+		uint32_t node;
+	};
+
+	typedef std::priority_queue< QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > Queue;
+
+	float estimate(Coord2D const &from, Coord2D const &to);
+	uint64_t mix(uint64_t hash, uint64_t value);
+
+	QueueEntry::QueueEntry(float priority, float distance, uint32_t node)
+		: priority(priority),
+		  distance(distance),
+		  node(node)
+	{
+	}
+
+	bool QueueEntry::operator>(QueueEntry const &other) const
+	{
+		return priority > other.priority;
+	}
+
+	// straight line, never more than the length of a path along the roadmap
+	float estimate(Coord2D const &from, Coord2D const &to)
+	{
+		float dx = static_cast<float>(from.x) - static_cast<float>(to.x);
+		float dy = static_cast<float>(from.y) - static_cast<float>(to.y);
+
+		return std::sqrt(dx * dx + dy * dy);
+	}
+
+	// FNV-1a over all eight bytes of value
+	uint64_t mix(uint64_t hash, uint64_t value)
+	{
+		for (int i = 0; i < 8; i++) {
+			hash ^= (value >> (8 * i)) & 0xff;
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+}
+
+RegionGraph::RegionTable::RegionTable()
+	: ready(false),
+	  signature(14695981039346656037ull)
+{
+}
+
+struct RegionGraph::RegionSearch
+{
+	std::map<uint32_t, float> distances;
+	std::map<uint32_t, uint32_t> previous;
+};
+
+RegionGraph::RegionGraph(CompactRoadmap const &roadmap, std::vector<int> const &nodeRegions,
+                         bool lazy, RegionGraph const *previous)
+	: roadmap_(roadmap),
+	  nodeRegions_(roadmap.nodes.size()),
+	  regions_(0),
+	  boundaryIndices_(roadmap.nodes.size(), -1),
+	  computedRegions_(0),
+	  reusedRegions_(0)
+{
+	TRACE_SPAN("RegionGraph::RegionGraph");
+
+	std::size_t const nodeCount = roadmap_.nodes.size();
+
+	for (std::size_t i = 0; i < nodeCount; i++) {
+		regions_ = std::max<std::size_t>(regions_, nodeRegions[i] + 1);
+	}
+
+	for (std::size_t i = 0; i < nodeCount; i++) {
+		nodeRegions_[i] = nodeRegions[i] >= 0 ? nodeRegions[i] : regions_++;
+	}
+
+	regionBoundaries_.resize(regions_);
+	tables_.resize(regions_);
+
+	for (uint32_t node = 0; node < nodeCount; node++) {
+		uint32_t const region = nodeRegions_[node];
+		uint64_t &signature = tables_[region].signature;
+		bool boundary = false;
+
+		signature = mix(mix(signature, roadmap_.nodes[node].x), roadmap_.nodes[node].y);
+
+		for (uint32_t edge = roadmap_.offsets[node]; edge < roadmap_.offsets[node + 1]; edge++) {
+			Coord2D const &target = roadmap_.nodes[roadmap_.targets[edge]];
+			bool const crossing = nodeRegions_[roadmap_.targets[edge]] != region;
+
+			signature = mix(mix(mix(signature, target.x), target.y), crossing);
+			boundary = boundary || crossing;
+		}
+
+		if (boundary) {
+			boundaryIndices_[node] = boundaryNodes_.size();
+			boundaryNodes_.push_back(node);
+			boundaryPositions_.push_back(regionBoundaries_[region].size());
+			regionBoundaries_[region].push_back(boundaryIndices_[node]);
+		}
+	}
+
+	crossEdges_.resize(boundaryNodes_.size());
+
+	for (std::size_t i = 0; i < boundaryNodes_.size(); i++) {
+		uint32_t node = boundaryNodes_[i];
+
+		for (uint32_t edge = roadmap_.offsets[node]; edge < roadmap_.offsets[node + 1]; edge++) {
+			uint32_t target = roadmap_.targets[edge];
+
+			if (nodeRegions_[target] != nodeRegions_[node]) {
+				AbstractEdge abstractEdge;
+				abstractEdge.target = boundaryIndices_[target];
+				abstractEdge.weight = roadmap_.weights[edge];
+
+				crossEdges_[i].push_back(abstractEdge);
+			}
+		}
+	}
+
+	// the same nodes with the same edges have the same boundary nodes in the same order
+	if (previous) {
+		QMutexLocker locker(&previous->tablesMutex_);
+		std::map<uint64_t, std::size_t> previousTables;
+
+		for (std::size_t region = 0; region < previous->regions_; region++) {
+			if (previous->tables_[region].ready) {
+				previousTables[previous->tables_[region].signature] = region;
+			}
+		}
+
+		for (std::size_t region = 0; region < regions_; region++) {
+			std::map<uint64_t, std::size_t>::const_iterator it = previousTables.find(tables_[region].signature);
+			std::size_t const boundaries = regionBoundaries_[region].size();
+
+			if (it != previousTables.end() &&
+			    previous->tables_[it->second].distances.size() == boundaries * boundaries) {
+				tables_[region].distances = previous->tables_[it->second].distances;
+				tables_[region].ready = true;
+				reusedRegions_++;
+			}
+		}
+	}
+
+	if (lazy) {
+		return;
+	}
+
+	for (std::size_t region = 0; region < regions_; region++) {
+		if (!tables_[region].ready) {
+			computeTable(region, tables_[region]);
+			tables_[region].ready = true;
+			computedRegions_++;
+		}
+	}
+}
+
+std::vector<Coord2D> RegionGraph::findPath(Coord2D const &startpoint, Coord2D const &endpoint,
+                                           uint64_t *expanded) const
+{
+	TRACE_SPAN("RegionGraph::findPath");
+
+	std::vector<Coord2D> const noPath(1, endpoint);
+	int const start = nodeIndex(startpoint);
+	int const end = nodeIndex(endpoint);
+
+	if (start < 0 || end < 0 || start == end) {
+		return noPath;
+	}
+
+	uint32_t const startRegion = nodeRegions_[start];
+	uint32_t const endRegion = nodeRegions_[end];
+	RegionSearch fromStart;
+	RegionSearch fromEnd;
+
+	searchRegion(start, -1, fromStart, expanded);
+	searchRegion(end, -1, fromEnd, expanded);
+
+	// the direct path within the region, if both are in the same one
+	float best = std::numeric_limits<float>::infinity();
+	int bestBoundary = -1;
+
+	if (startRegion == endRegion && fromStart.distances.count(end)) {
+		best = fromStart.distances[end];
+	}
+
+	// A* over the boundary nodes, entered from the region of the startpoint
+	// and left into the region of the endpoint
+	std::map<uint32_t, float> distances;
+	std::map<uint32_t, int> previous;
+	Queue queue;
+
+	for (std::vector<uint32_t>::const_iterator it = regionBoundaries_[startRegion].begin();
+	     it != regionBoundaries_[startRegion].end(); ++it) {
+		std::map<uint32_t, float>::const_iterator reached = fromStart.distances.find(boundaryNodes_[*it]);
+
+		if (reached != fromStart.distances.end()) {
+			distances[*it] = reached->second;
+			previous[*it] = -1;
+			queue.push(QueueEntry(reached->second + estimate(roadmap_.nodes[boundaryNodes_[*it]], endpoint),
+			                      reached->second, *it));
+		}
+	}
+
+	while (!queue.empty()) {
+		QueueEntry entry = queue.top();
+		queue.pop();
+
+		if (entry.priority >= best) {
+			break;
+		}
+
+		if (entry.distance > distances[entry.node]) {
+			continue;
+		}
+
+		if (expanded) {
+			(*expanded)++;
+		}
+
+		uint32_t const node = boundaryNodes_[entry.node];
+
+		if (nodeRegions_[node] == endRegion) {
+			std::map<uint32_t, float>::const_iterator reached = fromEnd.distances.find(node);
+
+			if (reached != fromEnd.distances.end() && entry.distance + reached->second < best) {
+				best = entry.distance + reached->second;
+				bestBoundary = entry.node;
+			}
+		}
+
+		// the edges into other regions and the table of its own region
+		uint32_t const region = nodeRegions_[node];
+		std::vector<uint32_t> const &boundaries = regionBoundaries_[region];
+		std::vector<float> const &table = regionTable(region).distances;
+		std::size_t const row = boundaryPositions_[entry.node] * boundaries.size();
+		std::vector<AbstractEdge> edges(crossEdges_[entry.node]);
+
+		for (std::size_t i = 0; i < boundaries.size(); i++) {
+			if (boundaries[i] != entry.node && table[row + i] != std::numeric_limits<float>::infinity()) {
+				AbstractEdge abstractEdge;
+				abstractEdge.target = boundaries[i];
+				abstractEdge.weight = table[row + i];
+
+				edges.push_back(abstractEdge);
+			}
+		}
+
+		for (std::vector<AbstractEdge>::const_iterator it = edges.begin(); it != edges.end(); ++it) {
+			float distance = entry.distance + it->weight;
+			std::map<uint32_t, float>::iterator known = distances.find(it->target);
+
+			if (known == distances.end() || distance < known->second) {
+				distances[it->target] = distance;
+				previous[it->target] = entry.node;
+				queue.push(QueueEntry(distance + estimate(roadmap_.nodes[boundaryNodes_[it->target]], endpoint),
+				                      distance, it->target));
+			}
+		}
+	}
+
+	if (best == std::numeric_limits<float>::infinity()) {
+		return noPath;
+	}
+
+	// roadmap nodes from the endpoint back to the startpoint
+	std::vector<uint32_t> nodes;
+
+	if (bestBoundary < 0) {
+		for (uint32_t node = end; node != static_cast<uint32_t>(start); node = fromStart.previous[node]) {
+			nodes.push_back(node);
+		}
+	} else {
+		uint32_t node = boundaryNodes_[bestBoundary];
+
+		// the way from the last boundary node to the endpoint is the search tree of the endpoint
+		std::vector<uint32_t> toEnd;
+
+		for (uint32_t current = node; current != static_cast<uint32_t>(end); current = fromEnd.previous[current]) {
+			toEnd.push_back(current);
+		}
+
+		toEnd.push_back(end);
+		nodes.assign(toEnd.rbegin(), toEnd.rend() - 1);
+
+		// only the regions on the route are searched again, edges between regions are taken as they are
+		for (int boundary = bestBoundary; previous[boundary] >= 0; boundary = previous[boundary]) {
+			uint32_t const from = boundaryNodes_[previous[boundary]];
+			uint32_t const to = boundaryNodes_[boundary];
+
+			if (nodeRegions_[from] == nodeRegions_[to]) {
+				std::vector<uint32_t> refined = regionPath(from, to, expanded);
+
+				nodes.insert(nodes.end(), refined.rbegin(), refined.rend() - 1);
+			} else {
+				nodes.push_back(to);
+			}
+
+			node = from;
+		}
+
+		for (; node != static_cast<uint32_t>(start); node = fromStart.previous[node]) {
+			nodes.push_back(node);
+		}
+	}
+
+	nodes.push_back(start);
+
+	std::vector<Coord2D> path;
+	path.reserve(nodes.size());
+
+	for (std::vector<uint32_t>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+		path.push_back(roadmap_.nodes[*it]);
+	}
+
+	return path;
+}
+
+std::size_t RegionGraph::regions() const
+{
+	return regions_;
+}
+
+std::size_t RegionGraph::boundaryNodes() const
+{
+	return boundaryNodes_.size();
+}
+
+std::size_t RegionGraph::computedRegions() const
+{
+	QMutexLocker locker(&tablesMutex_);
+
+	return computedRegions_;
+}
+
+std::size_t RegionGraph::reusedRegions() const
+{
+	return reusedRegions_;
+}
+
+RegionGraph::RegionTable const &RegionGraph::regionTable(uint32_t region) const
+{
+	QMutexLocker locker(&tablesMutex_);
+	RegionTable &table = tables_[region];
+
+	// a table never changes once it's ready, so it can be read without the lock
+	if (!table.ready) {
+		computeTable(region, table);
+		table.ready = true;
+		computedRegions_++;
+	}
+
+	return table;
+}
+
+// one search within the region from every boundary node
+void RegionGraph::computeTable(uint32_t region, RegionTable &table) const
+{
+	std::vector<uint32_t> const &boundaries = regionBoundaries_[region];
+
+	table.distances.assign(boundaries.size() * boundaries.size(), std::numeric_limits<float>::infinity());
+
+	for (std::size_t i = 0; i < boundaries.size(); i++) {
+		RegionSearch search;
+
+		table.distances[i * boundaries.size() + i] = 0;
+
+		if (boundaries.size() < 2) {
+			continue;
+		}
+
+		searchRegion(boundaryNodes_[boundaries[i]], -1, search, 0);
+
+		for (std::size_t j = 0; j < boundaries.size(); j++) {
+			std::map<uint32_t, float>::const_iterator it = search.distances.find(boundaryNodes_[boundaries[j]]);
+
+			if (it != search.distances.end()) {
+				table.distances[i * boundaries.size() + j] = it->second;
+			}
+		}
+	}
+}
+
+// Dijkstra, or A* if there is a goal to stop at, without leaving the region of source
+void RegionGraph::searchRegion(uint32_t source, int goal, RegionSearch &search, uint64_t *expanded) const
+{
+	uint32_t const region = nodeRegions_[source];
+	Queue queue;
+
+	search.distances[source] = 0;
+	queue.push(QueueEntry(goal >= 0 ? estimate(roadmap_.nodes[source], roadmap_.nodes[goal]) : 0, 0, source));
+
+	while (!queue.empty()) {
+		QueueEntry entry = queue.top();
+		queue.pop();
+
+		if (entry.distance > search.distances[entry.node]) {
+			continue;
+		}
+
+		if (static_cast<int>(entry.node) == goal) {
+			return;
+		}
+
+		if (expanded) {
+			(*expanded)++;
+		}
+
+		for (uint32_t edge = roadmap_.offsets[entry.node]; edge < roadmap_.offsets[entry.node + 1]; edge++) {
+			uint32_t target = roadmap_.targets[edge];
+
+			if (nodeRegions_[target] != region) {
+				continue;
+			}
+
+			float distance = entry.distance + roadmap_.weights[edge];
+			std::map<uint32_t, float>::iterator known = search.distances.find(target);
+
+			if (known == search.distances.end() || distance < known->second) {
+				search.distances[target] = distance;
+				search.previous[target] = entry.node;
+				queue.push(QueueEntry(distance + (goal >= 0 ? estimate(roadmap_.nodes[target], roadmap_.nodes[goal]) : 0),
+				                      distance, target));
+			}
+		}
+	}
+}
+
+// source to goal within their region, both included
+std::vector<uint32_t> RegionGraph::regionPath(uint32_t source, uint32_t goal, uint64_t *expanded) const
+{
+	RegionSearch search;
+
+	searchRegion(source, goal, search, expanded);
+
+	std::vector<uint32_t> path;
+
+	for (uint32_t node = goal; node != source; node = search.previous[node]) {
+		path.push_back(node);
+	}
+
+	path.push_back(source);
+	std::reverse(path.begin(), path.end());
+
+	return path;
+}
+
+int RegionGraph::nodeIndex(Coord2D const &coord) const
+{
+	std::vector<Coord2D>::const_iterator it = std::lower_bound(roadmap_.nodes.begin(), roadmap_.nodes.end(), coord);
+
+	if (it == roadmap_.nodes.end() || *it != coord) {
+		return -1;
+	}
+
+	return it - roadmap_.nodes.begin();
+}
+
+std::vector<int> clusterRegions(CompactRoadmap const &roadmap, unsigned int clusterSize)
+{
+	std::vector<int> regions(roadmap.nodes.size());
+	unsigned int columns = 0;
+
+	for (std::size_t i = 0; i < roadmap.nodes.size(); i++) {
+		columns = std::max(columns, roadmap.nodes[i].x / clusterSize + 1);
+	}
+
+	for (std::size_t i = 0; i < roadmap.nodes.size(); i++) {
+		regions[i] = roadmap.nodes[i].y / clusterSize * columns + roadmap.nodes[i].x / clusterSize;
+	}
+
+	return regions;
+}
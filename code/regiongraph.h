@@ -0,0 +1,90 @@
+#ifndef ROB_REGIONGRAPH_H_INCLUDED
+#define ROB_REGIONGRAPH_H_INCLUDED
+
+#include "coord.h"
+#include "roadmap.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <QtCore/QMutex>
+
+#include <stdint.h>
+
+// two level search over a roadmap split into regions, e.g. rooms connected by doors.
+// The boundary nodes (nodes with an edge into another region) and the distances between
+// the boundary nodes of every region are computed once; a query only searches the regions
+// of its startpoint and endpoint, then the graph of the boundary nodes, and refines the
+// route into roadmap edges region by region
+class RegionGraph
+{
+public:
+	// nodeRegions is parallel to roadmap.nodes, nodes in region -1 get a region of their own.
+	// A lazy graph computes the distances of a region when a query reaches it first.
+	// Regions whose nodes and edges are the same as in previous take over its distances
+	RegionGraph(CompactRoadmap const &roadmap, std::vector<int> const &nodeRegions,
+	            bool lazy = false, RegionGraph const *previous = 0);
+
+	// like dijkstra(), from the endpoint back to the startpoint and only the endpoint if
+	// there is no path; may run on several threads at once
+	std::vector<Coord2D> findPath(Coord2D const &startpoint, Coord2D const &endpoint,
+	                              uint64_t *expanded = 0) const;
+
+	std::size_t regions() const;
+	std::size_t boundaryNodes() const;
+	// the distances computed so far and the ones taken over from the previous graph
+	std::size_t computedRegions() const;
+	std::size_t reusedRegions() const;
+
+private:
+	RegionGraph(RegionGraph const &);
+	RegionGraph &operator=(RegionGraph const &);
+
+	struct AbstractEdge
+	{
+		uint32_t target;
+		float weight;
+	};
+
+	// distances between the boundary nodes of a region, row major in the order of regionBoundaries_
+	struct RegionTable
+	{
+		RegionTable();
+
+		bool ready;
+		// of the nodes and edges of the region, to find it in the next graph
+		uint64_t signature;
+		std::vector<float> distances;
+	};
+
+	// shortest distances from one node within its region
+	struct RegionSearch;
+
+	RegionTable const &regionTable(uint32_t region) const;
+	void computeTable(uint32_t region, RegionTable &table) const;
+	void searchRegion(uint32_t source, int goal, RegionSearch &search, uint64_t *expanded) const;
+	std::vector<uint32_t> regionPath(uint32_t source, uint32_t goal, uint64_t *expanded) const;
+	int nodeIndex(Coord2D const &coord) const;
+
+	CompactRoadmap roadmap_;
+	std::vector<uint32_t> nodeRegions_;
+	std::size_t regions_;
+	// index into boundaryNodes_ of every node, -1 if it isn't a boundary node
+	std::vector<int> boundaryIndices_;
+	std::vector<uint32_t> boundaryNodes_;
+	// parallel to boundaryNodes_, the position in the list of its region
+	std::vector<uint32_t> boundaryPositions_;
+	// parallel to boundaryNodes_, the roadmap edges into other regions
+	std::vector< std::vector<AbstractEdge> > crossEdges_;
+	std::vector< std::vector<uint32_t> > regionBoundaries_;
+	// filled in by regionTable() in lazy graphs, guarded by tablesMutex_
+	mutable std::vector<RegionTable> tables_;
+	mutable std::size_t computedRegions_;
+	std::size_t reusedRegions_;
+	mutable QMutex tablesMutex_;
+};
+
+// regions of clusterSize * clusterSize pixels, for a roadmap without any structure of its own
+std::vector<int> clusterRegions(CompactRoadmap const &roadmap, unsigned int clusterSize);
+
+#endif // ROB_REGIONGRAPH_H_INCLUDED
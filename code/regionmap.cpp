@@ -0,0 +1,144 @@
+#include "regionmap.h"
+#include "roomimage.h"
+#include "trace.h"
+
+#include <algorithm>
+
+namespace
+{
+	unsigned int findRoot(std::vector<unsigned int> &parents, unsigned int run);
+	void unite(std::vector<unsigned int> &parents, unsigned int first, unsigned int second);
+
+	// with path halving
+	unsigned int findRoot(std::vector<unsigned int> &parents, unsigned int run)
+	{
+		while (parents[run] != run) {
+			parents[run] = parents[parents[run]];
+			run = parents[run];
+		}
+
+		return run;
+	}
+
+	void unite(std::vector<unsigned int> &parents, unsigned int first, unsigned int second)
+	{
+		first = findRoot(parents, first);
+		second = findRoot(parents, second);
+
+		if (first != second) {
+			parents[std::max(first, second)] = std::min(first, second);
+		}
+	}
+}
+
+RegionMap::RegionMap()
+	: regions_(0)
+{
+}
+
+// runs of the same region touch in one row or overlap in neighbouring ones, diagonal
+// contact doesn't count, so a door line of one pixel always separates
+void RegionMap::build(RoomImage const &image)
+{
+	TRACE_SPAN("RegionMap::build");
+
+	std::vector<unsigned char> const &classes = image.classMap();
+	unsigned int const width = image.width();
+	unsigned int const height = image.height();
+	std::vector<unsigned int> parents;
+
+	clear();
+	rowStarts_.reserve(height + 1);
+
+	for (unsigned int y = 0; y < height; y++) {
+		unsigned char const *row = &classes[static_cast<std::size_t>(y) * width];
+		std::size_t previousRun = rowStarts_.empty() ? 0 : rowStarts_.back();
+		std::size_t const previousEnd = runs_.size();
+
+		rowStarts_.push_back(runs_.size());
+
+		for (unsigned int x = 0; x < width;) {
+			if (row[x] != RoomImage::PixelInside) {
+				x++;
+				continue;
+			}
+
+			Run run;
+			run.begin = x;
+
+			while (x < width && row[x] == RoomImage::PixelInside) {
+				x++;
+			}
+
+			run.end = x;
+			run.region = runs_.size();
+
+			parents.push_back(run.region);
+
+			// the runs of both rows are sorted, so the overlapping ones are found in one pass
+			while (previousRun < previousEnd && runs_[previousRun].end <= run.begin) {
+				previousRun++;
+			}
+
+			for (std::size_t i = previousRun; i < previousEnd && runs_[i].begin < run.end; i++) {
+				unite(parents, run.region, i);
+			}
+
+			runs_.push_back(run);
+		}
+	}
+
+	rowStarts_.push_back(runs_.size());
+
+	// the roots in the order of their first run become the region numbers
+	std::vector<unsigned int> numbers(runs_.size());
+
+	for (std::size_t i = 0; i < runs_.size(); i++) {
+		unsigned int root = findRoot(parents, i);
+
+		if (root == i) {
+			numbers[i] = regions_++;
+		}
+
+		runs_[i].region = numbers[root];
+	}
+}
+
+void RegionMap::clear()
+{
+	runs_.clear();
+	rowStarts_.clear();
+	regions_ = 0;
+}
+
+unsigned int RegionMap::regions() const
+{
+	return regions_;
+}
+
+int RegionMap::region(Coord2D const &coord) const
+{
+	if (coord.y + 1 >= rowStarts_.size()) {
+		return -1;
+	}
+
+	std::vector<Run>::const_iterator begin = runs_.begin() + rowStarts_[coord.y];
+	std::vector<Run>::const_iterator end = runs_.begin() + rowStarts_[coord.y + 1];
+
+	// the first run ending behind x
+	while (begin != end) {
+		std::vector<Run>::const_iterator middle = begin + (end - begin) / 2;
+
+		if (middle->end <= coord.x) {
+			begin = middle + 1;
+		} else {
+			end = middle;
+		}
+	}
+
+	if (begin == runs_.begin() + rowStarts_[coord.y + 1] || begin->begin > coord.x) {
+		return -1;
+	}
+
+	return begin->region;
+}
@@ -0,0 +1,39 @@
+#ifndef ROB_REGIONMAP_H_INCLUDED
+#define ROB_REGIONMAP_H_INCLUDED
+
+#include "coord.h"
+
+#include <cstddef>
+#include <vector>
+
+class RoomImage;
+
+// connected areas of inside pixels, e.g. the rooms of a building; doors and walls
+// separate them. Stored as runs of pixels per row, a fraction of a label per pixel
+class RegionMap
+{
+public:
+	RegionMap();
+
+	void build(RoomImage const &image);
+	void clear();
+
+	unsigned int regions() const;
+	// -1 for walls, doors and outside
+	int region(Coord2D const &coord) const;
+
+private:
+	struct Run
+	{
+		unsigned int begin;
+		unsigned int end;
+		unsigned int region;
+	};
+
+	std::vector<Run> runs_;
+	// runs of row y are runs_[rowStarts_[y]] up to runs_[rowStarts_[y + 1]]
+	std::vector<std::size_t> rowStarts_;
+	unsigned int regions_;
+};
+
+#endif // ROB_REGIONMAP_H_INCLUDED
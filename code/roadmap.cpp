@@ -0,0 +1,215 @@
+#include "binarystream.h"
+#include "roadmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+
+float edgeWeight(Coord2D const &start, Coord2D const &end);
+uint64_t fnv1a(uint64_t value, uint64_t hash);
+
+float edgeWeight(Coord2D const &start, Coord2D const &end)
+{
+	float xDist = static_cast<float>(end.x) - start.x;
+	float yDist = static_cast<float>(end.y) - start.y;
+
+	return std::sqrt(xDist * xDist + yDist * yDist);
+}
+
+// all eight bytes of value, least significant first
+uint64_t fnv1a(uint64_t value, uint64_t hash)
+{
+	for (int i = 0; i < 8; i++) {
+		hash ^= (value >> (8 * i)) & 0xff;
+		hash *= 1099511628211ull;
+	}
+
+	return hash;
+}
+
+} // end of private namespace
+
+void compactRoadmap(NeighboursMap const &neighbours, CompactRoadmap &roadmap)
+{
+	roadmap.nodes.clear();
+	roadmap.offsets.clear();
+	roadmap.targets.clear();
+	roadmap.weights.clear();
+
+	roadmap.nodes.reserve(neighbours.size());
+
+	for (NeighboursMap::const_iterator it = neighbours.begin(); it != neighbours.end(); ++it) {
+		roadmap.nodes.push_back(it->first);
+	}
+
+	roadmap.offsets.reserve(neighbours.size() + 1);
+	roadmap.offsets.push_back(0);
+
+	for (NeighboursMap::const_iterator it = neighbours.begin(); it != neighbours.end(); ++it) {
+		for (std::set<Coord2D>::const_iterator nit = it->second.begin(); nit != it->second.end(); ++nit) {
+			std::vector<Coord2D>::const_iterator node = std::lower_bound(roadmap.nodes.begin(), roadmap.nodes.end(), *nit);
+
+			// neighbours without an entry of their own can't be expanded again
+			if (node == roadmap.nodes.end() || *node != *nit) {
+				continue;
+			}
+
+			roadmap.targets.push_back(node - roadmap.nodes.begin());
+			roadmap.weights.push_back(edgeWeight(it->first, *nit));
+		}
+
+		roadmap.offsets.push_back(roadmap.targets.size());
+	}
+}
+
+bool expandRoadmap(CompactRoadmap const &roadmap, NeighboursMap &neighbours)
+{
+	std::size_t nodeCount = roadmap.nodes.size();
+
+	if (roadmap.offsets.size() != nodeCount + 1 || roadmap.offsets[0] != 0 ||
+	    roadmap.offsets[nodeCount] != roadmap.targets.size() ||
+	    roadmap.weights.size() != roadmap.targets.size()) {
+		return false;
+	}
+
+	neighbours.clear();
+
+	for (std::size_t i = 0; i < nodeCount; i++) {
+		if (roadmap.offsets[i] > roadmap.offsets[i + 1]) {
+			return false;
+		}
+
+		Coord2D const &node = roadmap.nodes[i];
+		std::set<Coord2D> &nodeNeighbours = neighbours[node];
+
+		for (uint32_t j = roadmap.offsets[i]; j < roadmap.offsets[i + 1]; j++) {
+			uint32_t target = roadmap.targets[j];
+
+			if (target >= nodeCount) {
+				return false;
+			}
+
+			// the weights are only stored for other readers, here they guard against corruption
+			if (std::fabs(roadmap.weights[j] - edgeWeight(node, roadmap.nodes[target])) > 0.01f) {
+				return false;
+			}
+
+			nodeNeighbours.insert(nodeNeighbours.end(), roadmap.nodes[target]);
+		}
+	}
+
+	return true;
+}
+
+uint64_t roadmapChecksum(uint64_t imageHash, unsigned char distance, std::vector<Coord2D> const &nodes)
+{
+	uint64_t hash = fnv1a(imageHash, 14695981039346656037ull);
+
+	hash = fnv1a(distance, hash);
+	hash = fnv1a(nodes.size(), hash);
+
+	for (std::vector<Coord2D>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+		hash = fnv1a((static_cast<uint64_t>(it->x) << 32) | it->y, hash);
+	}
+
+	return hash;
+}
+
+// node count, the degree of every node, the targets of every node as deltas to
+// the previous one and finally the weights as raw floats
+void writeRoadmap(BinaryWriter &writer, CompactRoadmap const &roadmap)
+{
+	std::size_t nodeCount = roadmap.offsets.size() - 1;
+
+	writer.writeVarint(nodeCount);
+
+	for (std::size_t i = 0; i < nodeCount; i++) {
+		writer.writeVarint(roadmap.offsets[i + 1] - roadmap.offsets[i]);
+	}
+
+	for (std::size_t i = 0; i < nodeCount; i++) {
+		int64_t last = 0;
+
+		for (uint32_t j = roadmap.offsets[i]; j < roadmap.offsets[i + 1]; j++) {
+			writer.writeSignedVarint(static_cast<int64_t>(roadmap.targets[j]) - last);
+			last = roadmap.targets[j];
+		}
+	}
+
+	for (std::size_t i = 0; i < roadmap.weights.size(); i++) {
+		uint32_t bits;
+
+		std::memcpy(&bits, &roadmap.weights[i], sizeof bits);
+		writer.writeU32(bits);
+	}
+}
+
+bool readRoadmap(BinaryReader &reader, CompactRoadmap &roadmap)
+{
+	uint64_t nodeCount;
+
+	// every node needs at least one byte for its degree
+	if (!reader.readVarint(nodeCount) || nodeCount > reader.remaining()) {
+		return false;
+	}
+
+	roadmap.offsets.resize(nodeCount + 1);
+	roadmap.offsets[0] = 0;
+
+	for (uint64_t i = 0; i < nodeCount; i++) {
+		uint64_t degree;
+
+		// every target needs at least one byte, which also keeps the offsets from overflowing
+		if (!reader.readVarint(degree) || roadmap.offsets[i] + degree > reader.remaining()) {
+			return false;
+		}
+
+		roadmap.offsets[i + 1] = roadmap.offsets[i] + degree;
+	}
+
+	uint32_t edgeCount = roadmap.offsets[nodeCount];
+
+	// a target takes at least one byte and a weight four
+	if (edgeCount > reader.remaining() / 5) {
+		return false;
+	}
+
+	roadmap.targets.resize(edgeCount);
+
+	for (uint64_t i = 0; i < nodeCount; i++) {
+		int64_t last = 0;
+
+		for (uint32_t j = roadmap.offsets[i]; j < roadmap.offsets[i + 1]; j++) {
+			int64_t delta;
+
+			if (!reader.readSignedVarint(delta)) {
+				return false;
+			}
+
+			last += delta;
+
+			if (last < 0 || static_cast<uint64_t>(last) >= nodeCount) {
+				return false;
+			}
+
+			roadmap.targets[j] = last;
+		}
+	}
+
+	roadmap.weights.resize(edgeCount);
+
+	for (uint32_t i = 0; i < edgeCount; i++) {
+		uint32_t bits;
+
+		if (!reader.readU32(bits)) {
+			return false;
+		}
+
+		std::memcpy(&roadmap.weights[i], &bits, sizeof bits);
+	}
+
+	return true;
+}
@@ -0,0 +1,36 @@
+#ifndef ROB_ROADMAP_H_INCLUDED
+#define ROB_ROADMAP_H_INCLUDED
+
+#include "coord.h"
+#include "neighbours.h"
+
+#include <vector>
+
+#include <stdint.h>
+
+class BinaryReader;
+class BinaryWriter;
+
+// roadmap in compressed sparse row form, the neighbours of nodes[i] are
+// targets[offsets[i]] up to targets[offsets[i + 1]], the nodes are in ascending order
+struct CompactRoadmap
+{
+	std::vector<Coord2D> nodes;
+	std::vector<uint32_t> offsets;
+	std::vector<uint32_t> targets;
+	// euclidean length of every edge, parallel to targets
+	std::vector<float> weights;
+};
+
+void compactRoadmap(NeighboursMap const &neighbours, CompactRoadmap &roadmap);
+// false if the roadmap is inconsistent, e.g. a target or weight doesn't fit the nodes
+bool expandRoadmap(CompactRoadmap const &roadmap, NeighboursMap &neighbours);
+
+// ties a stored roadmap to the room image, the distance to the walls and the nodes
+uint64_t roadmapChecksum(uint64_t imageHash, unsigned char distance, std::vector<Coord2D> const &nodes);
+
+// everything but the nodes, the reader has to know them already
+void writeRoadmap(BinaryWriter &writer, CompactRoadmap const &roadmap);
+bool readRoadmap(BinaryReader &reader, CompactRoadmap &roadmap);
+
+#endif // ROB_ROADMAP_H_INCLUDED
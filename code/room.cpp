@@ -1,26 +1,47 @@
 #include "algo.h"
+#include "binarystream.h"
+#include "contraction.h"
+#include "planningjob.h"
+#include "regiongraph.h"
+#include "regionmap.h"
+#include "roadmap.h"
 #include "room.h"
+#include "roomcache.h"
 #include "roomimage.h"
 #include "stats.h"
+#include "trace.h"
 #include "triangulation.h"
+#include "wallsegments.h"
 
+#include <algorithm>
 #include <set>
+#include <utility>
 
 #include <cassert>
 #include <cmath>
 #include <cstdlib>
 
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
 #include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QSharedPointer>
 #include <QtCore/QXmlStreamReader>
 #include <QtCore/QXmlStreamWriter>
 #include <QtWidgets/QTextEdit>
 
 #include <stdio.h>
+#include <stdint.h>
 
 namespace
 {
 
 long randomAtMost(long max);
+unsigned int clusterSize(unsigned int width, unsigned int height, std::size_t nodes);
+bool hierarchical(Room::Algorithm algorithm);
+bool preprocessed(Room::Algorithm algorithm);
+char const *algorithmName(Room::Algorithm algorithm);
 
 long randomAtMost(long max)
 {
@@ -42,6 +63,54 @@ long randomAtMost(long max)
 	return x / bin_size;
 }
 
+// a power of two with about 64 nodes per cluster, so most waypoint edits keep the clusters
+unsigned int clusterSize(unsigned int width, unsigned int height, std::size_t nodes)
+{
+	double const area = static_cast<double>(width) * height * 64 / std::max<std::size_t>(nodes, 1);
+	unsigned int size = 16;
+
+	while (static_cast<double>(size) * size * 2 < area) {
+		size *= 2;
+	}
+
+	return size;
+}
+
+// searched with a RegionGraph
+bool hierarchical(Room::Algorithm algorithm)
+{
+	return algorithm == Room::DoorGraph || algorithm == Room::ClusterGraph;
+}
+
+// searched on a structure built from the validated roadmap
+bool preprocessed(Room::Algorithm algorithm)
+{
+	return hierarchical(algorithm) || algorithm == Room::Contraction;
+}
+
+// for the statistics
+char const *algorithmName(Room::Algorithm algorithm)
+{
+	switch (algorithm) {
+		case Room::Dijkstra:
+			return "Dijkstra";
+
+		case Room::AStar:
+			return "A*";
+
+		case Room::DoorGraph:
+			return "door graph";
+
+		case Room::ClusterGraph:
+			return "cluster graph";
+
+		case Room::Contraction:
+			return "contraction hierarchy";
+	}
+
+	return "";
+}
+
 } // end of private namespace
 
 struct Room::RoomImpl
@@ -51,43 +120,49 @@ struct Room::RoomImpl
 		  statusText_(statusText),
 		  helpText_(helpText),
 		  stats(stats),
-		  algorithm(Room::Dijkstra)
+		  algorithm(Room::Dijkstra),
+		  lazyValidation(false),
+		  version(1),
+		  validatedVersion(0),
+		  lazyVersion(0),
+		  regionGraphAlgorithm(Room::Dijkstra),
+		  regionGraphVersion(0),
+		  contractionVersion(0),
+		  stage(Room::StageDecoded),
+		  triangulationTime(0),
+		  preprocessingTime(0),
+		  cache(0),
+		  cacheHit(false),
+		  imageHash(0),
+		  inDomainCalls(0)
 	{
-		bytes = image->data().data();
 		width = image->width();
 		height = image->height();
-		stride = image->type() == Image::IMAGE_TYPE_RGB ? 3 : 4;
 
 		this->distance = distance;
+	}
 
-		// this array below distinguishes between big room (first) and holes
-		std::vector<Polygon2D> borderPolygons;
-
-		image->getBorderPolygons(distance, borderPolygons, doorPolygons_);
+	void extractContours()
+	{
+		TRACE_SPAN("Room::extractContours");
 
-		// this array doesn't distinguish between big room and holes
-		//std::vector<Edge> constraints = roomTriangulation.getConstrainedEdges();
+		assert(stage.loadAcquire() == Room::StageDecoded);
 
 		QElapsedTimer timer;
 		timer.start();
 
-		for (std::vector<Polygon2D>::const_iterator it = borderPolygons.begin();
-		     it != borderPolygons.end();
-		     it++) {
-			std::vector<Coord2D> points;
-
-			for (std::size_t i = 0; i < it->size(); i++) {
-				Coord2D coord = (*it)[i];
-				points.push_back(coord);
-			}
+		cache = new RoomCache(image->filename(), distance);
+		imageHash = cache->hash();
 
-			Coord2D coord = (*it)[0];
-			points.push_back(coord);
+		// a cache hit also contains the room triangulation, triangulate() has nothing left to do
+		cacheHit = cache->load(*image, borderPolygons, doorPolygons_, roomTriangulation);
 
-			roomTriangulation.insertConstraints(points);
+		if (!cacheHit) {
+			image->classify();
+			image->getBorderPolygons(distance, borderPolygons, doorPolygons_);
 		}
 
-		stats->lastRoomTriangulationCalculation = timer.elapsed();
+		regions.build(*image);
 
 		for (std::vector<Polygon2D>::const_iterator it = borderPolygons.begin();
 		     it != borderPolygons.end();
@@ -110,9 +185,81 @@ struct Room::RoomImpl
 				polygonEdges.push_back(lastEdge);
 			}
 
-			edges.push_back(polygonEdges);
+			walls.addPolygon(polygonEdges);
+		}
+
+		preprocessingTime = timer.nsecsElapsed();
+
+		stage.storeRelease(Room::StageContours);
+	}
+
+	void triangulate()
+	{
+		assert(stage.loadAcquire() == Room::StageContours);
+
+		if (cacheHit) {
+			delete cache;
+			cache = 0;
+			std::vector<Polygon2D>().swap(borderPolygons);
+			stage.storeRelease(Room::StageTriangulated);
+			return;
+		}
+
+		TRACE_SPAN("Room::triangulate");
+
+		QElapsedTimer timer;
+		timer.start();
+
+		// borderPolygons distinguishes between big room (first) and holes,
+		// the constraints of the triangulation don't
+		std::vector< std::vector<Coord2D> > constraints;
+
+		for (std::vector<Polygon2D>::const_iterator it = borderPolygons.begin();
+		     it != borderPolygons.end();
+		     it++) {
+			std::vector<Coord2D> points;
+
+			for (std::size_t i = 0; i < it->size(); i++) {
+				Coord2D coord = (*it)[i];
+				points.push_back(coord);
+			}
+
+			Coord2D coord = (*it)[0];
+			points.push_back(coord);
+
+			constraints.push_back(points);
+		}
+
+		roomTriangulation.insertConstraints(constraints);
+
+		triangulationTime = timer.nsecsElapsed();
+		preprocessingTime += triangulationTime;
+
+		cache->save(*image, borderPolygons, doorPolygons_, roomTriangulation);
+
+		delete cache;
+		cache = 0;
+
+		// the walls keep their own copy
+		std::vector<Polygon2D>().swap(borderPolygons);
+
+		stage.storeRelease(Room::StageTriangulated);
+	}
+
+	// talks to the status widget, so it has to run on the GUI thread
+	void placeEndpoints()
+	{
+		assert(stage.loadAcquire() == Room::StageTriangulated);
+
+		if (cacheHit) {
+			stats->record("room preprocessing (warm, cached)", preprocessingTime);
+		} else {
+			stats->record("room triangulation", triangulationTime);
+			stats->record("room preprocessing (cold)", preprocessingTime);
 		}
 
+		stats->setCounter("CDT faces", roomTriangulation.numberOfFaces());
+
 		reinitializeTriangulation();
 
 		setDoorWaypoints();
@@ -134,30 +281,75 @@ struct Room::RoomImpl
 				break;
 			}
 		}
+
+		stats->setCounter("inDomain calls", inDomainCalls);
+
+		stage.storeRelease(Room::StageReady);
 	}
 
 	~RoomImpl()
 	{
+		delete cache;
 		delete image;
 	}
 
 	RoomImage *image;
-	unsigned char const *bytes;
 	unsigned int width;
 	unsigned int height;
-	unsigned char stride;
 	unsigned char distance;
 	DelaunayTriangulation triangulation;
 	ConstrainedDelaunayTriangulation roomTriangulation;
 	Coord2D startpoint;
 	Coord2D endpoint;
-	std::vector< std::vector<Edge> > edges;
+	WallSegments walls;
 	std::set<Coord2D> waypoints;
 	QTextEdit *statusText_;
 	QTextEdit *helpText_;
 	std::vector<Polygon2D> doorPolygons_;
 	Stats *stats;
 	Room::Algorithm algorithm;
+	bool lazyValidation;
+	// bumped on every change of the waypoints, startpoint or endpoint
+	unsigned long version;
+	// fully validated roadmap of validatedVersion, shared with the planning jobs
+	QSharedPointer<NeighboursMap> validatedNeighbours;
+	unsigned long validatedVersion;
+	// roadmap searched in lazy mode, edges are removed once they turn out to be invalid,
+	// shared read-only with the planning jobs
+	QSharedPointer<NeighboursMap> lazyNeighbours;
+	unsigned long lazyVersion;
+	// validation results of edges of lazyVersion, shared read-only with the planning jobs
+	QSharedPointer< std::map<RoadmapEdge, bool> > validatedEdges;
+	// rooms of the image, split by the doors
+	RegionMap regions;
+	// door or cluster graph of the validated roadmap of regionGraphVersion, shared with the planning jobs
+	QSharedPointer<RegionGraph> regionGraph;
+	Room::Algorithm regionGraphAlgorithm;
+	unsigned long regionGraphVersion;
+	// of the validated roadmap of contractionVersion, shared with the planning jobs
+	QSharedPointer<ContractionHierarchy> contractionHierarchy;
+	unsigned long contractionVersion;
+	// how far preprocessing got, written by the loader thread
+	QAtomicInt stage;
+	// only used between extractContours() and triangulate()
+	std::vector<Polygon2D> borderPolygons;
+	// both in nanoseconds
+	uint64_t triangulationTime;
+	// classification, contours and triangulation, or loading all of them from the cache
+	uint64_t preprocessingTime;
+	RoomCache *cache;
+	bool cacheHit;
+	// content hash of the image file, stored roadmaps are only valid for it
+	uint64_t imageHash;
+	// CGAL point location isn't reentrant, the planner thread shares roomTriangulation with the GUI
+	mutable QMutex geometryMutex;
+	// total of all threads, guarded by geometryMutex
+	mutable uint64_t inDomainCalls;
+
+	void waypointsChanged()
+	{
+		version++;
+	}
 
 	bool insert(Coord2D const &coord)
 	{
@@ -171,7 +363,7 @@ struct Room::RoomImpl
 			return false;
 		}
 
-		if (!roomTriangulation.inDomain(coord.x, coord.y)) {
+		if (!inDomain(coord.x, coord.y)) {
 			statusText_->setText(statusText_->tr("Waypoint (%1/%2) outside domain, can't insert.\n").arg(coord.x).arg(coord.y));
 			return false;
 		}
@@ -179,10 +371,58 @@ struct Room::RoomImpl
 		triangulation.insert(coord);
 		waypoints.insert(coord);
 		assert(triangulation.pointIsVertex(coord));
+		waypointsChanged();
 
 		return true;
 	}
 
+	// validates all coordinates first and inserts the valid ones in one spatially sorted pass
+	std::size_t insert(std::vector<Coord2D> const &coords)
+	{
+		std::vector<Coord2D> candidates(coords);
+
+		std::sort(candidates.begin(), candidates.end());
+		candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+		std::vector<bool> inside;
+
+		{
+			QMutexLocker locker(&geometryMutex);
+			roomTriangulation.inDomain(candidates, inside);
+			inDomainCalls += candidates.size();
+		}
+
+		std::vector<Coord2D> accepted;
+		accepted.reserve(candidates.size());
+
+		for (std::size_t i = 0; i < candidates.size(); i++) {
+			Coord2D const &coord = candidates[i];
+
+			if (coord == startpoint || coord == endpoint || waypoints.count(coord) || !inside[i]) {
+				continue;
+			}
+
+			accepted.push_back(coord);
+		}
+
+		std::size_t rejected = coords.size() - accepted.size();
+
+		if (rejected != 0) {
+			statusText_->setText(statusText_->tr("%1 of %2 waypoints are duplicates, startpoint, endpoint or outside domain, not inserted.\n").arg(rejected).arg(coords.size()));
+		}
+
+		if (accepted.empty()) {
+			return 0;
+		}
+
+		triangulation.insert(accepted);
+		// accepted is sorted, so every insertion goes to the end of the set
+		waypoints.insert(accepted.begin(), accepted.end());
+		waypointsChanged();
+
+		return accepted.size();
+	}
+
 	bool remove(Coord2D const &coord)
 	{
 		if (coord == startpoint || coord == endpoint) {
@@ -198,6 +438,7 @@ struct Room::RoomImpl
 		triangulation.remove(coord);
 		waypoints.erase(coord);
 		assert(!triangulation.pointIsVertex(coord));
+		waypointsChanged();
 
 		return true;
 	}
@@ -213,7 +454,7 @@ struct Room::RoomImpl
 			return false;
 		}
 
-		if (!roomTriangulation.inDomain(coord.x, coord.y)) {
+		if (!inDomain(coord.x, coord.y)) {
 			statusText_->setText(statusText_->tr("Startpoint (%1/%2) outside domain, can't insert.\n").arg(coord.x).arg(coord.y));
 			return false;
 		}
@@ -227,6 +468,7 @@ struct Room::RoomImpl
 
 		triangulation.insert(coord);
 		startpoint = coord;
+		waypointsChanged();
 
 		return true;
 	}
@@ -242,7 +484,7 @@ struct Room::RoomImpl
 			return false;
 		}
 
-		if (!roomTriangulation.inDomain(coord.x, coord.y)) {
+		if (!inDomain(coord.x, coord.y)) {
 			statusText_->setText(statusText_->tr("Endpoint (%1/%2) outside domain, can't insert.\n").arg(coord.x).arg(coord.y));
 			return false;
 		}
@@ -256,20 +498,28 @@ struct Room::RoomImpl
 
 		triangulation.insert(coord);
 		endpoint = coord;
+		waypointsChanged();
 
 		return true;
 	}
 
+	// draws batches of random coordinates until amount of them were inserted
 	void setNodes(int amount)
 	{
-		for (int i = 0; i < amount; i++) {
-			int randX = randomAtMost(width - 1);
-			int randY = randomAtMost(height - 1);
+		std::size_t missing = amount > 0 ? amount : 0;
 
-			if (!insert(Coord2D(randX, randY))) {
-				i--;
-				continue;
+		while (missing != 0) {
+			std::vector<Coord2D> coords;
+			coords.reserve(missing);
+
+			for (std::size_t i = 0; i < missing; i++) {
+				int randX = randomAtMost(width - 1);
+				int randY = randomAtMost(height - 1);
+
+				coords.push_back(Coord2D(randX, randY));
 			}
+
+			missing -= insert(coords);
 		}
 
 		setDoorWaypoints();
@@ -303,186 +553,353 @@ struct Room::RoomImpl
 		}
 	}
 
-	bool pointInside(float x, float y) const
+	bool inDomain(float x, float y) const
 	{
+		QMutexLocker locker(&geometryMutex);
+
+		inDomainCalls++;
+
 		return roomTriangulation.inDomain(x, y);
 	}
 
-	bool intersectsEdges(Edge const &checkEdge_) const
+	bool pointInside(float x, float y) const
 	{
-		Edge checkEdge(checkEdge_);
+		return inDomain(x, y);
+	}
 
-		int r[2] = {
-			static_cast<int>(checkEdge.end.x) - static_cast<int>(checkEdge.start.x),
-			static_cast<int>(checkEdge.end.y) - static_cast<int>(checkEdge.start.y)
-		};
+	bool intersectsEdges(Edge const &checkEdge) const
+	{
+		TRACE_SPAN("intersectsEdges");
 
-		for (std::vector< std::vector<Edge> >::const_iterator it = edges.begin();
-		     it != edges.end();
-		     it++) {
-			std::vector< Coord2DTemplate<float> > intersectionPoints;
-
-			for (std::vector<Edge>::const_iterator eit = it->begin(); eit != it->end(); eit++) {
-				Edge edge = *eit;
-
-				int s[2] = {
-					static_cast<int>(edge.end.x) - static_cast<int>(edge.start.x),
-					static_cast<int>(edge.end.y) - static_cast<int>(edge.start.y)
-				};
-
-				float x, y;
-
-				Coord2D diffPoint(edge.start.x - checkEdge.start.x, edge.start.y - checkEdge.start.y);
-				int diffPointCrossR = diffPoint.x * r[1] - diffPoint.y * r[0];
-				int rCrossS = r[0] * s[1] - r[1] * s[0];
-
-				if (rCrossS == 0) {
-					if (diffPointCrossR == 0) {
-						int diffPointMultR = diffPoint.x * r[0] + diffPoint.y * r[1];
-						int diffPointMultS = diffPoint.x * s[0] + diffPoint.y * s[1];
-						int rMultR = r[0] * r[0] + r[1] * r[1];
-						int sMultS = s[0] * s[0] + s[1] * s[1];
-
-						if ((0 <= diffPointMultR) && (diffPointMultR <= rMultR)) {
-							return true;
-						} else if ((0 <= diffPointMultS) && (diffPointMultS <= sMultS)) {
-							return true;
-						} else {
-							continue;
-						}
-					} else {
-						continue;
-					}
-				} else {
-					int diffPointCrossS = diffPoint.x * s[1] - diffPoint.y * s[0];
-					float u = diffPointCrossR / static_cast<float>(rCrossS);
-					float t = diffPointCrossS / static_cast<float>(rCrossS);
-
-					if ((0 <= u) && (u <= 1) && (0 <= t) && (t <= 1)) {
-						x = checkEdge.start.x + t * r[0];
-						y = checkEdge.start.y + t * r[1];
-					} else {
-						continue;
-					}
-				}
+		QMutexLocker locker(&geometryMutex);
 
-				int maxCheckX = std::max(checkEdge.start.x, checkEdge.end.x);
-				int maxCheckY = std::max(checkEdge.start.y, checkEdge.end.y);
-				int minCheckX = std::min(checkEdge.start.x, checkEdge.end.x);
-				int minCheckY = std::min(checkEdge.start.y, checkEdge.end.y);
+		// only the faces along the edge are visited, independent of the room size
+		return !roomTriangulation.segmentInDomain(checkEdge.start, checkEdge.end);
+	}
 
-				int maxX = std::max(edge.start.x, edge.end.x);
-				int maxY = std::max(edge.start.y, edge.end.y);
-				int minX = std::min(edge.start.x, edge.end.x);
-				int minY = std::min(edge.start.y, edge.end.y);
+	void setAlgorithm(Room::Algorithm algorithm)
+	{
+		this->algorithm = algorithm;
+	}
 
-				if (x < minCheckX || x > maxCheckX) {
-					continue;
-				}
+	Room::Algorithm getAlgorithm() const
+	{
+		return algorithm;
+	}
 
-				if (x < minX || x > maxX) {
-					continue;
-				}
+	std::vector<Coord2D> generatePath()
+	{
+		PlanningJob *job = createPlanningJob();
 
-				if (y < minCheckY || y > maxCheckY) {
-					continue;
-				}
+		runPlanningJob(*job);
+		storePlanningJob(*job);
 
-				if (y < minY || y > maxY) {
-					continue;
-				}
+		std::vector<Coord2D> generatedPath = job->path;
+		delete job;
 
-				Coord2DTemplate<float> intersectionPoint(x, y);
+		return generatedPath;
+	}
 
-				intersectionPoints.push_back(intersectionPoint);
+	PlanningJob *createPlanningJob() const
+	{
+		PlanningJob *job = new PlanningJob();
+
+		job->version = version;
+		job->algorithm = algorithm;
+		// region graphs and contraction hierarchies need the whole roadmap validated up front
+		job->lazyValidation = lazyValidation && !preprocessed(algorithm);
+		job->startpoint = startpoint;
+		job->endpoint = endpoint;
+
+		if (hierarchical(algorithm) && regionGraphAlgorithm == algorithm) {
+			// an older graph still has the distances of the regions the edits didn't touch
+			if (regionGraphVersion == version) {
+				job->regionGraph = regionGraph;
+			} else {
+				job->previousRegionGraph = regionGraph;
 			}
+		}
 
-			if (intersectionPoints.size() >= 2) {
-				for (size_t i = 0; i < intersectionPoints.size(); i++) {
-					size_t next = i + 1;
+		if (algorithm == Room::Contraction && contractionVersion == version) {
+			job->contractionHierarchy = contractionHierarchy;
+		}
 
-					if (next == intersectionPoints.size()) {
-						next = 0;
-					}
+		if (job->lazyValidation) {
+			// the job only records the edges it removes and validates, see storePlanningJob()
+			if (lazyVersion == version) {
+				job->roadmap = lazyNeighbours;
+				job->knownEdges = validatedEdges;
+				job->roadmapCached = true;
+			} else {
+				job->roadmap = QSharedPointer<NeighboursMap>(new NeighboursMap(triangulation.getNeighbours()));
+			}
+		} else if (validatedVersion == version) {
+			// a validated roadmap is never modified again and can be shared
+			job->roadmap = validatedNeighbours;
+			job->roadmapValidated = true;
+			job->roadmapCached = true;
+		} else {
+			job->roadmap = QSharedPointer<NeighboursMap>(new NeighboursMap(triangulation.getNeighbours()));
+		}
+
+		return job;
+	}
+
+	// only reads the job and the room geometry, which doesn't change after construction
+	void runPlanningJob(PlanningJob &job) const
+	{
+		if (job.lazyValidation) {
+			runLazyPlanningJob(job);
+			return;
+		}
+
+		QElapsedTimer timer;
+
+		if (!job.roadmapValidated) {
+			TRACE_SPAN("validate roadmap");
+
+			timer.start();
+
+			NeighboursMap &neighbours = *job.roadmap;
+
+			for (NeighboursMap::iterator it = neighbours.begin(); it != neighbours.end(); it++) {
+				if (job.cancelled()) {
+					return;
+				}
 
-					Coord2DTemplate<float> start(intersectionPoints[i]);
-					Coord2DTemplate<float> end(intersectionPoints[next]);
+				for (std::set<Coord2D>::iterator nit = it->second.begin(); nit != it->second.end();) {
+					Edge checkEdge(it->first, *nit);
 
-					float checkX = (start.x + end.x) / 2.0;
-					float checkY = (start.y + end.y) / 2.0;
+					job.edgeValidations++;
 
-					if (!roomTriangulation.inDomain(checkX, checkY)) {
-						return true;
+					if (intersectsEdges(checkEdge)) {
+						it->second.erase(nit++);
+					} else {
+						++nit;
 					}
 				}
+			}
 
-				continue;
+			job.roadmapValidated = true;
+			job.validationTime = timer.nsecsElapsed();
+		}
+
+		if (hierarchical(job.algorithm) && !job.regionGraph) {
+			if (job.cancelled()) {
+				return;
 			}
 
-			if (!intersectionPoints.empty()) {
-				float x = intersectionPoints[0].x;
-				float y = intersectionPoints[0].y;
+			TRACE_SPAN("build region graph");
 
-				if ((x == checkEdge.start.x && y == checkEdge.start.y) ||
-				    (x == checkEdge.end.x && y == checkEdge.end.y)) {
-					continue;
+			timer.start();
+
+			CompactRoadmap roadmap;
+			compactRoadmap(*job.roadmap, roadmap);
+
+			std::vector<int> nodeRegions;
+
+			if (job.algorithm == Room::DoorGraph) {
+				// door waypoints aren't inside a room, each one becomes a region of its own
+				nodeRegions.resize(roadmap.nodes.size());
+
+				for (std::size_t i = 0; i < roadmap.nodes.size(); i++) {
+					nodeRegions[i] = regions.region(roadmap.nodes[i]);
 				}
+			} else {
+				nodeRegions = clusterRegions(roadmap, clusterSize(width, height, roadmap.nodes.size()));
+			}
 
-				return true;
+			// the clusters are only refined once a search reaches them
+			job.regionGraph = QSharedPointer<RegionGraph>(new RegionGraph(roadmap, nodeRegions,
+			                                                              job.algorithm == Room::ClusterGraph,
+			                                                              job.previousRegionGraph.data()));
+			job.hierarchyTime = timer.nsecsElapsed();
+		}
+
+		if (job.algorithm == Room::Contraction && !job.contractionHierarchy) {
+			if (job.cancelled()) {
+				return;
 			}
+
+			TRACE_SPAN("build contraction hierarchy");
+
+			timer.start();
+
+			CompactRoadmap roadmap;
+			compactRoadmap(*job.roadmap, roadmap);
+
+			job.contractionHierarchy = QSharedPointer<ContractionHierarchy>(new ContractionHierarchy(roadmap));
+			job.hierarchyTime = timer.nsecsElapsed();
 		}
 
-		return false;
+		timer.start();
+
+		job.path = search(*job.roadmap, job);
+
+		job.pathTime = timer.nsecsElapsed();
 	}
 
-	void setAlgorithm(Room::Algorithm algorithm)
+	void runLazyPlanningJob(PlanningJob &job) const
 	{
-		this->algorithm = algorithm;
+		QElapsedTimer timer;
+
+		timer.start();
+
+		// search the unvalidated roadmap and only check the edges of the found path,
+		// invalid ones are left out and the search is repeated
+		while (!job.cancelled()) {
+			std::vector<Coord2D> generatedPath = search(*job.roadmap, job);
+			bool pathValid = true;
+
+			for (std::size_t i = 0; i + 1 < generatedPath.size(); i++) {
+				Coord2D const &first = generatedPath[i];
+				Coord2D const &second = generatedPath[i + 1];
+
+				if (!edgeValid(first, second, job)) {
+					job.removedEdges.insert(first < second ? std::make_pair(first, second) : std::make_pair(second, first));
+					pathValid = false;
+				}
+			}
+
+			if (pathValid) {
+				job.path = generatedPath;
+				job.pathTime = timer.nsecsElapsed();
+				return;
+			}
+		}
 	}
 
-	Room::Algorithm getAlgorithm() const
+	bool edgeValid(Coord2D const &first, Coord2D const &second, PlanningJob &job) const
 	{
-		return algorithm;
+		RoadmapEdge key = first < second ? std::make_pair(first, second) : std::make_pair(second, first);
+		std::map<RoadmapEdge, bool>::const_iterator it = job.validatedEdges.find(key);
+
+		if (it != job.validatedEdges.end()) {
+			return it->second;
+		}
+
+		if (job.knownEdges) {
+			it = job.knownEdges->find(key);
+
+			if (it != job.knownEdges->end()) {
+				return it->second;
+			}
+		}
+
+		job.edgeValidations++;
+
+		bool valid = !intersectsEdges(Edge(key.first, key.second));
+		job.validatedEdges[key] = valid;
+
+		return valid;
 	}
 
-	std::vector<Coord2D> generatePath()
+	std::vector<Coord2D> search(NeighboursMap const &neighbours, PlanningJob &job) const
 	{
-		NeighboursMap neighbours = triangulation.getNeighbours();
+		if (job.algorithm == Room::Dijkstra) {
+			return dijkstra(neighbours, job.startpoint, job.endpoint, &job.nodesExpanded, &job.removedEdges);
+		}
 
-		for (NeighboursMap::iterator it = neighbours.begin(); it != neighbours.end(); it++) {
-			for (std::set<Coord2D>::iterator nit = it->second.begin(); nit != it->second.end();) {
-				Edge checkEdge(it->first, *nit);
+		if (hierarchical(job.algorithm)) {
+			return job.regionGraph->findPath(job.startpoint, job.endpoint, &job.nodesExpanded);
+		}
 
-				if (intersectsEdges(checkEdge)) {
-					it->second.erase(nit++);
-				} else {
-					++nit;
-				}
-			}
+		if (job.algorithm == Room::Contraction) {
+			return job.contractionHierarchy->findPath(job.startpoint, job.endpoint, &job.nodesExpanded);
 		}
 
-		std::vector<Coord2D> generatedPath;
+		return astar(neighbours, job.startpoint, job.endpoint, &job.nodesExpanded, &job.removedEdges);
+	}
 
-		stats->lastUsedAlgorithm = algorithm;
+	// takes over the validation work of a finished job, if the room didn't change meanwhile
+	void storePlanningJob(PlanningJob const &job)
+	{
+		std::string const name = algorithmName(job.algorithm);
 
-		QElapsedTimer timer;
+		stats->count(name + " searches");
+		stats->count("edges validated", job.edgeValidations);
+		stats->count("nodes expanded", job.nodesExpanded);
+		stats->count(job.roadmapCached ? "roadmap cache hits" : "roadmap cache misses");
 
-		timer.start();
+		{
+			QMutexLocker locker(&geometryMutex);
+			stats->setCounter("inDomain calls", inDomainCalls);
+		}
 
-		if (algorithm == Room::Dijkstra) {
-			generatedPath = dijkstra(neighbours, startpoint, endpoint);
-		} else {
-			generatedPath = astar(neighbours, startpoint, endpoint);
+		// lazy jobs validate while searching, pathTime covers both
+		if (!job.lazyValidation && !job.roadmapCached && job.roadmapValidated) {
+			stats->record("roadmap validation", job.validationTime);
+		}
+
+		if (job.hierarchyTime && job.regionGraph) {
+			stats->record(name + " build", job.hierarchyTime);
+			stats->setCounter(name + " regions", job.regionGraph->regions());
+			stats->setCounter(name + " portals", job.regionGraph->boundaryNodes());
+			stats->setCounter(name + " regions reused", job.regionGraph->reusedRegions());
 		}
 
-		stats->lastPathCalculation = timer.elapsed();
+		if (job.regionGraph) {
+			stats->setCounter("region tables computed", job.regionGraph->computedRegions());
+		}
 
-		return generatedPath;
+		if (job.hierarchyTime && job.contractionHierarchy) {
+			stats->record(name + " build", job.hierarchyTime);
+			stats->setCounter(name + " shortcuts", job.contractionHierarchy->shortcuts());
+			stats->setCounter(name + " bytes", job.contractionHierarchy->memoryUsage());
+		}
+
+		// per algorithm as well, so their query times can be compared
+		stats->record("path search", job.pathTime);
+		stats->record("path search (" + name + ")", job.pathTime);
+
+		if (job.version != version || job.cancelled()) {
+			return;
+		}
+
+		if (job.lazyValidation) {
+			storeLazyValidation(job);
+		} else if (job.roadmapValidated) {
+			validatedNeighbours = job.roadmap;
+			validatedVersion = job.version;
+		}
+
+		if (job.regionGraph) {
+			regionGraph = job.regionGraph;
+			regionGraphAlgorithm = job.algorithm;
+			regionGraphVersion = job.version;
+		}
+
+		if (job.contractionHierarchy) {
+			contractionHierarchy = job.contractionHierarchy;
+			contractionVersion = job.version;
+		}
+	}
+
+	// merges the edges the job removed and validated into the shared lazy roadmap in place,
+	// the stored job is the newest one and no other job is running on it anymore
+	void storeLazyValidation(PlanningJob const &job)
+	{
+		if (lazyVersion != job.version) {
+			// the job built the roadmap itself
+			lazyNeighbours = job.roadmap;
+			validatedEdges = QSharedPointer< std::map<RoadmapEdge, bool> >(new std::map<RoadmapEdge, bool>());
+			lazyVersion = job.version;
+		}
+
+		NeighboursMap &neighbours = *lazyNeighbours;
+
+		for (std::set<RoadmapEdge>::const_iterator it = job.removedEdges.begin(); it != job.removedEdges.end(); ++it) {
+			neighbours[it->first].erase(it->second);
+			neighbours[it->second].erase(it->first);
+		}
+
+		validatedEdges->insert(job.validatedEdges.begin(), job.validatedEdges.end());
 	}
 
 	void reinitializeTriangulation()
 	{
 		triangulation.clear();
+		waypointsChanged();
 
 		Coord2D newStartpoint = startpoint;
 		startpoint = Coord2D(0, 0);
@@ -500,6 +917,9 @@ struct Room::RoomImpl
 
 		reader->readNextStartElement();
 
+		std::vector<Coord2D> loadedWaypoints;
+		QByteArray roadmapData;
+
 		while (true) {
 			if (reader->isStartElement()) {
 				QString name = reader->name().toString();
@@ -507,14 +927,28 @@ struct Room::RoomImpl
 				unsigned int xValue = attributes.value("x").toString().toUInt();
 				unsigned int yValue = attributes.value("y").toString().toUInt();
 
+				if (name == "roadmap") {
+					// the binary roadmap section, base64 encoded
+					roadmapData = QByteArray::fromBase64(reader->readElementText().toLatin1());
+					reader->readNextStartElement();
+					continue;
+				}
+
 				if (name == "startpoint") {
 					setStartpoint(Coord2D(xValue, yValue));
 				} else if (name == "endpoint") {
 					setEndpoint(Coord2D(xValue, yValue));
 				} else if (name == "waypoint") {
-					insert(Coord2D(xValue, yValue));
+					loadedWaypoints.push_back(Coord2D(xValue, yValue));
 				}
 			} else if (reader->isEndElement() && reader->name().toString() == "room") {
+				insert(loadedWaypoints);
+
+				if (!roadmapData.isEmpty()) {
+					BinaryReader roadmapReader(roadmapData.constData(), roadmapData.size());
+					loadRoadmap(roadmapReader);
+				}
+
 				return true;
 			}
 
@@ -550,10 +984,173 @@ struct Room::RoomImpl
 			writer->writeAttribute("", "y", QString::number(it->y));
 		}
 
+		std::vector<char> roadmapData;
+		BinaryWriter roadmapWriter(roadmapData);
+
+		if (saveRoadmap(roadmapWriter)) {
+			writer->writeTextElement("", "roadmap", QString::fromLatin1(QByteArray(&roadmapData[0], roadmapData.size()).toBase64()));
+		}
+
 		writer->writeEndElement();
 
 		return !writer->hasError();
 	}
+
+	// startpoint, endpoint and waypoints in ascending order, like the keys of the roadmap
+	std::vector<Coord2D> roadmapNodes() const
+	{
+		std::vector<Coord2D> nodes(waypoints.begin(), waypoints.end());
+
+		nodes.push_back(startpoint);
+		nodes.push_back(endpoint);
+		std::sort(nodes.begin(), nodes.end());
+
+		return nodes;
+	}
+
+	// checksum and the roadmap, only if the current roadmap is fully validated
+	bool saveRoadmap(BinaryWriter &writer) const
+	{
+		if (validatedVersion != version || !validatedNeighbours) {
+			return false;
+		}
+
+		CompactRoadmap roadmap;
+		compactRoadmap(*validatedNeighbours, roadmap);
+
+		if (roadmap.nodes != roadmapNodes()) {
+			return false;
+		}
+
+		writer.writeVarint(roadmapChecksum(imageHash, distance, roadmap.nodes));
+		writeRoadmap(writer, roadmap);
+
+		return true;
+	}
+
+	// a roadmap that doesn't fit the room is just skipped, the planner validates a new one then
+	bool loadRoadmap(BinaryReader &reader)
+	{
+		CompactRoadmap roadmap;
+		roadmap.nodes = roadmapNodes();
+
+		uint64_t checksum;
+		QSharedPointer<NeighboursMap> neighbours(new NeighboursMap());
+
+		if (!reader.readVarint(checksum) || checksum != roadmapChecksum(imageHash, distance, roadmap.nodes) ||
+		    !readRoadmap(reader, roadmap) || !expandRoadmap(roadmap, *neighbours)) {
+			statusText_->setText(statusText_->tr("The stored roadmap doesn't match the room, it will be validated again.\n"));
+			return false;
+		}
+
+		validatedNeighbours = neighbours;
+		validatedVersion = version;
+
+		return true;
+	}
+
+	// startpoint, endpoint and the waypoints in ascending order, x as delta to the
+	// previous waypoint and y as signed delta, so dense rooms need a few bytes per waypoint,
+	// then the optional roadmap section
+	bool loadBinaryProject(BinaryReader &reader)
+	{
+		uint64_t startX, startY, endX, endY, count;
+
+		if (!reader.readVarint(startX) || !reader.readVarint(startY) ||
+		    !reader.readVarint(endX) || !reader.readVarint(endY) ||
+		    !reader.readVarint(count)) {
+			return false;
+		}
+
+		// every waypoint needs at least two bytes, don't trust the count blindly
+		if (count > reader.remaining() / 2) {
+			return false;
+		}
+
+		setStartpoint(Coord2D(startX, startY));
+		setEndpoint(Coord2D(endX, endY));
+
+		std::vector<Coord2D> loadedWaypoints;
+		loadedWaypoints.reserve(count);
+
+		int64_t x = 0;
+		int64_t y = 0;
+
+		for (uint64_t i = 0; i < count; i++) {
+			uint64_t deltaX;
+			int64_t deltaY;
+
+			if (!reader.readVarint(deltaX) || !reader.readSignedVarint(deltaY)) {
+				return false;
+			}
+
+			x += deltaX;
+			y += deltaY;
+
+			if (x >= width || y < 0 || y >= height) {
+				return false;
+			}
+
+			loadedWaypoints.push_back(Coord2D(x, y));
+		}
+
+		insert(loadedWaypoints);
+
+		// version 1 projects end after the waypoints, they have no roadmap
+		if (reader.atEnd()) {
+			return true;
+		}
+
+		uint64_t roadmapSize;
+
+		if (!reader.readVarint(roadmapSize) || roadmapSize > reader.remaining()) {
+			return false;
+		}
+
+		if (roadmapSize != 0) {
+			std::vector<char> roadmapData(roadmapSize);
+
+			reader.readBytes(&roadmapData[0], roadmapSize);
+
+			BinaryReader roadmapReader(&roadmapData[0], roadmapData.size());
+			loadRoadmap(roadmapReader);
+		}
+
+		return true;
+	}
+
+	void saveBinaryProject(BinaryWriter &writer) const
+	{
+		writer.writeVarint(startpoint.x);
+		writer.writeVarint(startpoint.y);
+		writer.writeVarint(endpoint.x);
+		writer.writeVarint(endpoint.y);
+		writer.writeVarint(waypoints.size());
+
+		int64_t x = 0;
+		int64_t y = 0;
+
+		for (std::set<Coord2D>::const_iterator it = waypoints.begin();
+		     it != waypoints.end();
+		     ++it) {
+			writer.writeVarint(it->x - x);
+			writer.writeSignedVarint(static_cast<int64_t>(it->y) - y);
+			x = it->x;
+			y = it->y;
+		}
+
+		// the roadmap section is optional and prefixed by its size, zero if there's none
+		std::vector<char> roadmapData;
+		BinaryWriter roadmapWriter(roadmapData);
+
+		saveRoadmap(roadmapWriter);
+
+		writer.writeVarint(roadmapData.size());
+
+		if (!roadmapData.empty()) {
+			writer.writeBytes(&roadmapData[0], roadmapData.size());
+		}
+	}
 };
 
 
@@ -588,6 +1185,40 @@ RoomImage const &Room::image() const
 	return *p->image;
 }
 
+Room::Stage Room::stage() const
+{
+	return static_cast<Stage>(p->stage.loadAcquire());
+}
+
+void Room::releaseImageData()
+{
+	assert(stage() >= StageContours);
+
+	p->image->releaseData();
+}
+
+void Room::extractContours()
+{
+	p->extractContours();
+}
+
+void Room::triangulate()
+{
+	p->triangulate();
+}
+
+void Room::placeEndpoints()
+{
+	p->placeEndpoints();
+}
+
+void Room::preprocess()
+{
+	p->extractContours();
+	p->triangulate();
+	p->placeEndpoints();
+}
+
 bool Room::setStartpoint(Coord2D const &coord)
 {
 	return p->setStartpoint(coord);
@@ -618,6 +1249,11 @@ bool Room::insertWaypoint(Coord2D const &coord)
 	return p->insert(coord);
 }
 
+std::size_t Room::insertWaypoints(std::vector<Coord2D> const &coords)
+{
+	return p->insert(coords);
+}
+
 bool Room::removeWaypoint(Coord2D const &coord)
 {
 	return p->remove(coord);
@@ -634,6 +1270,26 @@ bool Room::hasWaypoint(Coord2D const &coord) const
 	return p->triangulation.pointIsVertex(coord);
 }
 
+bool Room::nearestWaypoint(Coord2D const &coord, unsigned int distance, Coord2D &nearest) const
+{
+	Coord2D found;
+
+	if (!p->triangulation.nearestVertex(coord, found)) {
+		return false;
+	}
+
+	unsigned int diffX = found.x > coord.x ? found.x - coord.x : coord.x - found.x;
+	unsigned int diffY = found.y > coord.y ? found.y - coord.y : coord.y - found.y;
+
+	if (diffX > distance || diffY > distance) {
+		return false;
+	}
+
+	nearest = found;
+
+	return true;
+}
+
 std::set<Coord2D> const &Room::getWaypoints() const
 {
 	return p->waypoints;
@@ -649,6 +1305,21 @@ Room::Algorithm Room::getAlgorithm() const
 	return p->getAlgorithm();
 }
 
+void Room::setLazyValidation(bool enabled)
+{
+	p->lazyValidation = enabled;
+}
+
+bool Room::getLazyValidation() const
+{
+	return p->lazyValidation;
+}
+
+unsigned long Room::version() const
+{
+	return p->version;
+}
+
 NeighboursMap Room::getNeighbours() const
 {
 	return p->triangulation.getNeighbours();
@@ -656,7 +1327,7 @@ NeighboursMap Room::getNeighbours() const
 
 std::vector< std::vector<Edge> > Room::getEdges() const
 {
-	return p->edges;
+	return p->walls.polygons();
 }
 
 bool Room::pointInside(float x, float y) const
@@ -684,6 +1355,21 @@ std::vector<Coord2D> Room::generatePath() const
 	return p->generatePath();
 }
 
+PlanningJob *Room::createPlanningJob() const
+{
+	return p->createPlanningJob();
+}
+
+void Room::runPlanningJob(PlanningJob &job) const
+{
+	p->runPlanningJob(job);
+}
+
+void Room::storePlanningJob(PlanningJob const &job)
+{
+	p->storePlanningJob(job);
+}
+
 bool Room::loadProject(QXmlStreamReader *reader)
 {
 	return p->loadProject(reader);
@@ -693,3 +1379,13 @@ bool Room::saveProject(QXmlStreamWriter *writer) const
 {
 	return p->saveProject(writer);
 }
+
+bool Room::loadBinaryProject(BinaryReader &reader)
+{
+	return p->loadBinaryProject(reader);
+}
+
+void Room::saveBinaryProject(BinaryWriter &writer) const
+{
+	p->saveBinaryProject(writer);
+}
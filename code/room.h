@@ -6,10 +6,14 @@
 #include "neighbours.h"
 #include "triangle.h"
 
+#include <cstddef>
 #include <set>
 #include <string>
 #include <vector>
 
+class BinaryReader;
+class BinaryWriter;
+struct PlanningJob;
 class QTextEdit;
 class QXmlStreamReader;
 class QXmlStreamWriter;
@@ -22,14 +26,42 @@ public:
 	enum Algorithm
 	{
 		Dijkstra,
-		AStar
+		AStar,
+		// searches the rooms of the endpoints and the graph between the doors
+		DoorGraph,
+		// the same over square clusters, for big rooms without doors
+		ClusterGraph,
+		// bidirectional search on a contraction hierarchy of the roadmap, for many queries
+		Contraction
 	};
 
+	// preprocessing stages, every stage needs the previous one
+	enum Stage
+	{
+		StageDecoded,
+		StageContours,
+		StageTriangulated,
+		StageReady
+	};
+
+	// only decodes the image, the rest is done by the preprocessing stages
 	Room(std::string const &filename, unsigned char distance, Stats *stats, QTextEdit *statusText, QTextEdit *helpText);
 	~Room();
 
 	RoomImage const &image() const;
 
+	Stage stage() const;
+	// extractContours() and triangulate() may run on another thread, nothing else
+	// may use the room meanwhile
+	void extractContours();
+	void triangulate();
+	// GUI thread, places the startpoint, endpoint and door waypoints
+	void placeEndpoints();
+	// all stages at once
+	void preprocess();
+	// drops the colours of image() once the texture was created, the class map stays
+	void releaseImageData();
+
 	bool setStartpoint(Coord2D const &coord);
 	Coord2D getStartpoint() const;
 
@@ -39,13 +71,24 @@ public:
 	void setNodes(int amount);
 
 	bool insertWaypoint(Coord2D const &coord);
+	// skips invalid coordinates and returns how many were inserted, much faster than
+	// inserting one by one
+	std::size_t insertWaypoints(std::vector<Coord2D> const &coords);
 	bool removeWaypoint(Coord2D const &coord);
 	void clearWaypoints();
 	bool hasWaypoint(Coord2D const &coord) const;
+	// nearest waypoint (or startpoint/endpoint) at most distance away in x and y
+	bool nearestWaypoint(Coord2D const &coord, unsigned int distance, Coord2D &nearest) const;
 	std::set<Coord2D> const &getWaypoints() const;
 
 	void setAlgorithm(Algorithm algorithm);
 	Algorithm getAlgorithm() const;
+	// validate roadmap edges only when they are part of a found path, ignored by DoorGraph,
+	// ClusterGraph and Contraction
+	void setLazyValidation(bool enabled);
+	bool getLazyValidation() const;
+	// changes whenever the waypoints, the startpoint or the endpoint change
+	unsigned long version() const;
 
 	NeighboursMap getNeighbours() const;
 	std::vector< std::vector<Edge> > getEdges() const;
@@ -55,8 +98,17 @@ public:
 	std::vector<Triangle> getRoomTriangulation() const;
 	std::vector<Coord2D> generatePath() const;
 
+	// snapshot of the current waypoints for planning on another thread, the caller owns it
+	PlanningJob *createPlanningJob() const;
+	// may run on any thread, while the room is alive
+	void runPlanningJob(PlanningJob &job) const;
+	// GUI thread only, keeps the validated roadmap and updates the statistics
+	void storePlanningJob(PlanningJob const &job);
+
 	bool loadProject(QXmlStreamReader *reader);
 	bool saveProject(QXmlStreamWriter *writer) const;
+	bool loadBinaryProject(BinaryReader &reader);
+	void saveBinaryProject(BinaryWriter &writer) const;
 
 private:
 	class RoomImpl;
@@ -0,0 +1,292 @@
+#include "roomcache.h"
+#include "roomimage.h"
+#include "triangulation.h"
+
+#include <cstring>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSaveFile>
+#include <QtCore/QStandardPaths>
+
+namespace
+{
+	// bump whenever the layout or the preprocessing changes
+	uint32_t const cacheVersion = 2;
+	char const cacheMagic[8] = { 'R', 'O', 'B', 'R', 'O', 'O', 'M', '\0' };
+
+	// all offsets are from the start of the file, the sections follow the header
+	struct CacheHeader
+	{
+		char magic[8];
+		uint32_t version;
+		uint32_t distance;
+		uint64_t hash;
+		uint32_t width;
+		uint32_t height;
+		uint64_t classesOffset;
+		uint64_t polygonsOffset;
+		uint64_t polygonsSize;
+		uint64_t triangulationOffset;
+		uint64_t triangulationSize;
+	};
+
+	uint64_t fnv1a(uchar const *data, qint64 size, uint64_t hash);
+
+	uint64_t fnv1a(uchar const *data, qint64 size, uint64_t hash)
+	{
+		for (qint64 i = 0; i < size; i++) {
+			hash ^= data[i];
+			hash *= 1099511628211ull;
+		}
+
+		return hash;
+	}
+
+	bool inFile(uint64_t offset, uint64_t length, uint64_t size);
+
+	// written so that corrupt offsets and lengths near 2^64 can't wrap around
+	bool inFile(uint64_t offset, uint64_t length, uint64_t size)
+	{
+		return offset <= size && size - offset >= length;
+	}
+
+	void appendPolygons(std::vector<uint32_t> &buffer, std::vector<Polygon2D> const &polygons);
+
+	// count, then every polygon as its size followed by x and y of its points
+	void appendPolygons(std::vector<uint32_t> &buffer, std::vector<Polygon2D> const &polygons)
+	{
+		buffer.push_back(polygons.size());
+
+		for (std::vector<Polygon2D>::const_iterator it = polygons.begin(); it != polygons.end(); ++it) {
+			buffer.push_back(it->size());
+
+			for (Polygon2D::const_iterator pit = it->begin(); pit != it->end(); ++pit) {
+				buffer.push_back(pit->x);
+				buffer.push_back(pit->y);
+			}
+		}
+	}
+
+	bool readPolygons(uint32_t const *&data, uint32_t const *end, std::vector<Polygon2D> &polygons);
+
+	bool readPolygons(uint32_t const *&data, uint32_t const *end, std::vector<Polygon2D> &polygons)
+	{
+		if (data == end) {
+			return false;
+		}
+
+		uint32_t count = *data++;
+
+		polygons.clear();
+
+		for (uint32_t i = 0; i < count; i++) {
+			if (data == end) {
+				return false;
+			}
+
+			uint32_t size = *data++;
+
+			if (static_cast<std::size_t>(end - data) < static_cast<std::size_t>(size) * 2) {
+				return false;
+			}
+
+			Polygon2D polygon;
+			polygon.reserve(size);
+
+			for (uint32_t j = 0; j < size; j++, data += 2) {
+				polygon.push_back(Coord2D(data[0], data[1]));
+			}
+
+			polygons.push_back(polygon);
+		}
+
+		return true;
+	}
+}
+
+class RoomCache::RoomCacheImpl
+{
+public:
+	RoomCacheImpl(std::string const &imageFilename, unsigned char distance)
+		: distance(distance),
+		  hash(14695981039346656037ull)
+	{
+		QFile file(QString::fromStdString(imageFilename));
+
+		if (file.open(QIODevice::ReadOnly) && file.size() > 0) {
+			uchar *data = file.map(0, file.size());
+
+			if (data) {
+				hash = fnv1a(data, file.size(), hash);
+				file.unmap(data);
+			} else {
+				QByteArray content = file.readAll();
+				hash = fnv1a(reinterpret_cast<uchar const *>(content.constData()), content.size(), hash);
+			}
+		}
+
+		QString directory = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + "/rooms";
+		filename = directory + QString("/%1-%2.bin").arg(hash, 16, 16, QChar('0')).arg(distance);
+	}
+
+	bool load(RoomImage &image, std::vector<Polygon2D> &borderPolygons, std::vector<Polygon2D> &doorPolygons,
+	          ConstrainedDelaunayTriangulation &roomTriangulation) const
+	{
+		QFile file(filename);
+
+		if (!file.open(QIODevice::ReadOnly)) {
+			return false;
+		}
+
+		qint64 size = file.size();
+
+		if (size < static_cast<qint64>(sizeof(CacheHeader))) {
+			return false;
+		}
+
+		// the sections are read in place, only the results are copied out
+		uchar *data = file.map(0, size);
+
+		if (!data) {
+			return false;
+		}
+
+		bool result = load(reinterpret_cast<char const *>(data), static_cast<uint64_t>(size), image,
+		                   borderPolygons, doorPolygons, roomTriangulation);
+
+		file.unmap(data);
+
+		return result;
+	}
+
+	bool load(char const *data, uint64_t size, RoomImage &image, std::vector<Polygon2D> &borderPolygons,
+	          std::vector<Polygon2D> &doorPolygons, ConstrainedDelaunayTriangulation &roomTriangulation) const
+	{
+		CacheHeader header;
+		std::memcpy(&header, data, sizeof header);
+
+		if (std::memcmp(header.magic, cacheMagic, sizeof cacheMagic) != 0 || header.version != cacheVersion ||
+		    header.hash != hash || header.distance != distance ||
+		    header.width != image.width() || header.height != image.height()) {
+			return false;
+		}
+
+		uint64_t pixels = static_cast<uint64_t>(header.width) * header.height;
+
+		if (!inFile(header.classesOffset, pixels, size) ||
+		    !inFile(header.polygonsOffset, header.polygonsSize, size) || header.polygonsOffset % 4 != 0 ||
+		    !inFile(header.triangulationOffset, header.triangulationSize, size)) {
+			return false;
+		}
+
+		std::vector<Polygon2D> border;
+		std::vector<Polygon2D> doors;
+		uint32_t const *polygons = reinterpret_cast<uint32_t const *>(data + header.polygonsOffset);
+		uint32_t const *polygonsEnd = polygons + header.polygonsSize / 4;
+
+		if (!readPolygons(polygons, polygonsEnd, border) || !readPolygons(polygons, polygonsEnd, doors)) {
+			return false;
+		}
+
+		if (!roomTriangulation.deserialize(data + header.triangulationOffset, header.triangulationSize)) {
+			return false;
+		}
+
+		image.setClassMap(reinterpret_cast<unsigned char const *>(data + header.classesOffset));
+		borderPolygons.swap(border);
+		doorPolygons.swap(doors);
+
+		return true;
+	}
+
+	bool save(RoomImage const &image, std::vector<Polygon2D> const &borderPolygons,
+	          std::vector<Polygon2D> const &doorPolygons, ConstrainedDelaunayTriangulation const &roomTriangulation) const
+	{
+		std::vector<uint32_t> polygons;
+		std::vector<char> triangulation;
+
+		appendPolygons(polygons, borderPolygons);
+		appendPolygons(polygons, doorPolygons);
+		roomTriangulation.serialize(triangulation);
+
+		if (triangulation.empty()) {
+			return false;
+		}
+
+		std::vector<unsigned char> const &classes = image.classMap();
+		CacheHeader header;
+
+		std::memset(&header, 0, sizeof header);
+		std::memcpy(header.magic, cacheMagic, sizeof cacheMagic);
+		header.version = cacheVersion;
+		header.distance = distance;
+		header.hash = hash;
+		header.width = image.width();
+		header.height = image.height();
+		header.classesOffset = sizeof header;
+		// the polygons are read as uint32_t straight out of the mapping
+		header.polygonsOffset = (header.classesOffset + classes.size() + 7) / 8 * 8;
+		header.polygonsSize = polygons.size() * sizeof(uint32_t);
+		header.triangulationOffset = (header.polygonsOffset + header.polygonsSize + 7) / 8 * 8;
+		header.triangulationSize = triangulation.size();
+
+		QDir().mkpath(QFileInfo(filename).absolutePath());
+
+		// written to a temporary file first, so a crash never leaves a broken cache behind
+		QSaveFile file(filename);
+
+		if (!file.open(QIODevice::WriteOnly)) {
+			return false;
+		}
+
+		char const padding[8] = { 0 };
+
+		file.write(reinterpret_cast<char const *>(&header), sizeof header);
+		file.write(reinterpret_cast<char const *>(classes.data()), classes.size());
+		file.write(padding, header.polygonsOffset - header.classesOffset - classes.size());
+		file.write(reinterpret_cast<char const *>(polygons.data()), header.polygonsSize);
+		file.write(padding, header.triangulationOffset - header.polygonsOffset - header.polygonsSize);
+		file.write(triangulation.data(), triangulation.size());
+
+		return file.commit();
+	}
+
+	unsigned char distance;
+	uint64_t hash;
+	QString filename;
+};
+
+RoomCache::RoomCache(std::string const &imageFilename, unsigned char distance)
+	: p(new RoomCacheImpl(imageFilename, distance))
+{
+}
+
+RoomCache::~RoomCache()
+{
+	delete p;
+}
+
+bool RoomCache::load(RoomImage &image, std::vector<Polygon2D> &borderPolygons, std::vector<Polygon2D> &doorPolygons,
+                     ConstrainedDelaunayTriangulation &roomTriangulation) const
+{
+	return p->load(image, borderPolygons, doorPolygons, roomTriangulation);
+}
+
+bool RoomCache::save(RoomImage const &image, std::vector<Polygon2D> const &borderPolygons,
+                     std::vector<Polygon2D> const &doorPolygons,
+                     ConstrainedDelaunayTriangulation const &roomTriangulation) const
+{
+	return p->save(image, borderPolygons, doorPolygons, roomTriangulation);
+}
+
+uint64_t RoomCache::hash() const
+{
+	return p->hash;
+}
+
+std::string RoomCache::filename() const
+{
+	return p->filename.toStdString();
+}
@@ -0,0 +1,41 @@
+#ifndef ROB_ROOMCACHE_H_INCLUDED
+#define ROB_ROOMCACHE_H_INCLUDED
+
+#include "polygon.h"
+
+#include <string>
+#include <vector>
+
+#include <stdint.h>
+
+class ConstrainedDelaunayTriangulation;
+class RoomImage;
+
+// preprocessed rooms (class map, border and door polygons, room triangulation) stored
+// per image content and distance, so they only have to be computed on the first start
+class RoomCache
+{
+public:
+	// hashes the image file, the cache lives in the user's cache directory
+	RoomCache(std::string const &imageFilename, unsigned char distance);
+	~RoomCache();
+
+	// false if there's no cache file or it's outdated, only roomTriangulation may be cleared then
+	bool load(RoomImage &image, std::vector<Polygon2D> &borderPolygons, std::vector<Polygon2D> &doorPolygons,
+	          ConstrainedDelaunayTriangulation &roomTriangulation) const;
+	bool save(RoomImage const &image, std::vector<Polygon2D> const &borderPolygons,
+	          std::vector<Polygon2D> const &doorPolygons,
+	          ConstrainedDelaunayTriangulation const &roomTriangulation) const;
+
+	uint64_t hash() const;
+	std::string filename() const;
+
+private:
+	RoomCache(RoomCache const &other);
+	RoomCache &operator=(RoomCache const &other);
+
+	class RoomCacheImpl;
+	RoomCacheImpl *p;
+};
+
+#endif // ROB_ROOMCACHE_H_INCLUDED
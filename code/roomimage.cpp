@@ -1,103 +1,154 @@
+#include "classify.h"
+#include "parallel.h"
 #include "roomimage.h"
+#include "trace.h"
 
+#include <algorithm>
 #include <cassert>
-#include <map>
+#include <cstddef>
 #include <set>
 
 namespace
 {
-	bool isBlack(unsigned char const *bytes)
-	{
-		return bytes[0] == 0 && bytes[1] == 0 && bytes[2] == 0;
-	}
+	// rows handed to one thread at a time
+	unsigned int const bandRows = 64;
 
-	bool isGray(unsigned char const *bytes)
+	struct ClassifyBand
 	{
-		return bytes[0] == 200 && bytes[1] == 200 && bytes[2] == 200;
-	}
+		unsigned char const *bytes;
+		std::size_t stride;
+		unsigned int width;
+		unsigned char *classes;
 
-	bool isWhite(unsigned char const *bytes)
-	{
-		return bytes[0] == 255 && bytes[1] == 255 && bytes[2] == 255;
-	}
+		void operator()(unsigned int begin, unsigned int end) const
+		{
+			TRACE_SPAN("classify band");
 
-	std::vector<Coord2D> createNeighbours(Coord2D const &coord, unsigned int width, unsigned int height)
-	{
-		std::vector<Coord2D> neighbours;
-		bool addNorth = coord.y > 0;
-		bool addEast = coord.x < width - 1;
-		bool addSouth = coord.y < height - 1;
-		bool addWest = coord.x > 0;
-
-		if (addNorth) {
-			Coord2D north(coord.x, coord.y - 1);
-			neighbours.push_back(north);
-
-			if (addEast) {
-				Coord2D northEast(coord.x + 1, coord.y - 1);
-				neighbours.push_back(northEast);
-			}
+			std::size_t first = static_cast<std::size_t>(begin) * width;
+			std::size_t count = static_cast<std::size_t>(end - begin) * width;
 
-			if (addWest) {
-				Coord2D northWest(coord.x - 1, coord.y - 1);
-				neighbours.push_back(northWest);
-			}
+			classifyPixels(bytes + first * stride, stride, count, classes + first);
 		}
+	};
 
-		if (addSouth) {
-			Coord2D south(coord.x, coord.y + 1);
-			neighbours.push_back(south);
+	// inside and door pixels closer to a wall than the moving object allows become collisions,
+	// the window reaches distance / 2 rows into the neighbouring bands, which are only read
+	struct InflateBand
+	{
+		std::vector<unsigned char> const *classes;
+		std::vector<unsigned char> *coordTypes;
+		unsigned int width;
+		unsigned int height;
+		unsigned char distance;
+		unsigned char collision;
+
+		void operator()(unsigned int begin, unsigned int end) const
+		{
+			TRACE_SPAN("inflate band");
+
+			// the (distance * distance) window of the old checkNeighbourCollision()
+			long const low = -static_cast<long>(distance / 2);
+			long const high = low + static_cast<long>(distance) - 1;
+
+			for (unsigned int y = begin; y < end; y++) {
+				for (unsigned int x = 0; x < width; x++) {
+					std::size_t index = static_cast<std::size_t>(y) * width + x;
+					unsigned char pixelClass = (*classes)[index];
+
+					if (pixelClass != RoomImage::PixelInside && pixelClass != RoomImage::PixelDoor) {
+						continue;
+					}
 
-			if (addEast) {
-				Coord2D southEast(coord.x + 1, coord.y + 1);
-				neighbours.push_back(southEast);
-			}
+					long firstY = std::max(0L, static_cast<long>(y) + low);
+					long lastY = std::min(static_cast<long>(height) - 1, static_cast<long>(y) + high);
+					long firstX = std::max(0L, static_cast<long>(x) + low);
+					long lastX = std::min(static_cast<long>(width) - 1, static_cast<long>(x) + high);
+					bool collides = false;
+
+					for (long checkY = firstY; checkY <= lastY && !collides; checkY++) {
+						unsigned char const *row = &(*classes)[static_cast<std::size_t>(checkY) * width];
+
+						for (long checkX = firstX; checkX <= lastX; checkX++) {
+							if (row[checkX] == RoomImage::PixelWall) {
+								collides = true;
+								break;
+							}
+						}
+					}
 
-			if (addWest) {
-				Coord2D southWest(coord.x - 1, coord.y + 1);
-				neighbours.push_back(southWest);
+					if (collides) {
+						(*coordTypes)[index] = collision;
+					}
+				}
 			}
 		}
+	};
 
-		if (addEast) {
-			Coord2D east(coord.x + 1, coord.y);
-			neighbours.push_back(east);
-		}
+	// finds the inside and door pixels at the border of their area, the 8-neighbourhood
+	// reads one halo row of the bands above and below
+	struct BorderBand
+	{
+		std::vector<unsigned char> const *coordTypes;
+		unsigned int width;
+		unsigned int height;
+		std::vector< std::vector<Coord2D> > *insideCoords;
+		std::vector< std::vector<Coord2D> > *doorCoords;
+
+		void operator()(unsigned int begin, unsigned int end) const
+		{
+			TRACE_SPAN("border band");
+
+			std::vector<Coord2D> &inside = (*insideCoords)[begin / bandRows];
+			std::vector<Coord2D> &door = (*doorCoords)[begin / bandRows];
+
+			for (unsigned int y = begin; y < end; y++) {
+				for (unsigned int x = 0; x < width; x++) {
+					unsigned char coordType = (*coordTypes)[static_cast<std::size_t>(y) * width + x];
+					bool insideCoord = coordType == RoomImage::PixelInside;
+					bool doorCoord = coordType == RoomImage::PixelDoor;
+
+					if (!insideCoord && !doorCoord) {
+						continue;
+					}
 
-		if (addWest) {
-			Coord2D west(coord.x - 1, coord.y);
-			neighbours.push_back(west);
-		}
+					bool atDoorBorder = false;
+					bool atBorder = false;
 
-		return neighbours;
-	}
+					for (int dy = -1; dy <= 1; dy++) {
+						if ((dy < 0 && y == 0) || (dy > 0 && y == height - 1)) {
+							continue;
+						}
 
-	std::set<Coord2D> checkNeighbourCollision(Coord2D const &coord, unsigned int width, unsigned int height, unsigned char distance)
-	{
-		// check a quad of (distance * 2 + 1)^2
-		std::set<Coord2D> checks;
+						unsigned char const *row = &(*coordTypes)[static_cast<std::size_t>(y + dy) * width];
+
+						for (int dx = -1; dx <= 1; dx++) {
+							if ((dx == 0 && dy == 0) || (dx < 0 && x == 0) || (dx > 0 && x == width - 1)) {
+								continue;
+							}
+
+							unsigned char neighbourType = row[x + dx];
 
-		long checkX = coord.x;
-		long checkY = coord.y;
+							if (neighbourType != RoomImage::PixelDoor) {
+								atDoorBorder = true;
+							}
 
-		for (unsigned char i = 0; i < distance; i++) {
-			for (unsigned char j = 0; j < distance; j++) {
-				checkX = coord.x;
-				checkY = coord.y;
+							if (neighbourType != RoomImage::PixelInside && neighbourType != RoomImage::PixelDoor) {
+								atBorder = true;
+							}
+						}
+					}
 
-				checkX -= (distance / 2) - j;
-				checkY -= (distance / 2) - i;
+					if (doorCoord && atDoorBorder) {
+						door.push_back(Coord2D(x, y));
+					}
 
-				if (checkX < width && checkY < height) {
-					if (checkX >= 0 && checkY >= 0) {
-						checks.insert(Coord2D(checkX, checkY));
+					if (atBorder) {
+						inside.push_back(Coord2D(x, y));
 					}
 				}
 			}
 		}
-
-		return checks;
-	}
+	};
 }
 
 RoomImage::RoomImage(std::string const &filename)
@@ -105,10 +156,72 @@ RoomImage::RoomImage(std::string const &filename)
 {
 }
 
+void RoomImage::classify()
+{
+	TRACE_SPAN("RoomImage::classify");
+
+	std::size_t const pixels = static_cast<std::size_t>(width()) * height();
+	std::size_t const stride = type() == IMAGE_TYPE_RGB ? 3 : 4;
+
+	assert(data().size() == pixels * stride);
+
+	classes_.resize(pixels);
+
+	if (pixels == 0) {
+		return;
+	}
+
+	ClassifyBand band;
+	band.bytes = data().data();
+	band.stride = stride;
+	band.width = width();
+	band.classes = &classes_[0];
+
+	forEachBand(height(), bandRows, band);
+}
+
+void RoomImage::setClassMap(unsigned char const *classes)
+{
+	classes_.assign(classes, classes + static_cast<std::size_t>(width()) * height());
+}
+
+bool RoomImage::isClassified() const
+{
+	return !classes_.empty() || width() == 0 || height() == 0;
+}
+
+RoomImage::PixelClass RoomImage::pixelClass(unsigned int x, unsigned int y) const
+{
+	return static_cast<PixelClass>(classes_[static_cast<std::size_t>(y) * width() + x]);
+}
+
+std::vector<unsigned char> const &RoomImage::classMap() const
+{
+	return classes_;
+}
+
+std::vector<uint64_t> RoomImage::freeSpace() const
+{
+	std::vector<uint64_t> bits((classes_.size() + 63) / 64, 0);
+
+	for (std::size_t i = 0; i < classes_.size(); i++) {
+		if (classes_[i] == PixelInside || classes_[i] == PixelDoor) {
+			bits[i / 64] |= static_cast<uint64_t>(1) << (i % 64);
+		}
+	}
+
+	return bits;
+}
+
 std::vector<Polygon2D> RoomImage::expandPolygon(std::set<Coord2D> &coords) const
 {
 	std::vector<Polygon2D> borderPolygons;
 
+	// e.g. the doors of a plan without any
+	if (coords.empty()) {
+		return borderPolygons;
+	}
+
 	enum DirectionType {
 		WEST,
 		SOUTH,
@@ -120,6 +233,7 @@ std::vector<Polygon2D> RoomImage::expandPolygon(std::set<Coord2D> &coords) const
 	// walk east, sets store the coords low -> high
 	int currentDirection = EAST;
 	Coord2D coord = *coords.begin();
+	Coord2D polygonStart = coord;
 	currentPolygon.push_back(coord);
 
 	while (!coords.empty()) {
@@ -243,11 +357,17 @@ std::vector<Polygon2D> RoomImage::expandPolygon(std::set<Coord2D> &coords) const
 
 		coords.erase(coord);
 
-		if (switchedDirection) {
+		// the first polygon already starts with its first coord
+		if (switchedDirection && (currentPolygon.empty() || currentPolygon.back() != coord)) {
 			currentPolygon.push_back(coord);
 		}
 
 		if (newCoord == coords.end()) {
+			// a line which never turned only has its ends
+			if (currentPolygon.empty()) {
+				currentPolygon.push_back(polygonStart);
+			}
+
 			// support lines
 			if (currentPolygon.size() == 1) {
 				currentPolygon.push_back(coord);
@@ -261,6 +381,7 @@ std::vector<Polygon2D> RoomImage::expandPolygon(std::set<Coord2D> &coords) const
 			}
 
 			coord = *coords.begin();
+			polygonStart = coord;
 		} else {
 			coord = *newCoord;
 		}
@@ -272,90 +393,51 @@ std::vector<Polygon2D> RoomImage::expandPolygon(std::set<Coord2D> &coords) const
 void RoomImage::getBorderPolygons(unsigned char distance, std::vector<Polygon2D> &borderPolygons,
                                   std::vector<Polygon2D> &doorPolygons) const
 {
-	enum CoordType {
-		OUTSIDE,
-		WALL_OR_OBJECT_OUTLINE,
-		DOOR,
-		INSIDE,
-		COLLISION
-	};
+	TRACE_SPAN("RoomImage::getBorderPolygons");
 
-	typedef std::map<Coord2D, int> CoordTypesMap;
-
-	CoordTypesMap coordTypes;
-	unsigned char stride = type() == IMAGE_TYPE_RGB ? 3 : 4;
-
-	// stamp all coordinates with the appropriate type
-	for (unsigned int y = 0; y < height(); y++) {
-		for (unsigned int x = 0; x < width(); x++) {
-			Coord2D coord(x, y);
-			unsigned char const *bytes = data().data() + (y * width() + x) * stride;
-
-			if (isWhite(bytes)) {
-				coordTypes[coord] = OUTSIDE;
-			} else if (isBlack(bytes)) {
-				coordTypes[coord] = WALL_OR_OBJECT_OUTLINE;
-			} else if (isGray(bytes)) {
-				coordTypes[coord] = DOOR;
-			} else {
-				coordTypes[coord] = INSIDE;
-			}
-		}
-	}
+	assert(isClassified());
 
-	// mark points as collision which can't be passed by the moving object
-	CoordTypesMap copyCoordTypes = coordTypes;
+	// the pixel classes plus the inside and door pixels too close to a wall
+	unsigned char const COLLISION = PixelInside + 1;
 
-	for (CoordTypesMap::const_iterator it = copyCoordTypes.begin(); it != copyCoordTypes.end(); it++) {
-		if (it->second != INSIDE && it->second != DOOR) {
-			coordTypes[it->first] = it->second;
-			continue;
-		}
+	std::vector<unsigned char> coordTypes = classes_;
+	unsigned int const bands = (height() + bandRows - 1) / bandRows;
 
-		Coord2D coord(it->first.x, it->first.y);
-		std::set<Coord2D> checks = checkNeighbourCollision(coord, width(), height(), distance);
+	// every stage needs the neighbouring rows of the previous one, so the stages
+	// don't overlap while the bands of one stage run in parallel
+	InflateBand inflate;
+	inflate.classes = &classes_;
+	inflate.coordTypes = &coordTypes;
+	inflate.width = width();
+	inflate.height = height();
+	inflate.distance = distance;
+	inflate.collision = COLLISION;
 
-		for (std::set<Coord2D>::const_iterator cit = checks.begin(); cit != checks.end(); cit++) {
-			unsigned char const *bytes = data().data() + (cit->y * width() + cit->x) * stride;
+	forEachBand(height(), bandRows, inflate);
 
-			if (isBlack(bytes)) {
-				coordTypes[coord] = COLLISION;
-			}
-		}
-	}
+	std::vector< std::vector<Coord2D> > bandInsideCoords(bands);
+	std::vector< std::vector<Coord2D> > bandDoorCoords(bands);
 
-	std::set<Coord2D> insideCoords;
-	std::set<Coord2D> doorCoords;
+	BorderBand border;
+	border.coordTypes = &coordTypes;
+	border.width = width();
+	border.height = height();
+	border.insideCoords = &bandInsideCoords;
+	border.doorCoords = &bandDoorCoords;
 
-	// first find all coordinates inside the room
-	for (CoordTypesMap::const_iterator it = coordTypes.begin(); it != coordTypes.end(); it++) {
-		bool insideCoord = it->second == INSIDE;
-		bool doorCoord = it->second == DOOR;
-
-		if (!insideCoord && !doorCoord) {
-			continue;
-		}
+	forEachBand(height(), bandRows, border);
 
-		std::vector<Coord2D> neighbours = createNeighbours(it->first, width(), height());
-
-		// expand neighbours
-		for (std::vector<Coord2D>::const_iterator nit = neighbours.begin(); nit != neighbours.end(); nit++) {
-			// find the type of the neighbour coordinate
-			CoordTypesMap::const_iterator foundCoordType = coordTypes.find(*nit);
-
-			assert(foundCoordType != coordTypes.end());
-
-			if (doorCoord && foundCoordType->second != DOOR) {
-				doorCoords.insert(it->first);
-			}
+	// the contours are traced over the merged border pixels of all bands
+	std::set<Coord2D> insideCoords;
+	std::set<Coord2D> doorCoords;
 
-			if (foundCoordType->second != INSIDE && foundCoordType->second != DOOR) {
-				insideCoords.insert(it->first);
-				break;
-			}
-		}
+	for (unsigned int i = 0; i < bands; i++) {
+		insideCoords.insert(bandInsideCoords[i].begin(), bandInsideCoords[i].end());
+		doorCoords.insert(bandDoorCoords[i].begin(), bandDoorCoords[i].end());
 	}
 
+	TRACE_SPAN("trace contours");
+
 	borderPolygons = expandPolygon(insideCoords);
 	doorPolygons = expandPolygon(doorCoords);
 }
@@ -8,14 +8,40 @@
 #include <string>
 #include <vector>
 
+#include <stdint.h>
+
 class RoomImage
 	: public Image
 {
 public:
+	// black is a wall, gray (200) a door, white outside and every other colour inside
+	enum PixelClass
+	{
+		PixelOutside,
+		PixelWall,
+		PixelDoor,
+		PixelInside
+	};
+
 	RoomImage(std::string const &filename);
+
+	// converts the colours into one class per pixel, the colours can be released afterwards
+	void classify();
+	// takes width() * height() classes computed earlier, e.g. from the room cache
+	void setClassMap(unsigned char const *classes);
+	bool isClassified() const;
+	PixelClass pixelClass(unsigned int x, unsigned int y) const;
+	// row major, one PixelClass per byte
+	std::vector<unsigned char> const &classMap() const;
+	// one bit per pixel (row major), set for inside and door pixels
+	std::vector<uint64_t> freeSpace() const;
+
 	std::vector<Polygon2D> expandPolygon(std::set<Coord2D> &coords) const;
 	void getBorderPolygons(unsigned char distance, std::vector<Polygon2D> &borderPolygons,
 	                       std::vector<Polygon2D> &doorPolygons) const;
+
+private:
+	std::vector<unsigned char> classes_;
 };
 
 #endif // ROB_ROOMIMAGE_H_INCLUDED
@@ -0,0 +1,17 @@
+#include "room.h"
+#include "roomloader.h"
+
+RoomLoader::RoomLoader(Room *room, QObject *parent)
+	: QThread(parent),
+	  room_(room)
+{
+}
+
+void RoomLoader::run()
+{
+	room_->extractContours();
+	emit stageFinished(Room::StageContours);
+
+	room_->triangulate();
+	emit stageFinished(Room::StageTriangulated);
+}
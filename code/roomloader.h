@@ -0,0 +1,28 @@
+#ifndef ROB_ROOMLOADER_H_INCLUDED
+#define ROB_ROOMLOADER_H_INCLUDED
+
+#include <QtCore/QThread>
+
+class Room;
+
+// runs the preprocessing stages of a freshly decoded room in the background
+class RoomLoader
+	: public QThread
+{
+	Q_OBJECT
+
+public:
+	explicit RoomLoader(Room *room, QObject *parent = 0);
+
+Q_SIGNALS:
+	// emitted from the loader thread with the Room::Stage just finished
+	void stageFinished(int stage);
+
+protected:
+	void run();
+
+private:
+	Room *room_;
+};
+
+#endif // ROB_ROOMLOADER_H_INCLUDED
@@ -0,0 +1,195 @@
+#include "stats.h"
+
+#include <algorithm>
+#include <sstream>
+
+namespace
+{
+
+// percentiles of more samples than that don't tell anything new about the current behaviour
+std::size_t const recentSamples = 1024;
+
+std::string quoted(std::string const &value, char escape);
+uint64_t percentile(std::vector<uint64_t> samples, unsigned int percent);
+
+// double quotes for JSON (escaped by a backslash) and CSV (escaped by another double quote),
+// the names don't contain anything else to escape
+std::string quoted(std::string const &value, char escape)
+{
+	std::string result("\"");
+
+	for (std::string::const_iterator it = value.begin(); it != value.end(); ++it) {
+		if (*it == '"' || *it == escape) {
+			result += escape;
+		}
+
+		result += *it;
+	}
+
+	return result + "\"";
+}
+
+uint64_t percentile(std::vector<uint64_t> samples, unsigned int percent)
+{
+	if (samples.empty()) {
+		return 0;
+	}
+
+	std::vector<uint64_t>::iterator nth = samples.begin() + (samples.size() - 1) * percent / 100;
+	std::nth_element(samples.begin(), nth, samples.end());
+
+	return *nth;
+}
+
+} // end of private namespace
+
+Stats::Histogram::Histogram()
+	: samples(0),
+	  last(0),
+	  min(0),
+	  sum(0),
+	  next(0)
+{
+}
+
+Stats::Stats()
+{
+}
+
+void Stats::record(std::string const &name, uint64_t nsecs)
+{
+	Histogram &histogram = timers_[name];
+
+	if (histogram.samples == 0 || nsecs < histogram.min) {
+		histogram.min = nsecs;
+	}
+
+	histogram.samples++;
+	histogram.last = nsecs;
+	histogram.sum += nsecs;
+
+	if (histogram.recent.size() < recentSamples) {
+		histogram.recent.push_back(nsecs);
+	} else {
+		histogram.recent[histogram.next] = nsecs;
+		histogram.next = (histogram.next + 1) % recentSamples;
+	}
+}
+
+void Stats::count(std::string const &name, uint64_t amount)
+{
+	counters_[name] += amount;
+}
+
+void Stats::setCounter(std::string const &name, uint64_t value)
+{
+	counters_[name] = value;
+}
+
+std::vector<Stats::TimerSummary> Stats::timers() const
+{
+	std::vector<TimerSummary> result;
+
+	for (std::map<std::string, Histogram>::const_iterator it = timers_.begin(); it != timers_.end(); ++it) {
+		Histogram const &histogram = it->second;
+		TimerSummary summary;
+
+		summary.name = it->first;
+		summary.samples = histogram.samples;
+		summary.last = histogram.last;
+		summary.min = histogram.min;
+		summary.avg = histogram.sum / histogram.samples;
+		summary.p50 = percentile(histogram.recent, 50);
+		summary.p99 = percentile(histogram.recent, 99);
+
+		result.push_back(summary);
+	}
+
+	return result;
+}
+
+std::vector<Stats::CounterSummary> Stats::counters() const
+{
+	std::vector<CounterSummary> result;
+
+	for (std::map<std::string, uint64_t>::const_iterator it = counters_.begin(); it != counters_.end(); ++it) {
+		CounterSummary summary;
+
+		summary.name = it->first;
+		summary.value = it->second;
+
+		result.push_back(summary);
+	}
+
+	return result;
+}
+
+std::string Stats::toJson() const
+{
+	std::ostringstream json;
+	std::vector<TimerSummary> timerSummaries = timers();
+	std::vector<CounterSummary> counterSummaries = counters();
+
+	json << "{\n  \"timers\": [";
+
+	for (std::size_t i = 0; i < timerSummaries.size(); i++) {
+		TimerSummary const &summary = timerSummaries[i];
+
+		json << (i == 0 ? "\n" : ",\n")
+		     << "    {\"name\": " << quoted(summary.name, '\\')
+		     << ", \"unit\": \"ns\""
+		     << ", \"samples\": " << summary.samples
+		     << ", \"last\": " << summary.last
+		     << ", \"min\": " << summary.min
+		     << ", \"avg\": " << summary.avg
+		     << ", \"p50\": " << summary.p50
+		     << ", \"p99\": " << summary.p99 << "}";
+	}
+
+	json << "\n  ],\n  \"counters\": [";
+
+	for (std::size_t i = 0; i < counterSummaries.size(); i++) {
+		json << (i == 0 ? "\n" : ",\n")
+		     << "    {\"name\": " << quoted(counterSummaries[i].name, '\\')
+		     << ", \"value\": " << counterSummaries[i].value << "}";
+	}
+
+	json << "\n  ]\n}\n";
+
+	return json.str();
+}
+
+std::string Stats::toCsv() const
+{
+	std::ostringstream csv;
+	std::vector<TimerSummary> timerSummaries = timers();
+	std::vector<CounterSummary> counterSummaries = counters();
+
+	csv << "kind,name,samples,last_ns,min_ns,avg_ns,p50_ns,p99_ns,value\n";
+
+	for (std::size_t i = 0; i < timerSummaries.size(); i++) {
+		TimerSummary const &summary = timerSummaries[i];
+
+		csv << "timer," << quoted(summary.name, '"') << ","
+		    << summary.samples << "," << summary.last << "," << summary.min << ","
+		    << summary.avg << "," << summary.p50 << "," << summary.p99 << ",\n";
+	}
+
+	for (std::size_t i = 0; i < counterSummaries.size(); i++) {
+		csv << "counter," << quoted(counterSummaries[i].name, '"') << ",,,,,,," << counterSummaries[i].value << "\n";
+	}
+
+	return csv.str();
+}
+
+ScopedTimer::ScopedTimer(Stats *stats, std::string const &name)
+	: stats_(stats),
+	  name_(name)
+{
+	timer_.start();
+}
+
+ScopedTimer::~ScopedTimer()
+{
+	stats_->record(name_, timer_.nsecsElapsed());
+}
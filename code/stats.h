@@ -1,18 +1,84 @@
 #ifndef ROB_STATS_H_INCLUDED
 #define ROB_STATS_H_INCLUDED
 
-#include "room.h"
+#include <QtCore/QElapsedTimer>
+
+#include <map>
+#include <string>
+#include <vector>
 
 #include <stdint.h>
 
-struct Stats
+// named timers in nanoseconds and named counters, GUI thread only; work done on other
+// threads is measured into its own fields (see PlanningJob) and recorded afterwards
+class Stats
+{
+public:
+	struct TimerSummary
+	{
+		std::string name;
+		uint64_t samples;
+		uint64_t last;
+		uint64_t min;
+		uint64_t avg;
+		// over the most recent samples only
+		uint64_t p50;
+		uint64_t p99;
+	};
+
+	struct CounterSummary
+	{
+		std::string name;
+		uint64_t value;
+	};
+
+	Stats();
+
+	void record(std::string const &name, uint64_t nsecs);
+	void count(std::string const &name, uint64_t amount = 1);
+	// for counters which are totals kept elsewhere
+	void setCounter(std::string const &name, uint64_t value);
+
+	// both ordered by name
+	std::vector<TimerSummary> timers() const;
+	std::vector<CounterSummary> counters() const;
+
+	std::string toJson() const;
+	// one line per timer and counter, unused columns stay empty
+	std::string toCsv() const;
+
+private:
+	struct Histogram
+	{
+		Histogram();
+
+		uint64_t samples;
+		uint64_t last;
+		uint64_t min;
+		uint64_t sum;
+		// ring buffer of the most recent samples
+		std::vector<uint64_t> recent;
+		std::size_t next;
+	};
+
+	std::map<std::string, Histogram> timers_;
+	std::map<std::string, uint64_t> counters_;
+};
+
+// records the time from construction to destruction
+class ScopedTimer
 {
-	uint64_t lastPathCalculation;
-	uint64_t lastPathCollisionCalculation;
-	uint64_t lastCatmullRomCalculation;
-	uint64_t lastSetNodes;
-	uint64_t lastRoomTriangulationCalculation;
-	Room::Algorithm lastUsedAlgorithm;
+public:
+	ScopedTimer(Stats *stats, std::string const &name);
+	~ScopedTimer();
+
+private:
+	ScopedTimer(ScopedTimer const &other);
+	ScopedTimer &operator=(ScopedTimer const &other);
+
+	Stats *stats_;
+	std::string name_;
+	QElapsedTimer timer_;
 };
 
 #endif // ROB_STATS_H_INCLUDED
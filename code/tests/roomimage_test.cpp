@@ -0,0 +1,160 @@
+#include "floorplan.h"
+#include "roomimage.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <set>
+#include <vector>
+
+// door lines traced by RoomImage have to come out as [start, end], whichever way they run
+namespace
+{
+	int failures = 0;
+
+	void check(bool condition, char const *what);
+	bool isLine(Polygon2D const &polygon, Coord2D const &start, Coord2D const &end);
+	void testExpandPolygon(RoomImage const &image);
+	void testFloorPlanDoors(RoomImage const &image);
+	void testPlanWithoutDoors();
+
+	void check(bool condition, char const *what)
+	{
+		if (!condition) {
+			std::fprintf(stderr, "FAIL: %s\n", what);
+			failures++;
+		}
+	}
+
+	bool isLine(Polygon2D const &polygon, Coord2D const &start, Coord2D const &end)
+	{
+		return polygon.size() == 2 && polygon[0] == start && polygon[1] == end;
+	}
+
+	// door pixels only form lines, each one has to be traced afresh whatever ran before it
+	void testExpandPolygon(RoomImage const &image)
+	{
+		std::set<Coord2D> coords;
+
+		for (unsigned int y = 10; y < 20; y++) {
+			coords.insert(Coord2D(20, y));
+			coords.insert(Coord2D(25, y));
+		}
+
+		for (unsigned int x = 30; x < 40; x++) {
+			coords.insert(Coord2D(x, 5));
+		}
+
+		for (unsigned int y = 10; y < 20; y++) {
+			coords.insert(Coord2D(45, y));
+		}
+
+		coords.insert(Coord2D(50, 50));
+
+		std::vector<Polygon2D> polygons = image.expandPolygon(coords);
+
+		check(coords.empty(), "expandPolygon() consumes all coords");
+		check(polygons.size() == 5, "expandPolygon() finds every line and the single pixel");
+
+		if (polygons.size() == 5) {
+			check(isLine(polygons[0], Coord2D(20, 10), Coord2D(20, 19)), "first vertical line");
+			check(isLine(polygons[1], Coord2D(25, 10), Coord2D(25, 19)), "vertical line after a vertical one");
+			check(isLine(polygons[2], Coord2D(30, 5), Coord2D(39, 5)), "horizontal line after a vertical one");
+			check(isLine(polygons[3], Coord2D(45, 10), Coord2D(45, 19)), "vertical line after a horizontal one");
+			check(isLine(polygons[4], Coord2D(50, 50), Coord2D(50, 50)), "single pixel");
+		}
+	}
+
+	// every door of a generated plan, which has vertical as well as horizontal ones
+	void testFloorPlanDoors(RoomImage const &image)
+	{
+		std::vector<Polygon2D> borderPolygons;
+		std::vector<Polygon2D> doorPolygons;
+		image.getBorderPolygons(5, borderPolygons, doorPolygons);
+
+		std::size_t verticalDoors = 0;
+		std::size_t badDoors = 0;
+
+		for (std::size_t i = 0; i < doorPolygons.size(); i++) {
+			Polygon2D const &door = doorPolygons[i];
+
+			if (door.size() != 2) {
+				badDoors++;
+				continue;
+			}
+
+			Coord2D const &start = door[0];
+			Coord2D const &end = door[1];
+
+			// shortened by the distance to the walls, but never down to a single pixel
+			if (start.x == end.x && start.y < end.y) {
+				verticalDoors++;
+			} else if (start.y != end.y || start.x >= end.x) {
+				badDoors++;
+			}
+		}
+
+		check(!doorPolygons.empty(), "the floor plan has doors");
+		check(verticalDoors > 0, "the floor plan has vertical doors");
+		check(badDoors == 0, "every door is traced from its start to its end pixel");
+	}
+
+	// a single room has no walls to put doors into, the door tracing gets no pixels at all
+	void testPlanWithoutDoors()
+	{
+		FloorPlanOptions options;
+		options.width = 256;
+		options.height = 256;
+		options.rooms = 1;
+		options.obstacles = 0;
+
+		FloorPlan plan(options);
+		plan.writePNG("roomimage_test_single.png");
+
+		RoomImage image("roomimage_test_single.png");
+		image.classify();
+
+		std::set<Coord2D> coords;
+
+		check(image.expandPolygon(coords).empty(), "expandPolygon() of no coords gives no polygons");
+
+		std::vector<Polygon2D> borderPolygons;
+		std::vector<Polygon2D> doorPolygons;
+		image.getBorderPolygons(5, borderPolygons, doorPolygons);
+
+		check(plan.doors() == 0, "a single room has no doors");
+		check(!borderPolygons.empty(), "the single room has a border");
+		check(doorPolygons.empty(), "no door polygons without doors");
+
+		std::remove("roomimage_test_single.png");
+	}
+}
+
+int main()
+{
+	// one of the plans the door tracing went wrong for
+	FloorPlanOptions options;
+	options.width = 1024;
+	options.height = 1024;
+	options.rooms = 20;
+	options.obstacles = 30;
+	options.seed = 1;
+
+	FloorPlan plan(options);
+	plan.writePNG("roomimage_test.png");
+
+	RoomImage image("roomimage_test.png");
+	image.classify();
+
+	testExpandPolygon(image);
+	testFloorPlanDoors(image);
+	testPlanWithoutDoors();
+
+	std::remove("roomimage_test.png");
+
+	if (failures > 0) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,40 @@
+TEMPLATE = app
+TARGET = roomimage_test
+QT -= gui
+CONFIG += console testcase
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+LIBS += -lboost_thread -lz
+
+libpng {
+	DEFINES += ROB_USE_LIBPNG
+	LIBS += -lpng
+} else {
+	LIBS += -lIL -lILU
+	HEADERS += il.h
+	SOURCES += il.cpp
+}
+
+# Input
+HEADERS += classify.h \
+           coord.h \
+           cpu.h \
+           floorplan.h \
+           image.h \
+           parallel.h \
+           pngwriter.h \
+           polygon.h \
+           roomimage.h \
+           trace.h
+SOURCES += classify.cpp \
+           coord.cpp \
+           cpu.cpp \
+           floorplan.cpp \
+           image.cpp \
+           parallel.cpp \
+           pngwriter.cpp \
+           polygon.cpp \
+           roomimage.cpp \
+           roomimage_test.cpp \
+           trace.cpp
@@ -0,0 +1,249 @@
+#include "algo.h"
+#include "contraction.h"
+#include "regiongraph.h"
+#include "roadmap.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <utility>
+#include <vector>
+
+// the door graph, the cluster graph and the contraction hierarchy have to find paths
+// as short as dijkstra() on the same roadmap, whether there is a path or not
+namespace
+{
+	int failures = 0;
+
+	unsigned int const roadmapSize = 400;
+	unsigned int const gridStep = 20;
+
+	void check(bool condition, char const *what);
+	unsigned int random(unsigned int &state, unsigned int range);
+	NeighboursMap randomRoadmap(unsigned int seed);
+	std::vector<int> doorRegions(CompactRoadmap const &roadmap);
+	float pathLength(std::vector<Coord2D> const &path);
+	bool pathValid(NeighboursMap const &neighbours, std::vector<Coord2D> const &path,
+	               Coord2D const &startpoint, Coord2D const &endpoint);
+	void checkPath(NeighboursMap const &neighbours, std::vector<Coord2D> const &path,
+	               Coord2D const &startpoint, Coord2D const &endpoint, char const *what);
+	std::vector< std::pair<Coord2D, Coord2D> > queries(CompactRoadmap const &roadmap, Coord2D const &isolated, unsigned int seed);
+	void testRoadmap(unsigned int seed);
+
+	void check(bool condition, char const *what)
+	{
+		if (!condition) {
+			std::fprintf(stderr, "FAIL: %s\n", what);
+			failures++;
+		}
+	}
+
+	// the same numbers on every platform, unlike rand()
+	unsigned int random(unsigned int &state, unsigned int range)
+	{
+		state = state * 1103515245u + 12345u;
+
+		return (state >> 16) % range;
+	}
+
+	// jittered grid with diagonals, some edges left out so that there are detours
+	// and parts which can't be reached from the rest
+	NeighboursMap randomRoadmap(unsigned int seed)
+	{
+		unsigned int state = seed;
+		unsigned int const cells = roadmapSize / gridStep;
+
+		std::vector<Coord2D> grid(cells * cells);
+
+		for (unsigned int y = 0; y < cells; y++) {
+			for (unsigned int x = 0; x < cells; x++) {
+				grid[y * cells + x] = Coord2D(x * gridStep + random(state, gridStep / 2),
+				                              y * gridStep + random(state, gridStep / 2));
+			}
+		}
+
+		NeighboursMap neighbours;
+
+		for (unsigned int y = 0; y < cells; y++) {
+			for (unsigned int x = 0; x < cells; x++) {
+				Coord2D const &node = grid[y * cells + x];
+
+				neighbours[node];
+
+				int const directions[3][2] = {{1, 0}, {0, 1}, {1, 1}};
+
+				for (int i = 0; i < 3; i++) {
+					unsigned int nx = x + directions[i][0];
+					unsigned int ny = y + directions[i][1];
+
+					if (nx >= cells || ny >= cells || random(state, 4) == 0) {
+						continue;
+					}
+
+					Coord2D const &neighbour = grid[ny * cells + nx];
+
+					neighbours[node].insert(neighbour);
+					neighbours[neighbour].insert(node);
+				}
+			}
+		}
+
+		return neighbours;
+	}
+
+	// two rooms split at half the width, the nodes next to the split are doors in regions of their own
+	std::vector<int> doorRegions(CompactRoadmap const &roadmap)
+	{
+		std::vector<int> regions(roadmap.nodes.size());
+
+		for (std::size_t i = 0; i < roadmap.nodes.size(); i++) {
+			unsigned int x = roadmap.nodes[i].x;
+
+			if (x >= roadmapSize / 2 - gridStep / 2 && x < roadmapSize / 2 + gridStep / 2) {
+				regions[i] = -1;
+			} else {
+				regions[i] = x < roadmapSize / 2 ? 0 : 1;
+			}
+		}
+
+		return regions;
+	}
+
+	float pathLength(std::vector<Coord2D> const &path)
+	{
+		float length = 0;
+
+		for (std::size_t i = 0; i + 1 < path.size(); i++) {
+			float dx = static_cast<float>(path[i + 1].x) - path[i].x;
+			float dy = static_cast<float>(path[i + 1].y) - path[i].y;
+
+			length += std::sqrt(dx * dx + dy * dy);
+		}
+
+		return length;
+	}
+
+	// from the endpoint back to the startpoint along roadmap edges, only the endpoint if there is none
+	bool pathValid(NeighboursMap const &neighbours, std::vector<Coord2D> const &path,
+	               Coord2D const &startpoint, Coord2D const &endpoint)
+	{
+		if (path.empty() || path.front() != endpoint) {
+			return false;
+		}
+
+		if (path.size() > 1 && path.back() != startpoint) {
+			return false;
+		}
+
+		for (std::size_t i = 0; i + 1 < path.size(); i++) {
+			NeighboursMap::const_iterator it = neighbours.find(path[i]);
+
+			if (it == neighbours.end() || it->second.find(path[i + 1]) == it->second.end()) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	void checkPath(NeighboursMap const &neighbours, std::vector<Coord2D> const &path,
+	               Coord2D const &startpoint, Coord2D const &endpoint, char const *what)
+	{
+		std::vector<Coord2D> shortest = dijkstra(neighbours, startpoint, endpoint);
+		float length = pathLength(path);
+		float shortestLength = pathLength(shortest);
+
+		check(pathValid(neighbours, path, startpoint, endpoint), what);
+		check((path.size() > 1) == (shortest.size() > 1), what);
+		check(std::fabs(length - shortestLength) <= 1e-3f * std::max(1.0f, shortestLength), what);
+	}
+
+	// random pairs, the same node twice, nodes of the same cluster and an unreachable endpoint
+	std::vector< std::pair<Coord2D, Coord2D> > queries(CompactRoadmap const &roadmap, Coord2D const &isolated, unsigned int seed)
+	{
+		unsigned int state = seed;
+		std::vector< std::pair<Coord2D, Coord2D> > result;
+		std::size_t const nodes = roadmap.nodes.size();
+
+		for (int i = 0; i < 30; i++) {
+			result.push_back(std::make_pair(roadmap.nodes[random(state, nodes)], roadmap.nodes[random(state, nodes)]));
+		}
+
+		result.push_back(std::make_pair(roadmap.nodes[0], roadmap.nodes[0]));
+		result.push_back(std::make_pair(roadmap.nodes[0], roadmap.nodes[1]));
+		result.push_back(std::make_pair(roadmap.nodes[nodes / 2], roadmap.nodes[nodes / 2 + 1]));
+		result.push_back(std::make_pair(roadmap.nodes[0], isolated));
+		result.push_back(std::make_pair(isolated, roadmap.nodes[nodes - 1]));
+		result.push_back(std::make_pair(isolated, isolated));
+
+		return result;
+	}
+
+	void testRoadmap(unsigned int seed)
+	{
+		NeighboursMap neighbours = randomRoadmap(seed);
+
+		// can't be reached from anywhere, outside of the grid cells
+		Coord2D isolated(roadmapSize + gridStep, roadmapSize + gridStep);
+		neighbours[isolated];
+
+		CompactRoadmap roadmap;
+		compactRoadmap(neighbours, roadmap);
+
+		std::vector<int> clusters = clusterRegions(roadmap, 3 * gridStep);
+
+		RegionGraph doorGraph(roadmap, doorRegions(roadmap));
+		RegionGraph clusterGraph(roadmap, clusters);
+		RegionGraph lazyClusterGraph(roadmap, clusters, true);
+		ContractionHierarchy contraction(roadmap);
+
+		std::vector< std::pair<Coord2D, Coord2D> > pairs = queries(roadmap, isolated, seed);
+
+		for (std::size_t i = 0; i < pairs.size(); i++) {
+			Coord2D const &startpoint = pairs[i].first;
+			Coord2D const &endpoint = pairs[i].second;
+
+			checkPath(neighbours, doorGraph.findPath(startpoint, endpoint), startpoint, endpoint, "door graph path");
+			checkPath(neighbours, clusterGraph.findPath(startpoint, endpoint), startpoint, endpoint, "cluster graph path");
+			checkPath(neighbours, lazyClusterGraph.findPath(startpoint, endpoint), startpoint, endpoint, "lazy cluster graph path");
+			checkPath(neighbours, contraction.findPath(startpoint, endpoint), startpoint, endpoint, "contraction hierarchy path");
+		}
+
+		// like placing a waypoint, the regions it didn't touch are taken over
+		Coord2D added(roadmap.nodes[roadmap.nodes.size() / 2].x + 1, roadmap.nodes[roadmap.nodes.size() / 2].y + 1);
+		neighbours[added].insert(roadmap.nodes[roadmap.nodes.size() / 2]);
+		neighbours[roadmap.nodes[roadmap.nodes.size() / 2]].insert(added);
+
+		CompactRoadmap edited;
+		compactRoadmap(neighbours, edited);
+
+		RegionGraph reusedGraph(edited, clusterRegions(edited, 3 * gridStep), true, &lazyClusterGraph);
+
+		check(reusedGraph.reusedRegions() > 0, "the edited graph takes over regions");
+
+		pairs = queries(edited, isolated, seed + 1);
+		pairs.push_back(std::make_pair(added, edited.nodes[0]));
+
+		for (std::size_t i = 0; i < pairs.size(); i++) {
+			Coord2D const &startpoint = pairs[i].first;
+			Coord2D const &endpoint = pairs[i].second;
+
+			checkPath(neighbours, reusedGraph.findPath(startpoint, endpoint), startpoint, endpoint, "reused cluster graph path");
+		}
+	}
+}
+
+int main()
+{
+	for (unsigned int seed = 1; seed <= 10; seed++) {
+		testRoadmap(seed);
+	}
+
+	if (failures > 0) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,27 @@
+TEMPLATE = app
+TARGET = search_test
+QT -= gui
+CONFIG += console testcase
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+LIBS += -lboost_thread
+
+# Input
+HEADERS += algo.h \
+           binarystream.h \
+           contraction.h \
+           coord.h \
+           edge.h \
+           neighbours.h \
+           regiongraph.h \
+           roadmap.h \
+           trace.h
+SOURCES += algo.cpp \
+           binarystream.cpp \
+           contraction.cpp \
+           coord.cpp \
+           regiongraph.cpp \
+           roadmap.cpp \
+           search_test.cpp \
+           trace.cpp
@@ -0,0 +1,10 @@
+# all tests, qmake && make check builds and runs them, e.g. qmake CONFIG+=libpng tests.pro;
+# every test exits with a failure after printing the checks which didn't hold
+TEMPLATE = subdirs
+SUBDIRS += roomimage \
+           search \
+           triangulation
+
+roomimage.file = roomimage_test.pro
+search.file = search_test.pro
+triangulation.file = triangulation_test.pro
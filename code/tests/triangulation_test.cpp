@@ -0,0 +1,226 @@
+#include "triangulation.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include <stdint.h>
+
+// the room cache restores the room triangulation from serialize(), the copy has to be
+// the same triangulation down to the constraints and the domain marks
+namespace
+{
+	int failures = 0;
+
+	void check(bool condition, char const *what);
+	std::vector< std::vector<Coord2D> > roomPolygons();
+	std::vector<Coord2D> triangleCorners(ConstrainedDelaunayTriangulation const &triangulation);
+	std::vector<Coord2D> edgeEnds(ConstrainedDelaunayTriangulation const &triangulation);
+	void testRoundTrip();
+	void testMalformedData();
+	void testWallCorner();
+
+	void check(bool condition, char const *what)
+	{
+		if (!condition) {
+			std::fprintf(stderr, "FAIL: %s\n", what);
+			failures++;
+		}
+	}
+
+	// a room with an obstacle, closed polygons like the traced borders
+	std::vector< std::vector<Coord2D> > roomPolygons()
+	{
+		std::vector< std::vector<Coord2D> > polygons(2);
+
+		polygons[0].push_back(Coord2D(10, 10));
+		polygons[0].push_back(Coord2D(200, 10));
+		polygons[0].push_back(Coord2D(200, 150));
+		polygons[0].push_back(Coord2D(120, 150));
+		polygons[0].push_back(Coord2D(120, 200));
+		polygons[0].push_back(Coord2D(10, 200));
+		polygons[0].push_back(Coord2D(10, 10));
+
+		polygons[1].push_back(Coord2D(60, 60));
+		polygons[1].push_back(Coord2D(90, 60));
+		polygons[1].push_back(Coord2D(90, 100));
+		polygons[1].push_back(Coord2D(60, 100));
+		polygons[1].push_back(Coord2D(60, 60));
+
+		return polygons;
+	}
+
+	// sorted per triangle and over all triangles, the faces may come out in any order
+	std::vector<Coord2D> triangleCorners(ConstrainedDelaunayTriangulation const &triangulation)
+	{
+		std::vector<Triangle> triangles = triangulation.getTriangulation();
+		std::vector< std::vector<Coord2D> > sorted;
+
+		for (std::size_t i = 0; i < triangles.size(); i++) {
+			std::vector<Coord2D> corners(triangles[i].coords, triangles[i].coords + 3);
+
+			std::sort(corners.begin(), corners.end());
+			sorted.push_back(corners);
+		}
+
+		std::sort(sorted.begin(), sorted.end());
+
+		std::vector<Coord2D> corners;
+
+		for (std::size_t i = 0; i < sorted.size(); i++) {
+			corners.insert(corners.end(), sorted[i].begin(), sorted[i].end());
+		}
+
+		return corners;
+	}
+
+	std::vector<Coord2D> edgeEnds(ConstrainedDelaunayTriangulation const &triangulation)
+	{
+		std::vector<Edge> edges = triangulation.getConstrainedEdges();
+		std::vector< std::pair<Coord2D, Coord2D> > sorted;
+
+		for (std::size_t i = 0; i < edges.size(); i++) {
+			sorted.push_back(std::make_pair(std::min(edges[i].start, edges[i].end),
+			                                std::max(edges[i].start, edges[i].end)));
+		}
+
+		std::sort(sorted.begin(), sorted.end());
+
+		std::vector<Coord2D> ends;
+
+		for (std::size_t i = 0; i < sorted.size(); i++) {
+			ends.push_back(sorted[i].first);
+			ends.push_back(sorted[i].second);
+		}
+
+		return ends;
+	}
+
+	void testRoundTrip()
+	{
+		ConstrainedDelaunayTriangulation original;
+		original.insertConstraints(roomPolygons());
+
+		// free vertices besides the constrained ones, inside, in the obstacle and outside
+		original.insert(Coord2D(30, 170));
+		original.insert(Coord2D(150, 40));
+		original.insert(Coord2D(75, 80));
+		original.insert(Coord2D(180, 190));
+
+		std::vector<char> buffer;
+		original.serialize(buffer);
+
+		check(!buffer.empty(), "a 2D triangulation is serialised");
+
+		ConstrainedDelaunayTriangulation copy;
+
+		check(copy.deserialize(&buffer[0], buffer.size()), "the serialised triangulation is read back");
+		check(copy.list() == original.list(), "same vertices");
+		check(copy.numberOfFaces() == original.numberOfFaces(), "same number of faces");
+		check(triangleCorners(copy) == triangleCorners(original), "same faces in the domain");
+		check(edgeEnds(copy) == edgeEnds(original), "same constrained edges");
+
+		std::vector<Coord2D> probes;
+
+		for (unsigned int x = 0; x <= 220; x += 5) {
+			for (unsigned int y = 0; y <= 220; y += 5) {
+				probes.push_back(Coord2D(x, y));
+			}
+		}
+
+		std::vector<bool> originalInside;
+		std::vector<bool> copyInside;
+		original.inDomain(probes, originalInside);
+		copy.inDomain(probes, copyInside);
+
+		check(copyInside == originalInside, "same domain marks");
+		check(copy.inDomain(30, 30) && !copy.inDomain(75, 80) && !copy.inDomain(180, 190),
+		      "the room is inside, the obstacle and the cut-out corner outside");
+		check(copy.segmentInDomain(Coord2D(20, 20), Coord2D(20, 190)) &&
+		      !copy.segmentInDomain(Coord2D(20, 80), Coord2D(110, 80)),
+		      "segments are only blocked by the constraints");
+
+		std::vector<char> again;
+		copy.serialize(again);
+
+		check(again == buffer, "serialising the copy gives the same bytes");
+	}
+
+	void testMalformedData()
+	{
+		ConstrainedDelaunayTriangulation original;
+		original.insertConstraints(roomPolygons());
+
+		std::vector<char> buffer;
+		original.serialize(buffer);
+
+		// a valid triangulation first, rejected data mustn't leave it behind
+		ConstrainedDelaunayTriangulation copy;
+		copy.deserialize(&buffer[0], buffer.size());
+
+		check(!copy.deserialize(&buffer[0], buffer.size() - 1), "truncated data is rejected");
+		check(copy.list().empty(), "a rejected triangulation is empty");
+
+		// the first face's first vertex index, right after the counts and the points
+		std::vector<char> broken(buffer);
+		uint32_t vertexCount;
+		uint32_t const invalidIndex = 0xffffffffu;
+
+		std::memcpy(&vertexCount, &broken[0], sizeof vertexCount);
+		std::memcpy(&broken[2 * sizeof(uint32_t) + (vertexCount - 1) * 2 * sizeof(double)], &invalidIndex,
+		            sizeof invalidIndex);
+
+		check(!copy.deserialize(&broken[0], broken.size()), "out of range vertex indices are rejected");
+
+		ConstrainedDelaunayTriangulation empty;
+		std::vector<char> emptyBuffer;
+		empty.serialize(emptyBuffer);
+
+		check(emptyBuffer.empty(), "an empty triangulation isn't serialised");
+	}
+
+	// a thin wall bent like a roof inside a room, segments through its apex vertex
+	void testWallCorner()
+	{
+		std::vector< std::vector<Coord2D> > polygons(2);
+
+		polygons[0].push_back(Coord2D(10, 10));
+		polygons[0].push_back(Coord2D(200, 10));
+		polygons[0].push_back(Coord2D(200, 200));
+		polygons[0].push_back(Coord2D(10, 200));
+		polygons[0].push_back(Coord2D(10, 10));
+
+		polygons[1].push_back(Coord2D(50, 50));
+		polygons[1].push_back(Coord2D(100, 100));
+		polygons[1].push_back(Coord2D(150, 50));
+
+		ConstrainedDelaunayTriangulation triangulation;
+		triangulation.insertConstraints(polygons);
+
+		check(!triangulation.segmentInDomain(Coord2D(100, 150), Coord2D(100, 20)),
+		      "a segment between the two walls of a corner crosses them");
+		check(triangulation.segmentInDomain(Coord2D(40, 100), Coord2D(160, 100)),
+		      "a segment touching a corner from outside passes");
+		check(!triangulation.segmentInDomain(Coord2D(60, 150), Coord2D(60, 20)),
+		      "a segment through a wall crosses it");
+		check(triangulation.segmentInDomain(Coord2D(100, 190), Coord2D(100, 110)),
+		      "a segment ending before the corner passes");
+	}
+}
+
+int main()
+{
+	testRoundTrip();
+	testMalformedData();
+	testWallCorner();
+
+	if (failures > 0) {
+		std::fprintf(stderr, "%d checks failed\n", failures);
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
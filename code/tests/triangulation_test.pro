@@ -0,0 +1,23 @@
+TEMPLATE = app
+TARGET = triangulation_test
+QT -= gui
+CONFIG += console testcase
+CONFIG -= app_bundle
+INCLUDEPATH += . ..
+VPATH += ..
+LIBS += -lCGAL -lgmp -lboost_thread
+QMAKE_CXXFLAGS += -frounding-math
+
+# Input
+HEADERS += coord.h \
+           edge.h \
+           neighbours.h \
+           trace.h \
+           triangle.h \
+           triangulation.h
+SOURCES += coord.cpp \
+           edge.cpp \
+           trace.cpp \
+           triangle.cpp \
+           triangulation.cpp \
+           triangulation_test.cpp
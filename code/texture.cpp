@@ -1,74 +1,184 @@
+#define GL_GLEXT_PROTOTYPES
+
 #include "gl.h"
 #include "image.h"
 #include "texture.h"
 
+#ifdef WIN32
+#include <GL/glew.h>
+#endif
 #include <GL/gl.h>
 
+#include <algorithm>
 #include <stdexcept>
+#include <vector>
 
 class Texture::TextureImpl
 {
 public:
+	struct Tile
+	{
+		GLuint handle;
+		unsigned int x;
+		unsigned int y;
+		unsigned int width;
+		unsigned int height;
+	};
+
 	TextureImpl(Image const &image);
 	~TextureImpl();
 
-	void bind();
+	bool uploadTiles(unsigned int maxTiles);
+	void uploadTile(Tile &tile);
+	void draw();
 
-	GLuint handle;
 	unsigned int width;
 	unsigned int height;
+	// one byte per pixel, released once all tiles are uploaded
+	std::vector<unsigned char> luminance;
+	std::vector<Tile> tiles;
+	std::vector<Tile>::size_type uploaded;
 };
 
 Texture::TextureImpl::TextureImpl(Image const &image)
 	: width(image.width()),
-	  height(image.height())
+	  height(image.height()),
+	  uploaded(0)
 {
-	try {
-		glGenTextures(1, &handle);
-		glBindTexture(GL_TEXTURE_2D, handle);
-
-		GLsizei glWidth = static_cast<GLsizei>(width);
-		GLsizei glHeight = static_cast<GLsizei>(height);
-		GLvoid const *data = static_cast<GLvoid const *>(image.data().data());
-		GLenum format;
-
-		switch (image.type()) {
-			case Image::IMAGE_TYPE_RGB:
-				glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
-				format = GL_RGB;
-				break;
-
-			case Image::IMAGE_TYPE_RGBA:
-				format = GL_RGBA;
-				break;
-
-			default:
-				throw std::runtime_error("Only RGB and RBGA images supported in texture.");
+	unsigned char stride;
+
+	switch (image.type()) {
+		case Image::IMAGE_TYPE_RGB:
+			stride = 3;
+			break;
+
+		case Image::IMAGE_TYPE_RGBA:
+			stride = 4;
+			break;
+
+		default:
+			throw std::runtime_error("Only RGB and RBGA images supported in texture.");
+	}
+
+	// room maps only use a few colours, the luma keeps white, black and the
+	// door gray (200) exact and still shows the remaining areas
+	unsigned char const *bytes = image.data().data();
+	std::size_t pixels = static_cast<std::size_t>(width) * height;
+
+	luminance.resize(pixels);
+
+	for (std::size_t i = 0; i < pixels; i++, bytes += stride) {
+		luminance[i] = (77 * bytes[0] + 150 * bytes[1] + 29 * bytes[2]) >> 8;
+	}
+
+	GLint maxSize;
+	glGetIntegerv(GL_MAX_TEXTURE_SIZE, &maxSize);
+	checkGLError();
+
+	unsigned int tileSize = std::min<unsigned int>(maxSize, 1024);
+
+	for (unsigned int y = 0; y < height; y += tileSize) {
+		for (unsigned int x = 0; x < width; x += tileSize) {
+			Tile tile;
+
+			tile.handle = 0;
+			tile.x = x;
+			tile.y = y;
+			tile.width = std::min(tileSize, width - x);
+			tile.height = std::min(tileSize, height - y);
+
+			tiles.push_back(tile);
 		}
+	}
+}
 
-		glTexImage2D(GL_TEXTURE_2D, 0, format, glWidth, glHeight, 0, format, GL_UNSIGNED_BYTE, data);
-		checkGLError();
+Texture::TextureImpl::~TextureImpl()
+{
+	for (std::vector<Tile>::size_type i = 0; i < uploaded; i++) {
+		glDeleteTextures(1, &tiles[i].handle);
+	}
+}
 
-		// replace the actual drawing color
-		glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+bool Texture::TextureImpl::uploadTiles(unsigned int maxTiles)
+{
+	for (unsigned int i = 0; i < maxTiles && uploaded < tiles.size(); i++) {
+		uploadTile(tiles[uploaded]);
+		uploaded++;
+	}
+
+	if (uploaded < tiles.size()) {
+		return true;
+	}
+
+	std::vector<unsigned char>().swap(luminance);
+
+	return false;
+}
+
+void Texture::TextureImpl::uploadTile(Tile &tile)
+{
+	glGenTextures(1, &tile.handle);
+
+	try {
+		glBindTexture(GL_TEXTURE_2D, tile.handle);
 
-		// filtering
+		// read the tile directly out of the whole luminance image
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, width);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, tile.x);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, tile.y);
+
+		glTexParameteri(GL_TEXTURE_2D, GL_GENERATE_MIPMAP, GL_TRUE);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_LUMINANCE8, tile.width, tile.height, 0,
+		             GL_LUMINANCE, GL_UNSIGNED_BYTE, &luminance[0]);
+
+		glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+		glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+		glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+		checkGLError();
+
+		// filtering, mipmaps avoid aliasing when the map is shown downscaled
 		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
 	} catch (...) {
-		glDeleteTextures(1, &handle);
+		glDeleteTextures(1, &tile.handle);
 		throw;
 	}
 }
 
-Texture::TextureImpl::~TextureImpl()
+void Texture::TextureImpl::draw()
 {
-	glDeleteTextures(1, &handle);
-}
+	// OpenGL origin = bottom-left
+	// DevIL origin = top-left
+	// => swap y coordinates in glTexCoord2f
+	glEnable(GL_TEXTURE_2D);
+
+	// replace the actual drawing color
+	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_REPLACE);
+
+	for (std::vector<Tile>::size_type i = 0; i < uploaded; i++) {
+		Tile const &tile = tiles[i];
+		GLint left = tile.x;
+		GLint right = tile.x + tile.width;
+		GLint top = height - tile.y;
+		GLint bottom = height - tile.y - tile.height;
+
+		glBindTexture(GL_TEXTURE_2D, tile.handle);
+		glBegin(GL_QUADS);
+		glTexCoord2i(0, 1);
+		glVertex2i(left, bottom);
+		glTexCoord2i(0, 0);
+		glVertex2i(left, top);
+		glTexCoord2i(1, 0);
+		glVertex2i(right, top);
+		glTexCoord2i(1, 1);
+		glVertex2i(right, bottom);
+		glEnd();
+	}
 
-void Texture::TextureImpl::bind()
-{
-	glBindTexture(GL_TEXTURE_2D, handle);
+	glDisable(GL_TEXTURE_2D);
 }
 
 Texture::Texture(Image const &image)
@@ -91,7 +201,12 @@ unsigned int Texture::height() const
 	return p->height;
 }
 
-void Texture::bind() const
+bool Texture::uploadTiles(unsigned int maxTiles)
+{
+	return p->uploadTiles(maxTiles);
+}
+
+void Texture::draw() const
 {
-	p->bind();
+	p->draw();
 }
@@ -3,6 +3,8 @@
 
 class Image;
 
+// the image is split into mipmapped tiles which are uploaded a few at a time,
+// so maps larger than GL_MAX_TEXTURE_SIZE work and startup doesn't block
 class Texture
 {
 public:
@@ -11,9 +13,16 @@ public:
 
 	unsigned int width() const;
 	unsigned int height() const;
-	void bind() const;
+
+	// uploads at most maxTiles pending tiles, returns true if tiles are still pending
+	bool uploadTiles(unsigned int maxTiles);
+	// draws all uploaded tiles over the rectangle (0, 0) - (width, height)
+	void draw() const;
 
 private:
+	Texture(Texture const &other);
+	Texture &operator=(Texture const &other);
+
 	class TextureImpl;
 	TextureImpl *p;
 };
@@ -0,0 +1,14 @@
+TEMPLATE = app
+TARGET = floorplan
+CONFIG += console
+CONFIG -= app_bundle qt
+INCLUDEPATH += . ..
+VPATH += ..
+LIBS += -lz
+
+# Input
+HEADERS += floorplan.h \
+           pngwriter.h
+SOURCES += floorplan.cpp \
+           floorplan_main.cpp \
+           pngwriter.cpp
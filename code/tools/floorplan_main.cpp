@@ -0,0 +1,108 @@
+#include "floorplan.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <string>
+
+// generates room images for benchmarks and stress tests, e.g.
+// floorplan --size=16384 --rooms=500 --obstacles=2000 --seed=3 large.png
+namespace
+{
+	struct Option
+	{
+		char const *name;
+		unsigned int FloorPlanOptions::*value;
+	};
+
+	Option const options[] = {
+		{ "--width=", &FloorPlanOptions::width },
+		{ "--height=", &FloorPlanOptions::height },
+		{ "--rooms=", &FloorPlanOptions::rooms },
+		{ "--obstacles=", &FloorPlanOptions::obstacles },
+		{ "--doors=", &FloorPlanOptions::doorsPerWall },
+		{ "--wall=", &FloorPlanOptions::wallThickness },
+		{ "--door-width=", &FloorPlanOptions::doorWidth }
+	};
+
+	void usage(char const *program);
+	bool parseOption(char const *argument, FloorPlanOptions &floorPlanOptions);
+
+	void usage(char const *program)
+	{
+		FloorPlanOptions defaults;
+
+		std::fprintf(stderr,
+		             "usage: %s [--size=N | --width=N --height=N] [--rooms=N] [--obstacles=N] [--doors=N]\n"
+		             "       [--wall=N] [--door-width=N] [--seed=N] output.png\n"
+		             "defaults: %ux%u pixels, %u rooms, %u obstacles, %u door per wall, walls %u and doors %u pixels wide,\n"
+		             "seed %lu; at most %u pixels in either direction\n",
+		             program, defaults.width, defaults.height, defaults.rooms, defaults.obstacles,
+		             defaults.doorsPerWall, defaults.wallThickness, defaults.doorWidth,
+		             static_cast<unsigned long>(defaults.seed), maxFloorPlanSize);
+	}
+
+	bool parseOption(char const *argument, FloorPlanOptions &floorPlanOptions)
+	{
+		if (std::strncmp(argument, "--size=", 7) == 0) {
+			floorPlanOptions.width = floorPlanOptions.height = std::strtoul(argument + 7, 0, 10);
+			return true;
+		}
+
+		if (std::strncmp(argument, "--seed=", 7) == 0) {
+			floorPlanOptions.seed = std::strtoul(argument + 7, 0, 10);
+			return true;
+		}
+
+		for (std::size_t i = 0; i < sizeof options / sizeof *options; i++) {
+			std::size_t length = std::strlen(options[i].name);
+
+			if (std::strncmp(argument, options[i].name, length) == 0) {
+				floorPlanOptions.*options[i].value = std::strtoul(argument + length, 0, 10);
+				return true;
+			}
+		}
+
+		return false;
+	}
+}
+
+int main(int argc, char **argv)
+{
+	FloorPlanOptions floorPlanOptions;
+	std::string filename;
+
+	for (int i = 1; i < argc; i++) {
+		if (std::strncmp(argv[i], "--", 2) != 0 && filename.empty()) {
+			filename = argv[i];
+		} else if (!parseOption(argv[i], floorPlanOptions)) {
+			usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (filename.empty()) {
+		usage(argv[0]);
+		return 1;
+	}
+
+	try {
+		FloorPlan floorPlan(floorPlanOptions);
+
+		floorPlan.writePNG(filename);
+
+		// one line of JSON like the benchmarks, so the plans can be told apart in their output
+		std::printf("{\"file\":\"%s\",\"width\":%u,\"height\":%u,\"seed\":%lu,\"rooms\":%lu,\"doors\":%lu,\"obstacles\":%lu}\n",
+		            filename.c_str(), floorPlan.width(), floorPlan.height(),
+		            static_cast<unsigned long>(floorPlanOptions.seed),
+		            static_cast<unsigned long>(floorPlan.rooms()),
+		            static_cast<unsigned long>(floorPlan.doors()),
+		            static_cast<unsigned long>(floorPlan.obstacles()));
+	} catch (std::exception const &e) {
+		std::fprintf(stderr, "%s\n", e.what());
+		return 1;
+	}
+
+	return 0;
+}
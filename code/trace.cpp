@@ -0,0 +1,233 @@
+#include "trace.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+#include <boost/thread/tss.hpp>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
+
+namespace
+{
+	// a power of two, so the wrapping event counter always maps to the same slots
+	unsigned int const bufferEvents = 1 << 14;
+
+	// the owner may overwrite a slot while traceJson() reads it. It stores with release after
+	// publishing the event before, so a reader which loads a newer value with acquire also
+	// sees the newer written and can drop the event
+	struct TraceSlot
+	{
+		QAtomicPointer<char const> name;
+		QAtomicInteger<qint64> begin;
+		QAtomicInteger<qint64> duration;
+	};
+
+	// copied out of a buffer, so it can be serialized without the registry lock
+	struct TraceEvent
+	{
+		int threadId;
+		char const *name;
+		int64_t begin;
+		int64_t duration;
+	};
+
+	// owned by one thread at a time, buffers of finished threads are reused by new ones
+	struct ThreadBuffer
+	{
+		ThreadBuffer(int id)
+			: id(id),
+			  firstEvent(0),
+			  inUse(true),
+			  slots(bufferEvents)
+		{
+		}
+
+		// tid of the owning thread, fresh for every thread; id, firstEvent and inUse are guarded by registryMutex
+		int id;
+		// the events of the thread which owned the buffer before are left out
+		unsigned int firstEvent;
+		bool inUse;
+		// only the owning thread writes, it publishes an event by increasing written
+		QAtomicInt written;
+		std::vector<TraceSlot> slots;
+	};
+
+	struct TraceClock
+	{
+		TraceClock()
+		{
+			timer.start();
+		}
+
+		QElapsedTimer timer;
+	};
+
+	void releaseBuffer(ThreadBuffer *buffer);
+	ThreadBuffer *threadBuffer();
+	int64_t now();
+
+	QAtomicInt enabled;
+	QMutex registryMutex;
+	std::vector<ThreadBuffer *> buffers;
+	// guarded by registryMutex
+	int lastThreadId = 0;
+	boost::thread_specific_ptr<ThreadBuffer> currentBuffer(releaseBuffer);
+
+	// called on thread exit, the events stay until the buffer is reused
+	void releaseBuffer(ThreadBuffer *buffer)
+	{
+		QMutexLocker locker(&registryMutex);
+
+		buffer->inUse = false;
+	}
+
+	// the lock is only taken on the first span of every thread
+	ThreadBuffer *threadBuffer()
+	{
+		ThreadBuffer *buffer = currentBuffer.get();
+
+		if (buffer) {
+			return buffer;
+		}
+
+		QMutexLocker locker(&registryMutex);
+
+		for (std::vector<ThreadBuffer *>::const_iterator it = buffers.begin(); it != buffers.end(); ++it) {
+			if (!(*it)->inUse) {
+				buffer = *it;
+				buffer->id = ++lastThreadId;
+				buffer->firstEvent = buffer->written.load();
+				buffer->inUse = true;
+				break;
+			}
+		}
+
+		if (!buffer) {
+			buffer = new ThreadBuffer(++lastThreadId);
+			buffers.push_back(buffer);
+		}
+
+		currentBuffer.reset(buffer);
+
+		return buffer;
+	}
+
+	// nanoseconds since the first use
+	int64_t now()
+	{
+		static TraceClock clock;
+
+		return clock.timer.nsecsElapsed();
+	}
+}
+
+void setTracingEnabled(bool enable)
+{
+	// starts the clock before the first span
+	now();
+
+	enabled.storeRelease(enable);
+}
+
+bool tracingEnabled()
+{
+	return enabled.loadAcquire();
+}
+
+std::string traceJson()
+{
+	std::vector<TraceEvent> events;
+
+	{
+		QMutexLocker locker(&registryMutex);
+
+		for (std::vector<ThreadBuffer *>::const_iterator it = buffers.begin(); it != buffers.end(); ++it) {
+			ThreadBuffer const &buffer = **it;
+			unsigned int written = buffer.written.loadAcquire();
+			// the slot of the next event may be overwritten already
+			unsigned int count = std::min(written - buffer.firstEvent, bufferEvents - 1);
+			std::size_t copied = events.size();
+
+			for (unsigned int i = written - count; i != written; i++) {
+				TraceSlot const &slot = buffer.slots[i & (bufferEvents - 1)];
+				TraceEvent event;
+
+				event.threadId = buffer.id;
+				event.name = slot.name.loadAcquire();
+				event.begin = slot.begin.loadAcquire();
+				event.duration = slot.duration.loadAcquire();
+
+				events.push_back(event);
+			}
+
+			// slots from the oldest copied event up to the one the owner may be writing now,
+			// the oldest events were overwritten while copying if they wrapped around
+			unsigned int reached = buffer.written.loadAcquire() - (written - count) + 1;
+
+			if (reached > bufferEvents) {
+				events.erase(events.begin() + copied, events.begin() + copied + std::min(reached - bufferEvents, count));
+			}
+		}
+	}
+
+	std::ostringstream json;
+
+	// Chrome wants microseconds, the fraction keeps the nanoseconds
+	json.setf(std::ios::fixed);
+	json.precision(3);
+
+	json << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [";
+
+	for (std::vector<TraceEvent>::const_iterator it = events.begin(); it != events.end(); ++it) {
+		json << (it == events.begin() ? "\n" : ",\n")
+		     << "{\"name\": \"" << it->name << "\", \"ph\": \"X\", \"pid\": 1, \"tid\": " << it->threadId
+		     << ", \"ts\": " << it->begin / 1000.0 << ", \"dur\": " << it->duration / 1000.0 << "}";
+	}
+
+	json << "\n]}\n";
+
+	return json.str();
+}
+
+bool writeTrace(std::string const &filename)
+{
+	std::ofstream file(filename.c_str());
+
+	file << traceJson();
+
+	return file.good();
+}
+
+TraceSpan::TraceSpan(char const *name)
+	: name_(0),
+	  begin_(0)
+{
+	if (tracingEnabled()) {
+		name_ = name;
+		begin_ = now();
+	}
+}
+
+TraceSpan::~TraceSpan()
+{
+	if (!name_) {
+		return;
+	}
+
+	ThreadBuffer *buffer = threadBuffer();
+	unsigned int written = buffer->written.load();
+	TraceSlot &slot = buffer->slots[written & (bufferEvents - 1)];
+
+	slot.name.storeRelease(name_);
+	slot.begin.storeRelease(begin_);
+	slot.duration.storeRelease(now() - begin_);
+
+	buffer->written.storeRelease(written + 1);
+}
@@ -0,0 +1,37 @@
+#ifndef ROB_TRACE_H_INCLUDED
+#define ROB_TRACE_H_INCLUDED
+
+#include <string>
+
+#include <stdint.h>
+
+#define ROB_TRACE_CONCAT_(a, b) a ## b
+#define ROB_TRACE_CONCAT(a, b) ROB_TRACE_CONCAT_(a, b)
+
+// records the rest of the scope as a span called name (a string literal), if tracing is enabled
+#define TRACE_SPAN(name) TraceSpan ROB_TRACE_CONCAT(traceSpan, __LINE__)(name)
+
+// spans are kept per thread in a ring buffer of the most recent ones, so recording
+// needs neither locks nor allocations
+void setTracingEnabled(bool enabled);
+bool tracingEnabled();
+// all buffered spans of all threads in the Chrome trace event format, for chrome://tracing
+// or Perfetto; spans being recorded meanwhile may be missing
+std::string traceJson();
+bool writeTrace(std::string const &filename);
+
+class TraceSpan
+{
+public:
+	TraceSpan(char const *name);
+	~TraceSpan();
+
+private:
+	TraceSpan(TraceSpan const &other);
+	TraceSpan &operator=(TraceSpan const &other);
+
+	char const *name_;
+	int64_t begin_;
+};
+
+#endif // ROB_TRACE_H_INCLUDED
@@ -1,11 +1,16 @@
+#include "trace.h"
 #include "triangulation.h"
 
 #define CGAL_DISABLE_ROUNDING_MATH_CHECK 0
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 #include <CGAL/Delaunay_triangulation_2.h>
 #include <CGAL/Constrained_Delaunay_triangulation_2.h>
+#include <CGAL/Unique_hash_map.h>
 
-#include <list>
+#include <cstring>
+#include <vector>
+
+#include <stdint.h>
 
 namespace {
 	template <class GeomTraits, class FaceBase>
@@ -95,6 +100,35 @@ namespace {
 	typedef CGAL::Exact_predicates_tag CDTIntersectionTag;
 	typedef CGAL::Constrained_Delaunay_triangulation_2<Kernel, TDS, CDTIntersectionTag> CDT;
 	typedef CGAL::Delaunay_triangulation_2<Kernel> DT;
+
+	// one face of a serialised triangulation, vertex 0 is the infinite one
+	struct SerialisedFace
+	{
+		uint32_t vertices[3];
+		uint32_t neighbors[3];
+		int32_t counter;
+		uint32_t constraints;
+	};
+
+	template <class T>
+	void append(std::vector<char> &buffer, T const &value)
+	{
+		char const *bytes = reinterpret_cast<char const *>(&value);
+		buffer.insert(buffer.end(), bytes, bytes + sizeof value);
+	}
+
+	template <class T>
+	bool take(char const *&data, char const *end, T &value)
+	{
+		if (static_cast<std::size_t>(end - data) < sizeof value) {
+			return false;
+		}
+
+		std::memcpy(&value, data, sizeof value);
+		data += sizeof value;
+
+		return true;
+	}
 } // end of private namespace
 
 class DelaunayTriangulation::DelaunayTriangulationImpl
@@ -161,6 +195,20 @@ public:
 		dt.insert(DT::Point(coord.x, coord.y));
 	}
 
+	void insert(std::vector<Coord2D> const &coords)
+	{
+		std::vector<DT::Point> points;
+
+		points.reserve(coords.size());
+
+		for (std::vector<Coord2D>::const_iterator it = coords.begin(); it != coords.end(); ++it) {
+			points.push_back(DT::Point(it->x, it->y));
+		}
+
+		// the range insertion sorts the points spatially first, so every point location is short
+		dt.insert(points.begin(), points.end());
+	}
+
 	void remove(Coord2D const &coord)
 	{
 		DT::Point p(coord.x, coord.y);
@@ -179,17 +227,24 @@ public:
 
 	bool pointIsVertex(Coord2D const &coord)
 	{
-		DT::Point p(coord.x, coord.y);
+		DT::Locate_type lt;
+		int li;
 
-		for (DT::Finite_vertices_iterator vit = dt.finite_vertices_begin();
-		     vit != dt.finite_vertices_end();
-		     ++vit) {
-			if (coord.x == vit->point().x() && coord.y == vit->point().y()) {
-				return true;
-			}
+		dt.locate(DT::Point(coord.x, coord.y), lt, li);
+
+		return lt == DT::VERTEX;
+	}
+
+	bool nearestVertex(Coord2D const &coord, Coord2D &nearest) const
+	{
+		if (dt.number_of_vertices() == 0) {
+			return false;
 		}
 
-		return false;
+		DT::Vertex_handle vh = dt.nearest_vertex(DT::Point(coord.x, coord.y));
+		nearest = Coord2D(vh->point().x(), vh->point().y());
+
+		return true;
 	}
 
 	std::vector<Triangle> getTriangulation()
@@ -226,6 +281,11 @@ public:
 		cdt.clear();
 	}
 
+	std::size_t numberOfFaces() const
+	{
+		return cdt.number_of_faces();
+	}
+
 	std::set<Coord2D> list() const
 	{
 		std::set<Coord2D> waypoints;
@@ -281,9 +341,23 @@ public:
 
 	void insert(Coord2D const &coord)
 	{
-		cdt.insert(CDT::Point(coord.x, coord.y));
+		CDT::Vertex_handle vh = cdt.insert(CDT::Point(coord.x, coord.y));
 
-		mark();
+		// only the faces around the new vertex changed
+		std::vector<CDT::Face_handle> changed;
+
+		if (cdt.dimension() == 2) {
+			CDT::Face_circulator fc = cdt.incident_faces(vh);
+			CDT::Face_circulator fc_done = fc;
+
+			do {
+				changed.push_back(fc);
+				fc->setCounter(-1);
+				++fc;
+			} while (fc != fc_done);
+		}
+
+		markLocally(changed);
 	}
 
 	void remove(Coord2D const &coord)
@@ -295,8 +369,40 @@ public:
 		     ++fit) {
 			for (int i = 0; i < 3; i++) {
 				if (fit->vertex(i)->point() == p) {
-					cdt.remove(fit->vertex(i));
-					mark();
+					CDT::Vertex_handle vh = fit->vertex(i);
+					std::vector<CDT::Vertex_handle> around;
+
+					CDT::Vertex_circulator vc = cdt.incident_vertices(vh);
+					CDT::Vertex_circulator vc_done = vc;
+
+					do {
+						around.push_back(vc);
+						++vc;
+					} while (vc != vc_done);
+
+					cdt.remove(vh);
+
+					// the faces filling the hole are new and still unmarked
+					std::vector<CDT::Face_handle> changed;
+
+					if (cdt.dimension() == 2) {
+						for (std::vector<CDT::Vertex_handle>::const_iterator it = around.begin();
+						     it != around.end();
+						     ++it) {
+							CDT::Face_circulator fc = cdt.incident_faces(*it);
+							CDT::Face_circulator fc_done = fc;
+
+							do {
+								if (fc->getCounter() == -1) {
+									changed.push_back(fc);
+								}
+
+								++fc;
+							} while (fc != fc_done);
+						}
+					}
+
+					markLocally(changed);
 					return;
 				}
 			}
@@ -322,27 +428,184 @@ public:
 		return false;
 	}
 
-	bool inDomain(float x, float y)
+	// points on the boundary of a face in the domain are inside, too, hint is the face to
+	// start the point location at and becomes the located face
+	bool inDomain(float x, float y, CDT::Face_handle &hint)
 	{
-		CDT::Point p(x, y);
+		CDT::Locate_type lt;
+		int li;
+		CDT::Face_handle fh = cdt.locate(CDT::Point(x, y), lt, li, hint);
 
-		for (CDT::Finite_faces_iterator fit = cdt.finite_faces_begin();
-		     fit != cdt.finite_faces_end();
-		     ++fit) {
-			for (int i = 0; i < 3; i++) {
-				if (fit->getInDomain()) {
-					CDT::Ctr::Triangulation::Triangle triangle = cdt.triangle(fit);
+		hint = fh;
+
+		switch (lt) {
+			case CDT::FACE:
+				return fh->getInDomain();
 
-					if (triangle.has_on_positive_side(p) || triangle.has_on_boundary(p)) {
+			case CDT::EDGE: {
+				CDT::Face_handle neighbor = fh->neighbor(li);
+
+				return fh->getInDomain() || (!cdt.is_infinite(neighbor) && neighbor->getInDomain());
+			}
+
+			case CDT::VERTEX: {
+				CDT::Face_circulator fc = cdt.incident_faces(fh->vertex(li));
+				CDT::Face_circulator fc_done = fc;
+
+				do {
+					if (!cdt.is_infinite(fc) && fc->getInDomain()) {
 						return true;
 					}
+
+					++fc;
+				} while (fc != fc_done);
+
+				return false;
+			}
+
+			default:
+				return false;
+		}
+	}
+
+	// like locate(), but if p is on an edge or a vertex the face towards q is chosen
+	CDT::Face_handle locateTowards(CDT::Point const &p, CDT::Point const &q) const
+	{
+		CDT::Locate_type lt;
+		int li;
+		CDT::Face_handle fh = cdt.locate(p, lt, li);
+
+		if (lt == CDT::EDGE) {
+			CDT::Point const &a = fh->vertex(CDT::ccw(li))->point();
+			CDT::Point const &b = fh->vertex(CDT::cw(li))->point();
+
+			if (cdt.orientation(a, b, q) == CGAL::RIGHT_TURN) {
+				return fh->neighbor(li);
+			}
+		} else if (lt == CDT::VERTEX) {
+			CDT::Vertex_handle vh = fh->vertex(li);
+			CDT::Face_circulator fc = cdt.incident_faces(vh, fh);
+			CDT::Face_circulator fc_done = fc;
+
+			do {
+				if (!cdt.is_infinite(fc)) {
+					int i = fc->index(vh);
+					CDT::Point const &a = fc->vertex(CDT::ccw(i))->point();
+					CDT::Point const &b = fc->vertex(CDT::cw(i))->point();
+
+					if (cdt.orientation(p, a, q) != CGAL::RIGHT_TURN &&
+					    cdt.orientation(p, b, q) != CGAL::LEFT_TURN) {
+						return fc;
+					}
 				}
+
+				++fc;
+			} while (fc != fc_done);
+		}
+
+		return fh;
+	}
+
+	// the segment p -> q passes through a vertex shared by the faces current and next, it
+	// crosses the walls there if constrained edges leave that vertex on both of its sides
+	bool crossesConstraintsAt(CDT::Face_handle current, CDT::Face_handle next,
+	                          CDT::Point const &p, CDT::Point const &q) const
+	{
+		for (int i = 0; i < 3; i++) {
+			CDT::Vertex_handle vh = current->vertex(i);
+
+			if (cdt.is_infinite(vh) || !next->has_vertex(vh) ||
+			    cdt.orientation(p, q, vh->point()) != CGAL::COLLINEAR) {
+				continue;
 			}
+
+			bool left = false;
+			bool right = false;
+			CDT::Edge_circulator ec = cdt.incident_edges(vh);
+			CDT::Edge_circulator ec_done = ec;
+
+			do {
+				if (!cdt.is_infinite(ec) && cdt.is_constrained(*ec)) {
+					CDT::Vertex_handle other = ec->first->vertex(CDT::cw(ec->second));
+
+					if (other == vh) {
+						other = ec->first->vertex(CDT::ccw(ec->second));
+					}
+
+					CGAL::Orientation side = cdt.orientation(p, q, other->point());
+
+					// walls along the segment itself are on neither side
+					if (side == CGAL::LEFT_TURN) {
+						left = true;
+					} else if (side == CGAL::RIGHT_TURN) {
+						right = true;
+					}
+				}
+
+				++ec;
+			} while (ec != ec_done);
+
+			return left && right;
 		}
 
 		return false;
 	}
 
+	bool segmentInDomain(Coord2D const &start, Coord2D const &end) const
+	{
+		if (cdt.dimension() != 2) {
+			return false;
+		}
+
+		CDT::Point p(start.x, start.y);
+		CDT::Point q(end.x, end.y);
+		CDT::Face_handle startFace = locateTowards(p, q);
+
+		if (cdt.is_infinite(startFace)) {
+			return false;
+		}
+
+		if (p == q) {
+			return startFace->getInDomain();
+		}
+
+		// visit the faces crossed by the segment, beginning at the face containing the start
+		CDT::Line_face_circulator lfc = cdt.line_walk(p, q, startFace);
+		CDT::Line_face_circulator lfc_done = lfc;
+
+		if (lfc == 0) {
+			return false;
+		}
+
+		do {
+			CDT::Face_handle current = lfc;
+
+			if (cdt.is_infinite(current) || !current->getInDomain()) {
+				return false;
+			}
+
+			if (cdt.oriented_side(current, q) != CGAL::ON_NEGATIVE_SIDE) {
+				return true;
+			}
+
+			++lfc;
+
+			CDT::Face_handle next = lfc;
+			int index;
+
+			if (current->has_neighbor(next, index)) {
+				if (cdt.is_constrained(CDT::Edge(current, index))) {
+					return false;
+				}
+			} else if (crossesConstraintsAt(current, next, p, q)) {
+				// the walk stepped over a vertex, e.g. a wall corner, there is no shared edge
+				return false;
+			}
+		} while (lfc != lfc_done);
+
+		return false;
+	}
+
 	std::vector<Triangle> getTriangulation()
 	{
 		std::vector<Triangle> triangulation;
@@ -370,6 +633,29 @@ public:
 
 	void insertConstraints(std::vector<Coord2D> const &points)
 	{
+		insertConstraintsUnmarked(points);
+
+		mark();
+	}
+
+	void insertConstraints(std::vector< std::vector<Coord2D> > const &polygons)
+	{
+		for (std::vector< std::vector<Coord2D> >::const_iterator it = polygons.begin();
+		     it != polygons.end();
+		     ++it) {
+			insertConstraintsUnmarked(*it);
+		}
+
+		// constraints split components, so one global pass after the batch
+		mark();
+	}
+
+	void insertConstraintsUnmarked(std::vector<Coord2D> const &points)
+	{
+		if (points.empty()) {
+			return;
+		}
+
 		Coord2D p, q;
 		CDT::Vertex_handle vh, wh;
 		std::vector<Coord2D>::const_iterator it = points.begin();
@@ -389,8 +675,6 @@ public:
 				std::cout << "duplicate point: " << p.x << '/' << p.y << std::endl;
 			}
 		}
-
-		mark();
 	}
 
 	std::vector<Edge> getConstrainedEdges() const
@@ -414,6 +698,131 @@ public:
 		return edges;
 	}
 
+	void serialize(std::vector<char> &buffer) const
+	{
+		if (cdt.dimension() != 2) {
+			return;
+		}
+
+		CGAL::Unique_hash_map<CDT::Vertex_handle, uint32_t> vertexIndices;
+		CGAL::Unique_hash_map<CDT::Face_handle, uint32_t> faceIndices;
+		uint32_t vertexCount = 1;
+		uint32_t faceCount = 0;
+
+		vertexIndices[cdt.infinite_vertex()] = 0;
+
+		for (CDT::Finite_vertices_iterator it = cdt.finite_vertices_begin(); it != cdt.finite_vertices_end(); ++it) {
+			vertexIndices[it] = vertexCount++;
+		}
+
+		for (CDT::All_faces_iterator it = cdt.all_faces_begin(); it != cdt.all_faces_end(); ++it) {
+			faceIndices[it] = faceCount++;
+		}
+
+		append(buffer, vertexCount);
+		append(buffer, faceCount);
+
+		for (CDT::Finite_vertices_iterator it = cdt.finite_vertices_begin(); it != cdt.finite_vertices_end(); ++it) {
+			append(buffer, it->point().x());
+			append(buffer, it->point().y());
+		}
+
+		for (CDT::All_faces_iterator it = cdt.all_faces_begin(); it != cdt.all_faces_end(); ++it) {
+			SerialisedFace face;
+
+			face.counter = it->getCounter();
+			face.constraints = 0;
+
+			for (int i = 0; i < 3; i++) {
+				face.vertices[i] = vertexIndices[it->vertex(i)];
+				face.neighbors[i] = faceIndices[it->neighbor(i)];
+
+				if (it->is_constrained(i)) {
+					face.constraints |= 1u << i;
+				}
+			}
+
+			append(buffer, face);
+		}
+	}
+
+	// rebuilds the combinatorial structure directly, like CGAL's own file input does
+	bool deserialize(char const *data, std::size_t size)
+	{
+		char const *end = data + size;
+		uint32_t vertexCount;
+		uint32_t faceCount;
+
+		cdt.clear();
+
+		if (!take(data, end, vertexCount) || !take(data, end, faceCount) || vertexCount < 4 || faceCount == 0) {
+			return false;
+		}
+
+		if (static_cast<std::size_t>(end - data) != (vertexCount - 1) * 2 * sizeof(double) + faceCount * sizeof(SerialisedFace)) {
+			return false;
+		}
+
+		cdt.tds().clear();
+		cdt.tds().set_dimension(2);
+
+		std::vector<CDT::Vertex_handle> vertices(vertexCount);
+		std::vector<CDT::Face_handle> faces(faceCount);
+
+		for (uint32_t i = 0; i < vertexCount; i++) {
+			vertices[i] = cdt.tds().create_vertex();
+
+			if (i > 0) {
+				double x;
+				double y;
+
+				take(data, end, x);
+				take(data, end, y);
+				vertices[i]->set_point(CDT::Point(x, y));
+			}
+		}
+
+		std::vector<SerialisedFace> serialisedFaces(faceCount);
+
+		for (uint32_t i = 0; i < faceCount; i++) {
+			SerialisedFace &face = serialisedFaces[i];
+
+			take(data, end, face);
+
+			for (int j = 0; j < 3; j++) {
+				if (face.vertices[j] >= vertexCount || face.neighbors[j] >= faceCount) {
+					cdt.clear();
+					return false;
+				}
+			}
+
+			faces[i] = cdt.tds().create_face(vertices[face.vertices[0]], vertices[face.vertices[1]],
+			                                 vertices[face.vertices[2]]);
+		}
+
+		for (uint32_t i = 0; i < faceCount; i++) {
+			SerialisedFace const &face = serialisedFaces[i];
+			CDT::Face_handle fh = faces[i];
+
+			fh->set_neighbors(faces[face.neighbors[0]], faces[face.neighbors[1]], faces[face.neighbors[2]]);
+			fh->setCounter(face.counter);
+
+			for (int j = 0; j < 3; j++) {
+				fh->set_constraint(j, (face.constraints & (1u << j)) != 0);
+				fh->vertex(j)->set_face(fh);
+			}
+		}
+
+		cdt.set_infinite_vertex(vertices[0]);
+
+		if (!cdt.is_valid()) {
+			cdt.clear();
+			return false;
+		}
+
+		return true;
+	}
+
 	void mark()
 	{
 		// mark faces in/out of domain
@@ -424,6 +833,68 @@ public:
 		discoverComponents();
 	}
 
+	// faces which are reached without crossing a constraint share one component
+	// and therefore one counter, copy it from an already marked neighbour
+	void markLocally(std::vector<CDT::Face_handle> const &changed)
+	{
+		if (cdt.dimension() != 2) {
+			return;
+		}
+
+		std::vector<CDT::Face_handle> component;
+		std::vector<CDT::Face_handle> stack;
+
+		for (std::vector<CDT::Face_handle>::const_iterator it = changed.begin();
+		     it != changed.end();
+		     ++it) {
+			if ((*it)->getCounter() != -1) {
+				continue;
+			}
+
+			int index = -1;
+
+			component.clear();
+			stack.push_back(*it);
+			// -2 is only used while the component is collected
+			(*it)->setCounter(-2);
+
+			while (!stack.empty()) {
+				CDT::Face_handle fh = stack.back();
+				stack.pop_back();
+				component.push_back(fh);
+
+				for (int i = 0; i < 3; i++) {
+					if (cdt.is_constrained(CDT::Edge(fh, i))) {
+						continue;
+					}
+
+					CDT::Face_handle neighbor = fh->neighbor(i);
+					int counter = neighbor->getCounter();
+
+					if (counter == -1) {
+						neighbor->setCounter(-2);
+						stack.push_back(neighbor);
+					} else if (counter >= 0) {
+						index = counter;
+					}
+				}
+			}
+
+			if (index == -1) {
+				// enclosed by constraints, the nesting level is unknown
+				mark();
+				return;
+			}
+
+			for (std::vector<CDT::Face_handle>::const_iterator cit = component.begin();
+			     cit != component.end();
+			     ++cit) {
+				(*cit)->setCounter(index);
+				(*cit)->setInDomain(index % 2 == 1);
+			}
+		}
+	}
+
 	void discoverComponents()
 	{
 		if (cdt.dimension() != 2) {
@@ -431,32 +902,37 @@ public:
 		}
 
 		int index = 0;
-		std::list<CDT::Edge> border;
-		discoverComponent(cdt.infinite_face(), index++, border);
+		// the border edges are consumed in FIFO order (nesting level by nesting level),
+		// a vector with a moving head avoids the node allocations of a list
+		std::vector<CDT::Edge> border;
+		std::vector<CDT::Face_handle> stack;
+		std::size_t head = 0;
+
+		discoverComponent(cdt.infinite_face(), index++, border, stack);
 
-		while (!border.empty()) {
-			CDT::Edge edge = border.front();
-			border.pop_front();
+		while (head != border.size()) {
+			CDT::Edge edge = border[head++];
 			CDT::Face_handle neigbor = edge.first->neighbor(edge.second);
 
 			if (neigbor->getCounter() == -1) {
-				discoverComponent(neigbor, edge.first->getCounter() + 1, border);
+				discoverComponent(neigbor, edge.first->getCounter() + 1, border, stack);
 			}
 		}
 	}
 
-	void discoverComponent(CDT::Face_handle start, int index, std::list<CDT::Edge>& border)
+	void discoverComponent(CDT::Face_handle start, int index, std::vector<CDT::Edge> &border,
+	                       std::vector<CDT::Face_handle> &stack)
 	{
 		if (start->getCounter() != -1) {
 			return;
 		}
 
-		std::list<CDT::Face_handle> queue;
-		queue.push_back(start);
+		// flooding a single component doesn't depend on the visiting order
+		stack.push_back(start);
 
-		while (!queue.empty()) {
-			CDT::Face_handle fh = queue.front();
-			queue.pop_front();
+		while (!stack.empty()) {
+			CDT::Face_handle fh = stack.back();
+			stack.pop_back();
 
 			if (fh->getCounter() == -1) {
 				fh->setCounter(index);
@@ -470,7 +946,7 @@ public:
 						if (cdt.is_constrained(edge)) {
 							border.push_back(edge);
 						} else {
-							queue.push_back(neighbor);
+							stack.push_back(neighbor);
 						}
 					}
 				}
@@ -491,6 +967,8 @@ DelaunayTriangulation::~DelaunayTriangulation()
 
 NeighboursMap DelaunayTriangulation::getNeighbours() const
 {
+	TRACE_SPAN("getNeighbours");
+
 	return p->getNeighbours();
 }
 
@@ -504,6 +982,11 @@ void DelaunayTriangulation::insert(Coord2D const &coord)
 	p->insert(coord);
 }
 
+void DelaunayTriangulation::insert(std::vector<Coord2D> const &coords)
+{
+	p->insert(coords);
+}
+
 void DelaunayTriangulation::remove(Coord2D const &coord)
 {
 	p->remove(coord);
@@ -524,6 +1007,11 @@ bool DelaunayTriangulation::pointIsVertex(Coord2D const &coord)
 	return p->pointIsVertex(coord);
 }
 
+bool DelaunayTriangulation::nearestVertex(Coord2D const &coord, Coord2D &nearest) const
+{
+	return p->nearestVertex(coord, nearest);
+}
+
 ConstrainedDelaunayTriangulation::ConstrainedDelaunayTriangulation()
 	: p(new ConstrainedDelaunayTriangulationImpl)
 {
@@ -544,6 +1032,11 @@ std::vector<Triangle> ConstrainedDelaunayTriangulation::getTriangulation() const
 	return p->getTriangulation();
 }
 
+bool ConstrainedDelaunayTriangulation::segmentInDomain(Coord2D const &start, Coord2D const &end) const
+{
+	return p->segmentInDomain(start, end);
+}
+
 void ConstrainedDelaunayTriangulation::insert(Coord2D const &coord)
 {
 	p->insert(coord);
@@ -564,9 +1057,27 @@ void ConstrainedDelaunayTriangulation::clear()
 	p->clear();
 }
 
+std::size_t ConstrainedDelaunayTriangulation::numberOfFaces() const
+{
+	return p->numberOfFaces();
+}
+
 bool ConstrainedDelaunayTriangulation::inDomain(float x, float y) const
 {
-	return p->inDomain(x, y);
+	CDT::Face_handle hint;
+
+	return p->inDomain(x, y, hint);
+}
+
+void ConstrainedDelaunayTriangulation::inDomain(std::vector<Coord2D> const &coords, std::vector<bool> &inside) const
+{
+	CDT::Face_handle hint;
+
+	inside.resize(coords.size());
+
+	for (std::size_t i = 0; i < coords.size(); i++) {
+		inside[i] = p->inDomain(coords[i].x, coords[i].y, hint);
+	}
 }
 
 bool ConstrainedDelaunayTriangulation::pointIsVertex(Coord2D const &coord) const
@@ -579,6 +1090,21 @@ void ConstrainedDelaunayTriangulation::insertConstraints(std::vector<Coord2D> co
 	p->insertConstraints(points);
 }
 
+void ConstrainedDelaunayTriangulation::insertConstraints(std::vector< std::vector<Coord2D> > const &polygons)
+{
+	p->insertConstraints(polygons);
+}
+
+void ConstrainedDelaunayTriangulation::serialize(std::vector<char> &buffer) const
+{
+	p->serialize(buffer);
+}
+
+bool ConstrainedDelaunayTriangulation::deserialize(char const *data, std::size_t size)
+{
+	return p->deserialize(data, size);
+}
+
 std::vector<Edge> ConstrainedDelaunayTriangulation::getConstrainedEdges() const
 {
 	return p->getConstrainedEdges();
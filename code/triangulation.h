@@ -6,6 +6,7 @@
 #include "neighbours.h"
 #include "triangle.h"
 
+#include <cstddef>
 #include <vector>
 #include <set>
 
@@ -19,6 +20,8 @@ public:
 	std::vector<Triangle> getTriangulation() const;
 
 	void insert(Coord2D const &coord);
+	// inserts all coordinates in one spatially sorted pass
+	void insert(std::vector<Coord2D> const &coords);
 	void remove(Coord2D const &coord);
 	std::set<Coord2D> list() const;
 	void clear();
@@ -26,6 +29,7 @@ public:
 	// check before with new algorithm
 	//bool inDomain(Coord2D const &coord);
 	bool pointIsVertex(Coord2D const &coord);
+	bool nearestVertex(Coord2D const &coord, Coord2D &nearest) const;
 
 private:
 	class DelaunayTriangulationImpl;
@@ -47,10 +51,23 @@ public:
 	void clear();
 
 	bool inDomain(float x, float y) const;
+	// one result per coordinate, every point location starts at the previous face, so
+	// spatially sorted coordinates are located fastest
+	void inDomain(std::vector<Coord2D> const &coords, std::vector<bool> &inside) const;
+	// walks along the segment and fails on the first constraint or face outside the domain
+	bool segmentInDomain(Coord2D const &start, Coord2D const &end) const;
 	bool pointIsVertex(Coord2D const &coord) const;
 
 	void insertConstraints(std::vector<Coord2D> const &points);
+	// inserts all polygons first and marks the domain only once afterwards
+	void insertConstraints(std::vector< std::vector<Coord2D> > const &polygons);
 	std::vector<Edge> getConstrainedEdges() const;
+	std::size_t numberOfFaces() const;
+
+	// binary snapshot including the domain marks, appended to buffer (nothing unless 2D)
+	void serialize(std::vector<char> &buffer) const;
+	// replaces the triangulation, false (and an empty triangulation) on malformed data
+	bool deserialize(char const *data, std::size_t size);
 
 private:
 	class ConstrainedDelaunayTriangulationImpl;
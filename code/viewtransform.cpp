@@ -0,0 +1,69 @@
+#include "gl.h"
+#include "viewtransform.h"
+
+#ifdef WIN32
+#include <GL/glew.h>
+#endif
+#include <GL/gl.h>
+
+ViewTransform::ViewTransform()
+	: viewportWidth_(0),
+	  viewportHeight_(0),
+	  roomWidth_(0),
+	  roomHeight_(0)
+{
+}
+
+void ViewTransform::setViewport(int width, int height)
+{
+	viewportWidth_ = width;
+	viewportHeight_ = height;
+}
+
+void ViewTransform::setRoomSize(unsigned int width, unsigned int height)
+{
+	roomWidth_ = width;
+	roomHeight_ = height;
+}
+
+void ViewTransform::apply() const
+{
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	// default projection: glOrtho(l=-1,r=1,b=-1,t=1,n=1,f=-1)
+	glOrtho(0, roomWidth_, 0, roomHeight_, -1.0f, 4.0f);
+	checkGLError();
+
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+	glTranslatef(0.0f, 0.0f, -3.5f);
+}
+
+bool ViewTransform::toRoom(int x, int y, Coord2D &coord) const
+{
+	if (viewportWidth_ <= 0 || viewportHeight_ <= 0) {
+		return false;
+	}
+
+	// the projection stretches the room over the whole viewport,
+	// OpenGL counts y from the bottom and the room from the top so both flips cancel
+	double roomX = static_cast<double>(x) * roomWidth_ / viewportWidth_;
+	double roomY = static_cast<double>(y) * roomHeight_ / viewportHeight_;
+
+	if (roomX < 0 || roomY < 0 || roomX >= roomWidth_ || roomY >= roomHeight_) {
+		return false;
+	}
+
+	coord = Coord2D(static_cast<unsigned int>(roomX), static_cast<unsigned int>(roomY));
+
+	return true;
+}
+
+float ViewTransform::pixelsPerUnit() const
+{
+	if (roomWidth_ == 0) {
+		return 1.0f;
+	}
+
+	return static_cast<float>(viewportWidth_) / roomWidth_;
+}
@@ -0,0 +1,30 @@
+#ifndef ROB_VIEWTRANSFORM_H_INCLUDED
+#define ROB_VIEWTRANSFORM_H_INCLUDED
+
+#include "coord.h"
+
+// orthographic mapping of the room onto the viewport, shared by drawing and picking
+class ViewTransform
+{
+public:
+	ViewTransform();
+
+	void setViewport(int width, int height);
+	void setRoomSize(unsigned int width, unsigned int height);
+
+	// loads the projection and model view matrices used for drawing the room
+	void apply() const;
+
+	// maps window coordinates (origin top-left) to room coordinates
+	bool toRoom(int x, int y, Coord2D &coord) const;
+	// size of one room unit in viewport pixels
+	float pixelsPerUnit() const;
+
+private:
+	int viewportWidth_;
+	int viewportHeight_;
+	unsigned int roomWidth_;
+	unsigned int roomHeight_;
+};
+
+#endif // ROB_VIEWTRANSFORM_H_INCLUDED
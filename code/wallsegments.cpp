@@ -0,0 +1,227 @@
+#include "cpu.h"
+#include "wallsegments.h"
+
+#include <algorithm>
+#include <cassert>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define ROB_WALLSEGMENTS_AVX2 1
+#include <immintrin.h>
+#endif
+
+namespace
+{
+	// coordinates below this limit keep all 64 bit products and sums exact
+	unsigned int const scalarCoordLimit = 1u << 30;
+	// coordinates below this limit keep the 32 bit cross products of the vector kernel exact
+	unsigned int const vectorCoordLimit = 1u << 15;
+
+	bool segmentsIntersect(int64_t px, int64_t py, int64_t rx, int64_t ry,
+	                       int64_t qx, int64_t qy, int64_t sx, int64_t sy);
+
+	bool segmentsIntersect(int64_t px, int64_t py, int64_t rx, int64_t ry,
+	                       int64_t qx, int64_t qy, int64_t sx, int64_t sy)
+	{
+		// p + t * r == q + u * s
+		int64_t qpX = qx - px;
+		int64_t qpY = qy - py;
+		int64_t rCrossS = rx * sy - ry * sx;
+		int64_t qpCrossS = qpX * sy - qpY * sx;
+		int64_t qpCrossR = qpX * ry - qpY * rx;
+
+		if (rCrossS == 0) {
+			if (qpCrossR != 0) {
+				// parallel
+				return false;
+			}
+
+			int64_t rMultR = rx * rx + ry * ry;
+
+			if (rMultR == 0) {
+				// the checked edge is a single point, it has to be on the wall
+				int64_t sMultS = sx * sx + sy * sy;
+				int64_t pqMultS = -(qpX * sx + qpY * sy);
+
+				if (qpCrossS != 0) {
+					return false;
+				}
+
+				if (sMultS == 0) {
+					return qpX == 0 && qpY == 0;
+				}
+
+				return 0 <= pqMultS && pqMultS <= sMultS;
+			}
+
+			// collinear, compare the projections onto r
+			int64_t t0 = qpX * rx + qpY * ry;
+			int64_t t1 = t0 + sx * rx + sy * ry;
+
+			return std::min(t0, t1) <= rMultR && std::max(t0, t1) >= 0;
+		}
+
+		if (rCrossS < 0) {
+			rCrossS = -rCrossS;
+			qpCrossS = -qpCrossS;
+			qpCrossR = -qpCrossR;
+		}
+
+		return 0 <= qpCrossS && qpCrossS <= rCrossS && 0 <= qpCrossR && qpCrossR <= rCrossS;
+	}
+}
+
+WallSegments::WallSegments()
+	: fitsInt32Kernel_(true)
+{
+}
+
+void WallSegments::addPolygon(std::vector<Edge> const &polygon)
+{
+	polygonStarts_.push_back(x0_.size());
+
+	for (std::vector<Edge>::const_iterator it = polygon.begin(); it != polygon.end(); ++it) {
+		assert(it->start.x < scalarCoordLimit && it->start.y < scalarCoordLimit);
+		assert(it->end.x < scalarCoordLimit && it->end.y < scalarCoordLimit);
+
+		x0_.push_back(static_cast<int32_t>(it->start.x));
+		y0_.push_back(static_cast<int32_t>(it->start.y));
+		dx_.push_back(static_cast<int32_t>(it->end.x) - static_cast<int32_t>(it->start.x));
+		dy_.push_back(static_cast<int32_t>(it->end.y) - static_cast<int32_t>(it->start.y));
+
+		if (std::max(std::max(it->start.x, it->start.y), std::max(it->end.x, it->end.y)) >= vectorCoordLimit) {
+			fitsInt32Kernel_ = false;
+		}
+	}
+}
+
+void WallSegments::clear()
+{
+	x0_.clear();
+	y0_.clear();
+	dx_.clear();
+	dy_.clear();
+	polygonStarts_.clear();
+	fitsInt32Kernel_ = true;
+}
+
+std::size_t WallSegments::size() const
+{
+	return x0_.size();
+}
+
+std::vector< std::vector<Edge> > WallSegments::polygons() const
+{
+	std::vector< std::vector<Edge> > result;
+
+	for (std::size_t i = 0; i < polygonStarts_.size(); i++) {
+		std::size_t end = i + 1 < polygonStarts_.size() ? polygonStarts_[i + 1] : x0_.size();
+		std::vector<Edge> polygon;
+
+		for (std::size_t j = polygonStarts_[i]; j < end; j++) {
+			Coord2D start(x0_[j], y0_[j]);
+			Coord2D stop(x0_[j] + dx_[j], y0_[j] + dy_[j]);
+
+			polygon.push_back(Edge(start, stop));
+		}
+
+		result.push_back(polygon);
+	}
+
+	return result;
+}
+
+bool WallSegments::intersects(Edge const &edge) const
+{
+#if ROB_WALLSEGMENTS_AVX2
+	bool edgeFits = std::max(edge.start.x, edge.start.y) < vectorCoordLimit &&
+	                std::max(edge.end.x, edge.end.y) < vectorCoordLimit;
+
+	if (fitsInt32Kernel_ && edgeFits && cpuHasAVX2()) {
+		return intersectsAVX2(edge);
+	}
+#endif
+
+	return intersectsScalar(edge, 0, x0_.size());
+}
+
+bool WallSegments::intersectsScalar(Edge const &edge) const
+{
+	return intersectsScalar(edge, 0, x0_.size());
+}
+
+bool WallSegments::intersectsScalar(Edge const &edge, std::size_t begin, std::size_t end) const
+{
+	int64_t px = edge.start.x;
+	int64_t py = edge.start.y;
+	int64_t rx = static_cast<int64_t>(edge.end.x) - px;
+	int64_t ry = static_cast<int64_t>(edge.end.y) - py;
+
+	for (std::size_t i = begin; i < end; i++) {
+		if (segmentsIntersect(px, py, rx, ry, x0_[i], y0_[i], dx_[i], dy_[i])) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+#if ROB_WALLSEGMENTS_AVX2
+__attribute__((target("avx2")))
+bool WallSegments::intersectsAVX2(Edge const &edge) const
+{
+	int32_t px = static_cast<int32_t>(edge.start.x);
+	int32_t py = static_cast<int32_t>(edge.start.y);
+	int32_t rx = static_cast<int32_t>(edge.end.x) - px;
+	int32_t ry = static_cast<int32_t>(edge.end.y) - py;
+
+	__m256i const zero = _mm256_setzero_si256();
+	__m256i const vpx = _mm256_set1_epi32(px);
+	__m256i const vpy = _mm256_set1_epi32(py);
+	__m256i const vrx = _mm256_set1_epi32(rx);
+	__m256i const vry = _mm256_set1_epi32(ry);
+
+	std::size_t const count = x0_.size();
+	std::size_t i = 0;
+
+	// eight walls per iteration, same predicate as segmentsIntersect()
+	for (; i + 8 <= count; i += 8) {
+		__m256i qx = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(&x0_[i]));
+		__m256i qy = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(&y0_[i]));
+		__m256i sx = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(&dx_[i]));
+		__m256i sy = _mm256_loadu_si256(reinterpret_cast<__m256i const *>(&dy_[i]));
+
+		__m256i qpX = _mm256_sub_epi32(qx, vpx);
+		__m256i qpY = _mm256_sub_epi32(qy, vpy);
+		__m256i rCrossS = _mm256_sub_epi32(_mm256_mullo_epi32(vrx, sy), _mm256_mullo_epi32(vry, sx));
+		__m256i qpCrossS = _mm256_sub_epi32(_mm256_mullo_epi32(qpX, sy), _mm256_mullo_epi32(qpY, sx));
+		__m256i qpCrossR = _mm256_sub_epi32(_mm256_mullo_epi32(qpX, vry), _mm256_mullo_epi32(qpY, vrx));
+
+		// negate all three where r x s < 0 (sign is 0 or -1)
+		__m256i sign = _mm256_srai_epi32(rCrossS, 31);
+		rCrossS = _mm256_sub_epi32(_mm256_xor_si256(rCrossS, sign), sign);
+		qpCrossS = _mm256_sub_epi32(_mm256_xor_si256(qpCrossS, sign), sign);
+		qpCrossR = _mm256_sub_epi32(_mm256_xor_si256(qpCrossR, sign), sign);
+
+		__m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(zero, qpCrossS),
+		                                  _mm256_cmpgt_epi32(qpCrossS, rCrossS));
+		outside = _mm256_or_si256(outside, _mm256_cmpgt_epi32(zero, qpCrossR));
+		outside = _mm256_or_si256(outside, _mm256_cmpgt_epi32(qpCrossR, rCrossS));
+
+		__m256i parallel = _mm256_cmpeq_epi32(rCrossS, zero);
+		__m256i hit = _mm256_andnot_si256(_mm256_or_si256(outside, parallel), _mm256_set1_epi32(-1));
+
+		if (!_mm256_testz_si256(hit, hit)) {
+			return true;
+		}
+
+		// collinear walls are rare, the scalar code handles the projections
+		__m256i collinear = _mm256_and_si256(parallel, _mm256_cmpeq_epi32(qpCrossR, zero));
+
+		if (!_mm256_testz_si256(collinear, collinear) && intersectsScalar(edge, i, i + 8)) {
+			return true;
+		}
+	}
+
+	return intersectsScalar(edge, i, count);
+}
+#endif
@@ -0,0 +1,43 @@
+#ifndef ROB_WALLSEGMENTS_H_INCLUDED
+#define ROB_WALLSEGMENTS_H_INCLUDED
+
+#include "edge.h"
+
+#include <cstddef>
+#include <vector>
+
+#include <stdint.h>
+
+// wall segments of the room stored as structure of arrays (x0[], y0[], dx[], dy[])
+// so one roadmap edge can be tested against several walls per instruction
+class WallSegments
+{
+public:
+	WallSegments();
+
+	void addPolygon(std::vector<Edge> const &polygon);
+	void clear();
+
+	std::size_t size() const;
+	std::vector< std::vector<Edge> > polygons() const;
+
+	// true if the closed segment touches or crosses any wall
+	bool intersects(Edge const &edge) const;
+	// reference implementation with 64 bit arithmetic, used as fallback
+	bool intersectsScalar(Edge const &edge) const;
+
+private:
+	bool intersectsScalar(Edge const &edge, std::size_t begin, std::size_t end) const;
+	bool intersectsAVX2(Edge const &edge) const;
+
+	std::vector<int32_t> x0_;
+	std::vector<int32_t> y0_;
+	std::vector<int32_t> dx_;
+	std::vector<int32_t> dy_;
+	// index of the first wall of every polygon
+	std::vector<std::size_t> polygonStarts_;
+	// all coordinates fit into 15 bits, so 32 bit cross products can't overflow
+	bool fitsInt32Kernel_;
+};
+
+#endif // ROB_WALLSEGMENTS_H_INCLUDED
@@ -1,8 +1,12 @@
+#include "binarystream.h"
 #include "drawing.h"
 #include "drawwidget.h"
 #include "stats.h"
+#include "trace.h"
 #include "widgets.h"
 
+#include <QtCore/QFile>
+#include <QtCore/QSaveFile>
 #include <QtCore/QXmlStreamReader>
 #include <QtCore/QXmlStreamWriter>
 #include <QtGui/QIntValidator>
@@ -20,53 +24,54 @@
 #include <QtWidgets/QTableWidget>
 #include <QtWidgets/QTextEdit>
 
+#include <cstring>
 #include <vector>
 
 #include <assert.h>
 
 namespace
 {
-	QString secondsString(uint64_t msec);
-
-	QString secondsString(uint64_t msec)
+	QString const projectFilter("XML files (*.xml);;Binary projects (*.robproj)");
+	QString const binaryProjectSuffix(".robproj");
+	char const binaryProjectMagic[8] = { 'R', 'O', 'B', 'P', 'R', 'O', 'J', '\0' };
+	// bump whenever the layout changes, version 2 added the roadmap section after the room
+	uint32_t const binaryProjectVersion = 2;
+	// version 1 projects only lack the roadmap section, the room reads them as well
+	uint32_t const oldestBinaryProjectVersion = 1;
+
+	QString durationString(uint64_t nsec);
+	void fillTable(QTableWidget *table);
+
+	QString durationString(uint64_t nsec)
 	{
-#if 0
-		if (nsec > 60 * 1000 * 1000) {
-			uint64_t mins = nsec / (60 * 1000 * 1000);
-			uint64_t _nsec = nsec - mins * (60 * 1000 * 1000);
-			uint64_t secs = _nsec / (1000 * 1000);
-			_nsec = _nsec - secs * (1000 * 1000);
-			uint64_t msec = _nsec / 1000;
-			_nsec = _nsec - msec * 1000;
-			return QString::number(mins) + " m " + QString::number(secs) + " s " + QString::number(msec) + " ms " + QString::number(_nsec) + " ns";
-		} else if (nsec > 1000 * 1000) {
-			uint64_t secs = nsec / (1000 * 1000);
-			uint64_t _nsec = nsec - secs * (1000 * 1000);
-			uint64_t msec = _nsec / 1000;
-			_nsec = _nsec - msec * 1000;
-			return QString::number(secs) + " s " + QString::number(msec) + " ms " + QString::number(_nsec) + " ns";
-		} else if (nsec > 1000) {
-			uint64_t msec = nsec / 1000;
-			uint64_t _nsec = nsec % 1000;
-			return QString::number(msec) + " ms " + QString::number(_nsec) + " ns";
-		} else {
-			return QString::number(nsec) + " ns";
-		}
-#else
-		if (msec > 60 * 1000) {
+		uint64_t msec = nsec / (1000 * 1000);
+
+		if (msec >= 60 * 1000) {
 			uint64_t mins = msec / (60 * 1000);
 			uint64_t _msec = msec - mins * (60 * 1000);
 			uint64_t secs = _msec / 1000;
 			_msec = _msec - secs * 1000;
 			return QString::number(mins) + " m " + QString::number(secs) + " s " + QString::number(_msec) + " ms";
-		} else if (msec > 1000) {
+		} else if (msec >= 1000) {
 			uint64_t secs = msec / 1000;
 			uint64_t _msec = msec % 1000;
 			return QString::number(secs) + " s " + QString::number(_msec) + " ms";
+		} else if (nsec >= 1000 * 1000) {
+			return QString::number(nsec / 1e6, 'f', 3) + " ms";
+		} else if (nsec >= 1000) {
+			return QString::number(nsec / 1e3, 'f', 3) + " us";
 		} else {
-			return QString::number(msec) + " ms";
+			return QString::number(nsec) + " ns";
 		}
-#endif
+	}
+
+	// sizes the columns to their contents, the table isn't editable
+	void fillTable(QTableWidget *table)
+	{
+		table->verticalHeader()->hide();
+		table->setEditTriggers(QAbstractItemView::NoEditTriggers);
+		table->resizeRowsToContents();
+		table->resizeColumnsToContents();
 	}
 }
 
@@ -83,6 +88,14 @@ MainWindow::MainWindow(QWidget *parent)
 	QAction *actProjectSave = menuRoom->addAction(tr("&Save project"));
 	connect(actProjectSave, SIGNAL(triggered()), central, SLOT(wantsProjectSaved()));
 
+	QMenu *menuTrace = menuBar()->addMenu(tr("&Trace"));
+	QAction *actTraceRecord = menuTrace->addAction(tr("&Record trace"));
+	actTraceRecord->setCheckable(true);
+	actTraceRecord->setChecked(tracingEnabled());
+	connect(actTraceRecord, SIGNAL(toggled(bool)), central, SLOT(wantsTraceRecorded(bool)));
+	QAction *actTraceSave = menuTrace->addAction(tr("&Save trace"));
+	connect(actTraceSave, SIGNAL(triggered()), central, SLOT(wantsTraceSaved()));
+
 	QAction *actQuit = menuBar()->addAction(tr("&Quit"));
 	connect(actQuit, SIGNAL(triggered()), this, SLOT(close()));
 
@@ -125,6 +138,10 @@ CentralWidget::CentralWidget(QWidget *parent)
 	boxAlgorithms_ = new QComboBox(this);
 	boxAlgorithms_->addItem("Dijkstra");
 	boxAlgorithms_->addItem("A*");
+	boxAlgorithms_->addItem("Door graph");
+	boxAlgorithms_->addItem("Cluster graph");
+	boxAlgorithms_->addItem("Contraction hierarchy");
+	boxLazy_ = new QCheckBox(tr("Lazy edge validation"), this);
 	buttonAnimate_ = new QPushButton(tr("Animate"), this);
 	buttonStats_ = new QPushButton(tr("Statistics"), this);
 
@@ -138,6 +155,7 @@ CentralWidget::CentralWidget(QWidget *parent)
 	connect(boxShowPath_, SIGNAL(stateChanged(int)), this, SLOT(checkBoxChanged(int)));
 	connect(boxShowNeighbours_, SIGNAL(stateChanged(int)), this, SLOT(checkBoxChanged(int)));
 	connect(boxAlgorithms_, SIGNAL(activated(int)), this, SLOT(checkBoxChanged(int)));
+	connect(boxLazy_, SIGNAL(stateChanged(int)), this, SLOT(checkBoxChanged(int)));
 	connect(buttonAnimate_, SIGNAL(clicked()), this, SLOT(buttonClicked()));
 	connect(buttonStats_, SIGNAL(clicked()), this, SLOT(buttonClicked()));
 
@@ -167,6 +185,7 @@ CentralWidget::CentralWidget(QWidget *parent)
 	sideLayout->addWidget(line2);
 	sideLayout->addWidget(algorithmsLabel);
 	sideLayout->addWidget(boxAlgorithms_);
+	sideLayout->addWidget(boxLazy_);
 	QFrame *line3 = new QFrame(this);
 	line3->setFrameShape(QFrame::HLine);
 	line3->setFrameShadow(QFrame::Sunken);
@@ -194,6 +213,7 @@ CentralWidget::CentralWidget(QWidget *parent)
 	boxShowWay_->installEventFilter(filter);
 	boxShowPath_->installEventFilter(filter);
 	boxShowNeighbours_->installEventFilter(filter);
+	boxLazy_->installEventFilter(filter);
 }
 
 CentralWidget::~CentralWidget()
@@ -222,7 +242,7 @@ void CentralWidget::wantsRoomLoaded()
 
 void CentralWidget::wantsProjectLoaded()
 {
-	QString filename = QFileDialog::getOpenFileName(this, tr("Load project"), "", "XML files (*.xml)");
+	QString filename = QFileDialog::getOpenFileName(this, tr("Load project"), "", projectFilter);
 
 	if (filename.length() == 0) {
 		return;
@@ -230,13 +250,44 @@ void CentralWidget::wantsProjectLoaded()
 
 	removeRoom();
 
+	createNewDrawing();
+
+	bool binary = filename.endsWith(binaryProjectSuffix);
+	QString errorString = binary ? loadBinaryProject(filename) : loadXmlProject(filename);
+
+	if (errorString.length() != 0) {
+		QDialog *errorDialog(new QDialog(this));
+		errorDialog->setWindowTitle(binary ? "Errors while reading binary project" : "XML errors while reading XML project");
+		QVBoxLayout *layout = new QVBoxLayout(errorDialog);
+		QTextEdit *textEdit = new QTextEdit(this);
+
+		textEdit->insertPlainText("The following error occured:\n");
+		textEdit->insertPlainText(errorString);
+
+		QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Cancel, Qt::Horizontal, errorDialog);
+
+		connect(buttons, SIGNAL(rejected()), errorDialog, SLOT(reject()));
+
+		layout->addWidget(textEdit);
+		layout->addWidget(buttons);
+
+		errorDialog->exec();
+		delete errorDialog;
+
+		delete drawing_;
+		drawing_ = 0;
+	} else {
+		createDrawWidget();
+	}
+}
+
+QString CentralWidget::loadXmlProject(QString const &filename)
+{
 	QFile loadFile(filename);
 	loadFile.open(QIODevice::ReadOnly | QIODevice::Text);
 
 	QXmlStreamReader reader(&loadFile);
 
-	createNewDrawing();
-
 	QString errorString;
 
 	if (reader.readNextStartElement()) {
@@ -275,35 +326,52 @@ void CentralWidget::wantsProjectLoaded()
 		}
 	}
 
-	if (errorString.length() != 0) {
-		QDialog *errorDialog(new QDialog(this));
-		errorDialog->setWindowTitle("XML errors while reading XML project");
-		QVBoxLayout *layout = new QVBoxLayout(errorDialog);
-		QTextEdit *textEdit = new QTextEdit(this);
+	return errorString;
+}
 
-		textEdit->insertPlainText("The following error occured:\n");
-		textEdit->insertPlainText(errorString);
+// the file is mapped, so even projects with millions of waypoints aren't copied around
+QString CentralWidget::loadBinaryProject(QString const &filename)
+{
+	QFile loadFile(filename);
 
-		QDialogButtonBox *buttons = new QDialogButtonBox(QDialogButtonBox::Cancel, Qt::Horizontal, errorDialog);
+	if (!loadFile.open(QIODevice::ReadOnly)) {
+		return loadFile.errorString();
+	}
 
-		connect(buttons, SIGNAL(rejected()), errorDialog, SLOT(reject()));
+	qint64 size = loadFile.size();
+	uchar *data = size > 0 ? loadFile.map(0, size) : 0;
 
-		layout->addWidget(textEdit);
-		layout->addWidget(buttons);
+	if (!data) {
+		return "The project file could not be mapped.";
+	}
 
-		errorDialog->exec();
-		delete errorDialog;
+	BinaryReader reader(reinterpret_cast<char const *>(data), size);
+	char magic[sizeof binaryProjectMagic];
+	uint32_t version;
 
-		delete drawing_;
-		drawing_ = 0;
-	} else {
-		createDrawWidget();
+	if (!reader.readBytes(magic, sizeof magic) || std::memcmp(magic, binaryProjectMagic, sizeof magic) != 0) {
+		return "The file is no binary project.";
+	}
+
+	if (!reader.readU32(version) || version < oldestBinaryProjectVersion || version > binaryProjectVersion) {
+		return "The binary project has an unsupported version.";
+	}
+
+	if (!drawing_->loadBinaryProject(reader)) {
+		return "The drawing could not be read properly.";
 	}
+
+	// nothing follows the room
+	if (!reader.atEnd()) {
+		return "Unexpected data after the room.";
+	}
+
+	return QString();
 }
 
 void CentralWidget::wantsProjectSaved()
 {
-	QString filename = QFileDialog::getSaveFileName(this, tr("Save project"), "", "XML files (*.xml)");
+	QString filename = QFileDialog::getSaveFileName(this, tr("Save project"), "", projectFilter);
 
 	if (filename.length() == 0) {
 		return;
@@ -311,7 +379,23 @@ void CentralWidget::wantsProjectSaved()
 
 	std::string error;
 
-	if (drawing_) {
+	if (drawing_ && filename.endsWith(binaryProjectSuffix)) {
+		std::vector<char> buffer;
+		BinaryWriter writer(buffer);
+
+		writer.writeBytes(binaryProjectMagic, sizeof binaryProjectMagic);
+		writer.writeU32(binaryProjectVersion);
+
+		QSaveFile saveFile(filename);
+
+		if (!drawing_->saveBinaryProject(writer)) {
+			error = "The drawing could not be written.";
+		} else if (!saveFile.open(QIODevice::WriteOnly) ||
+		           saveFile.write(&buffer[0], buffer.size()) != static_cast<qint64>(buffer.size()) ||
+		           !saveFile.commit()) {
+			error = saveFile.errorString().toStdString();
+		}
+	} else if (drawing_) {
 		QFile saveFile(filename);
 		saveFile.open(QIODevice::WriteOnly | QIODevice::Text);
 
@@ -332,7 +416,7 @@ void CentralWidget::wantsProjectSaved()
 
 	if (!error.empty()) {
 		QDialog *errorDialog(new QDialog(this));
-		errorDialog->setWindowTitle("XML errors while writing XML project");
+		errorDialog->setWindowTitle("Errors while writing project");
 		QVBoxLayout *layout = new QVBoxLayout(errorDialog);
 		QTextEdit *textEdit = new QTextEdit(this);
 
@@ -401,11 +485,11 @@ void CentralWidget::checkBoxChanged(int state)
 		drawing_->setWaypointModification(mod);
 		return;
 	} else if (sender == boxAlgorithms_) {
-		if (state == 0) {
-			drawing_->setAlgorithm(Room::Dijkstra);
-		} else {
-			drawing_->setAlgorithm(Room::AStar);
-		}
+		// the items are in the order of Room::Algorithm
+		drawing_->setAlgorithm(static_cast<Room::Algorithm>(state));
+		return;
+	} else if (sender == boxLazy_) {
+		drawing_->setLazyValidation(state == Qt::Checked);
 		return;
 	}
 
@@ -444,75 +528,102 @@ void CentralWidget::buttonClicked()
 
 		connect(buttons, SIGNAL(accepted()), statsDialog, SLOT(accept()));
 
-		QTableWidget *table = new QTableWidget(statsDialog);
-		table->verticalHeader()->hide();
-		table->horizontalHeader()->hide();
-		table->setRowCount(6);
-		table->setColumnCount(2);
-
-		unsigned int width = 0;
-		unsigned int height = 0;
-
-		QTableWidgetItem *item;
-
-		item = new QTableWidgetItem(tr("Last path calculation:"));
-		table->setItem(0, 0, item);
+		std::vector<Stats::TimerSummary> timers = stats_->timers();
+		std::vector<Stats::CounterSummary> counters = stats_->counters();
 
-		item = new QTableWidgetItem(secondsString(stats_->lastPathCalculation));
-		table->setItem(0, 1, item);
+		QTableWidget *timerTable = new QTableWidget(timers.size(), 7, statsDialog);
+		timerTable->setHorizontalHeaderLabels(QStringList() << tr("Timer") << tr("Samples") << tr("Last")
+		                                      << tr("Min") << tr("Avg") << tr("p50") << tr("p99"));
 
-		item = new QTableWidgetItem(tr("Last path collision calculation:"));
-		table->setItem(1, 0, item);
+		for (std::size_t i = 0; i < timers.size(); i++) {
+			Stats::TimerSummary const &timer = timers[i];
 
-		item = new QTableWidgetItem(secondsString(stats_->lastPathCollisionCalculation));
-		table->setItem(1, 1, item);
-
-		item = new QTableWidgetItem(tr("Last Catmull Rom calculation:"));
-		table->setItem(2, 0, item);
-
-		item = new QTableWidgetItem(secondsString(stats_->lastCatmullRomCalculation));
-		table->setItem(2, 1, item);
+			timerTable->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(timer.name)));
+			timerTable->setItem(i, 1, new QTableWidgetItem(QString::number(timer.samples)));
+			timerTable->setItem(i, 2, new QTableWidgetItem(durationString(timer.last)));
+			timerTable->setItem(i, 3, new QTableWidgetItem(durationString(timer.min)));
+			timerTable->setItem(i, 4, new QTableWidgetItem(durationString(timer.avg)));
+			timerTable->setItem(i, 5, new QTableWidgetItem(durationString(timer.p50)));
+			timerTable->setItem(i, 6, new QTableWidgetItem(durationString(timer.p99)));
+		}
 
-		item = new QTableWidgetItem(tr("Last random placement of waypoints:"));
-		table->setItem(3, 0, item);
+		fillTable(timerTable);
 
-		item = new QTableWidgetItem(secondsString(stats_->lastSetNodes));
-		table->setItem(3, 1, item);
+		QTableWidget *counterTable = new QTableWidget(counters.size(), 2, statsDialog);
+		counterTable->setHorizontalHeaderLabels(QStringList() << tr("Counter") << tr("Value"));
 
-		item = new QTableWidgetItem(tr("Last room triangulation calculation:"));
-		table->setItem(4, 0, item);
+		for (std::size_t i = 0; i < counters.size(); i++) {
+			counterTable->setItem(i, 0, new QTableWidgetItem(QString::fromStdString(counters[i].name)));
+			counterTable->setItem(i, 1, new QTableWidgetItem(QString::number(counters[i].value)));
+		}
 
-		item = new QTableWidgetItem(secondsString(stats_->lastRoomTriangulationCalculation));
-		table->setItem(4, 1, item);
+		fillTable(counterTable);
 
-		item = new QTableWidgetItem(tr("Last used algorithm:"));
-		table->setItem(5, 0, item);
+		QPushButton *exportButton = buttons->addButton(tr("Export..."), QDialogButtonBox::ActionRole);
+		connect(exportButton, SIGNAL(clicked()), this, SLOT(wantsStatsExported()));
 
-		item = new QTableWidgetItem(stats_->lastUsedAlgorithm == Room::Dijkstra ? "Dijkstra" : "A*");
-		table->setItem(5, 1, item);
+		unsigned int width = 0;
+		unsigned int height = 0;
 
-		table->setEditTriggers(QAbstractItemView::NoEditTriggers);
-		table->resizeRowsToContents();
-		table->resizeColumnsToContents();
+		for (int i = 0; i < timerTable->rowCount(); i++) {
+			height += timerTable->rowHeight(i);
+		}
 
-		for (int i = 0; i < table->rowCount(); i++) {
-			height += table->rowHeight(i);
+		for (int i = 0; i < counterTable->rowCount(); i++) {
+			height += counterTable->rowHeight(i);
 		}
 
-		for (int j = 0; j < table->columnCount(); j++) {
-			width += table->columnWidth(j);
+		for (int j = 0; j < timerTable->columnCount(); j++) {
+			width += timerTable->columnWidth(j);
 		}
 
-		layout->addWidget(table);
+		layout->addWidget(timerTable);
+		layout->addWidget(counterTable);
 		layout->addWidget(buttons);
 
-		statsDialog->setMinimumSize(width + 30, height + 120);
+		statsDialog->setMinimumSize(width + 30, height + 180);
 		statsDialog->exec();
 		delete statsDialog;
 
 	}
 }
 
+void CentralWidget::wantsStatsExported()
+{
+	QString filename = QFileDialog::getSaveFileName(this, tr("Export statistics"), "", "JSON files (*.json);;CSV files (*.csv)");
+
+	if (filename.length() == 0) {
+		return;
+	}
+
+	std::string contents = filename.endsWith(".csv") ? stats_->toCsv() : stats_->toJson();
+	QSaveFile saveFile(filename);
+
+	if (!saveFile.open(QIODevice::WriteOnly | QIODevice::Text) ||
+	    saveFile.write(contents.data(), contents.size()) != static_cast<qint64>(contents.size()) ||
+	    !saveFile.commit()) {
+		statusText_->setText(tr("Statistics could not be exported: %1").arg(saveFile.errorString()));
+	}
+}
+
+void CentralWidget::wantsTraceRecorded(bool enabled)
+{
+	setTracingEnabled(enabled);
+}
+
+void CentralWidget::wantsTraceSaved()
+{
+	QString filename = QFileDialog::getSaveFileName(this, tr("Save trace"), "", "Chrome trace files (*.json)");
+
+	if (filename.length() == 0) {
+		return;
+	}
+
+	if (!writeTrace(filename.toStdString())) {
+		statusText_->setText(tr("The trace could not be saved."));
+	}
+}
+
 void CentralWidget::amountOfNodesChanged()
 {
 	if (!drawing_) {
@@ -548,6 +659,9 @@ void CentralWidget::removeRoom()
 
 void CentralWidget::createDrawWidget()
 {
+	connect(drawing_, SIGNAL(stageReached(int)), this, SLOT(roomStageReached(int)));
+	roomStageReached(drawing_->stage());
+
 	drawWidget_ = new DrawWidget(drawing_, this);
 	amountField_->setText(QString::number(drawing_->countWaypoints()));
 	connect(drawWidget_, SIGNAL(mouseClicked()), this, SLOT(sceneCouldChange()));
@@ -563,7 +677,32 @@ void CentralWidget::createDrawWidget()
 	boxShowWay_->setCheckState(drawing_->getOption(Drawing::ShowWaypoints) ? Qt::Checked : Qt::Unchecked);
 	boxShowPath_->setCheckState(drawing_->getOption(Drawing::ShowPath) ? Qt::Checked : Qt::Unchecked);
 	boxShowNeighbours_->setCheckState(drawing_->getOption(Drawing::ShowNeighbours) ? Qt::Checked : Qt::Unchecked);
-	boxAlgorithms_->setCurrentIndex(drawing_->getAlgorithm() == Room::Dijkstra ? 0 : 1);
+	boxAlgorithms_->setCurrentIndex(drawing_->getAlgorithm());
+	boxLazy_->setCheckState(drawing_->getLazyValidation() ? Qt::Checked : Qt::Unchecked);
+}
+
+void CentralWidget::roomStageReached(int stage)
+{
+	// the room is shown at once, the controls need the finished preprocessing
+	bool ready = stage == Room::StageReady;
+
+	amountField_->setEnabled(ready);
+	boxAdd_->setEnabled(ready);
+	boxDel_->setEnabled(ready);
+	boxStart_->setEnabled(ready);
+	boxEnd_->setEnabled(ready);
+	boxShowTri_->setEnabled(ready);
+	boxShowRoomTri_->setEnabled(stage >= Room::StageTriangulated);
+	boxShowWay_->setEnabled(ready);
+	boxShowPath_->setEnabled(ready);
+	boxShowNeighbours_->setEnabled(ready);
+	boxAlgorithms_->setEnabled(ready);
+	boxLazy_->setEnabled(ready);
+	buttonAnimate_->setEnabled(ready);
+
+	if (ready) {
+		amountField_->setText(QString::number(drawing_->countWaypoints()));
+	}
 }
 
 void CentralWidget::createNewDrawing()
@@ -601,6 +740,8 @@ bool CentralWidget::checkBoxEvent(QObject *object, QEvent *event)
 		showText = "Show the generated path (if possible) and collisions with red markers (if any).";
 	} else if (sender == boxShowNeighbours_) {
 		showText = "Show the neighbours of a waypoint (or startpoint and endpoint). Click on a point and green edges are reachable while red ones are not.";
+	} else if (sender == boxLazy_) {
+		showText = "Search the unchecked roadmap and only check the edges of the found path for collisions. Colliding edges are removed and the search is repeated.";
 	}
 
 	if (!showText.empty()) {
@@ -47,13 +47,20 @@ private Q_SLOTS:
 	void wantsRoomLoaded();
 	void wantsProjectLoaded();
 	void wantsProjectSaved();
+	void wantsStatsExported();
+	void wantsTraceRecorded(bool enabled);
+	void wantsTraceSaved();
 	void checkBoxChanged(int state);
 	void buttonClicked();
 	void amountOfNodesChanged();
 	void sceneCouldChange();
+	void roomStageReached(int stage);
 
 private:
 	void removeRoom();
+	// both return an error description, empty on success
+	QString loadXmlProject(QString const &filename);
+	QString loadBinaryProject(QString const &filename);
 	void createDrawWidget();
 	void createNewDrawing();
 	bool checkBoxEvent(QObject *object, QEvent *event);
@@ -72,6 +79,7 @@ private:
 	QCheckBox *boxShowPath_;
 	QCheckBox *boxShowNeighbours_;
 	QComboBox *boxAlgorithms_;
+	QCheckBox *boxLazy_;
 	QPushButton *buttonAnimate_;
 	QPushButton *buttonStats_;
 	QTextEdit *statusText_;